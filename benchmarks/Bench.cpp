@@ -0,0 +1,371 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <vector>
+
+#include "Kedarium/Core.hpp"
+#include "Kedarium/File.hpp"
+#include "Kedarium/Graphics.hpp"
+#include "Kedarium/Color.hpp"
+#include "Kedarium/Window.hpp"
+#include "Kedarium/Space.hpp"
+#include "Kedarium/Camera.hpp"
+#include "Kedarium/Transform.hpp"
+
+// Bench Settings
+constexpr unsigned int BENCH_WIDTH        {640};
+constexpr unsigned int BENCH_HEIGHT       {360};
+constexpr int          BENCH_SAMPLE_COUNT {5};
+const    std::string   BENCH_TITLE        {"Kedarium Bench"};
+
+// Scene Vertices and Indices
+GLfloat vertices[] = {
+  -0.5f, -0.5f, 0.f, 1.f, 1.f, 1.f,
+   0.5f, -0.5f, 0.f, 1.f, 1.f, 1.f,
+  -0.5f,  0.5f, 0.f, 1.f, 1.f, 1.f,
+   0.5f,  0.5f, 0.f, 1.f, 1.f, 1.f,
+};
+GLuint indices[] = {
+  1, 0, 3,
+  2, 3, 0,
+};
+
+struct BenchResult
+{
+  std::string name;
+  uint64_t    iterations;
+  double      nsPerOp;
+  double      minNsPerOp;
+};
+
+std::vector<BenchResult> results;
+
+// Keeps the compiler from discarding the benchmarked work
+volatile float sink {0.f};
+
+/**
+ * Times a benchmark body over several samples and records the median and fastest time per operation.
+ *
+ * @param name       The name of the benchmark.
+ * @param iterations The number of operations per sample.
+ * @param body       The function performing one operation, receiving its iteration index.
+ * @param finish     An optional function run at the end of each sample, e.g. to wait for the GPU.
+ */
+void runBench(
+  const std::string& name,
+  const uint64_t iterations,
+  const std::function<void(uint64_t)>& body,
+  const std::function<void()>& finish = nullptr
+)
+{
+  // Warming caches and driver paths up before measuring
+  for (uint64_t i = 0; i < std::min<uint64_t>(iterations, 16); i++) body(i);
+  if (finish) finish();
+
+  std::vector<double> samples;
+  for (int s = 0; s < BENCH_SAMPLE_COUNT; s++)
+  {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) body(i);
+    if (finish) finish();
+    const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    samples.push_back(elapsed / iterations);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  results.push_back({name, iterations, samples[samples.size() / 2], samples[0]});
+  std::cerr << name << ": " << samples[samples.size() / 2] << " ns/op\n";
+}
+
+void benchSpace()
+{
+  kdr::Space::Mat4 a = kdr::Space::compose({1.f, 2.f, 3.f}, {10.f, 20.f, 30.f}, {1.f, 1.f, 1.f});
+  kdr::Space::Mat4 b = kdr::Space::perspective(kdr::Space::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+
+  runBench("space/mat4_multiply", 1000000, [&](uint64_t i)
+  {
+    a[3][0] = (float)i;
+    sink = sink + (a * b)[3][3];
+  });
+
+  std::vector<kdr::Space::Mat4> lhs(1024, a);
+  std::vector<kdr::Space::Mat4> rhs(1024, b);
+  std::vector<kdr::Space::Mat4> out(1024);
+  runBench("space/mat4_multiply_many_1024", 2000, [&](uint64_t)
+  {
+    kdr::Space::multiplyMany(lhs.data(), rhs.data(), out.data(), out.size());
+    sink = sink + out[1023][3][3];
+  });
+
+  runBench("space/look_at", 1000000, [&](uint64_t i)
+  {
+    const kdr::Space::Vec3 eye {(float)(i & 255), 1.f, 5.f};
+    sink = sink + kdr::Space::lookAt(eye, {0.f, 0.f, 0.f}, {0.f, 1.f, 0.f})[3][2];
+  });
+
+  runBench("space/perspective", 1000000, [&](uint64_t i)
+  {
+    sink = sink + kdr::Space::perspective(0.5f + (i & 255) * 1e-3f, 16.f / 9.f, 0.1f, 100.f)[1][1];
+  });
+
+  runBench("space/normalize", 1000000, [&](uint64_t i)
+  {
+    sink = sink + kdr::Space::normalize({(float)(i & 255) + 1.f, 2.f, 3.f}).x;
+  });
+
+  runBench("space/compose", 1000000, [&](uint64_t i)
+  {
+    sink = sink + kdr::Space::compose({(float)(i & 255), 0.f, 0.f}, {0.f, 45.f, 0.f}, {2.f, 2.f, 2.f})[3][0];
+  });
+
+  std::vector<kdr::Space::Vec3> points(4096, kdr::Space::Vec3(1.f, 2.f, 3.f));
+  std::vector<kdr::Space::Vec3> transformed(4096);
+  runBench("space/transform_points_4096", 2000, [&](uint64_t)
+  {
+    kdr::Space::transformPoints(a, points.data(), transformed.data(), points.size());
+    sink = sink + transformed[4095].z;
+  });
+}
+
+class BenchWindow : public kdr::Window
+{
+  public:
+    using kdr::Window::Window;
+
+    ~BenchWindow()
+    {
+      // Nothing was created if the window never got a context
+      if (instancedShader == NULL) return;
+
+      VAO1->Delete();
+      VBO1->Delete();
+      EBO1->Delete();
+      instances->Delete();
+      instancedShader->Delete();
+      delete VAO1;
+      delete VBO1;
+      delete EBO1;
+      delete instances;
+      delete instancedShader;
+    }
+
+    /**
+     * Fills the scene with a grid of spinning quads.
+     *
+     * @param objectCount The number of objects in the scene.
+     */
+    void setObjectCount(const size_t objectCount)
+    {
+      transforms.clear();
+      transforms.reserve(objectCount);
+      colors.clear();
+
+      const size_t side = (size_t)std::max(1.0, std::ceil(std::sqrt((double)objectCount)));
+      for (size_t i = 0; i < objectCount; i++)
+      {
+        const float x = (float)(i % side) - side * 0.5f;
+        const float y = (float)(i / side) - side * 0.5f;
+        transforms.create({x, y, -(float)side}, {0.f, 0.f, 0.f}, {0.8f, 0.8f, 0.8f});
+        colors.push_back({(uint8_t)(i % 3 * 127), (uint8_t)(i % 5 * 63), (uint8_t)(i % 7 * 42), 1.f});
+      }
+    }
+
+    /**
+     * Creates the scene's GL objects. Only called once the window has a context.
+     */
+    void setup()
+    {
+      instancedShader = new kdr::Graphics::Shader("resources/Shaders/instanced.vert", "resources/Shaders/default.frag");
+      VAO1 = new kdr::Graphics::VAO();
+      VBO1 = new kdr::Graphics::VBO(vertices, sizeof(vertices));
+      EBO1 = new kdr::Graphics::EBO(indices, sizeof(indices));
+      instances = new kdr::Graphics::InstanceBuffer();
+
+      VAO1->Bind();
+      VBO1->Bind();
+      EBO1->Bind();
+
+      VAO1->LinkAtrib(*VBO1, 0, 3, GL_FLOAT, 6 * sizeof(GLfloat), (void*)0);
+      VAO1->LinkAtrib(*VBO1, 1, 3, GL_FLOAT, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+      instances->Link(*VAO1, 2);
+
+      VAO1->Unbind();
+      VBO1->Unbind();
+    }
+
+  protected:
+    void update()
+    {
+      // Fixed increments keep the per-frame work identical between runs
+      angle += 1.f;
+      for (uint32_t id = 0; id < transforms.getSize(); id++)
+      {
+        transforms.setRotation(id, {0.f, 0.f, angle + id});
+      }
+      transforms.update();
+      instances->Update(transforms.getWorldMatrices(), colors.data(), (GLsizei)transforms.getSize());
+    }
+
+    void render()
+    {
+      instancedShader->Use();
+      VAO1->Bind();
+      instances->DrawElements(GL_TRIANGLES, sizeof(indices) / sizeof(GLuint));
+    }
+
+  private:
+    // Created in setup(), so that a failed context never reaches GL
+    kdr::Graphics::Shader*         instancedShader {NULL};
+    kdr::Graphics::VAO*            VAO1            {NULL};
+    kdr::Graphics::VBO*            VBO1            {NULL};
+    kdr::Graphics::EBO*            EBO1            {NULL};
+    kdr::Graphics::InstanceBuffer* instances       {NULL};
+
+    kdr::Space::TransformStore     transforms;
+    std::vector<kdr::Color::RGBA> colors;
+    float                         angle {0.f};
+};
+
+void benchGraphics(BenchWindow& window, const size_t objectCount, const unsigned int frameCount)
+{
+  const std::function<void()> finish = []() { glFinish(); };
+
+  std::vector<char> blob(64 * 1024, 1);
+  runBench("gl/vbo_create_delete_64k", 500, [&](uint64_t)
+  {
+    kdr::Graphics::VBO VBO {(GLfloat*)blob.data(), (GLsizeiptr)blob.size()};
+    VBO.Delete();
+  }, finish);
+
+  runBench("gl/ebo_create_delete_64k", 500, [&](uint64_t)
+  {
+    kdr::Graphics::EBO EBO {(GLuint*)blob.data(), (GLsizeiptr)blob.size()};
+    EBO.Delete();
+  }, finish);
+
+  kdr::Graphics::VBO dynamicVBO {(GLfloat*)blob.data(), (GLsizeiptr)blob.size(), GL_DYNAMIC_DRAW};
+  runBench("gl/vbo_update_64k", 500, [&](uint64_t)
+  {
+    dynamicVBO.Update(blob.data(), (GLsizeiptr)blob.size());
+  }, finish);
+  dynamicVBO.Delete();
+
+  kdr::Graphics::StreamBuffer stream {GL_ARRAY_BUFFER, 8 * (GLsizeiptr)blob.size()};
+  runBench("gl/stream_write_8x64k", 200, [&](uint64_t)
+  {
+    stream.BeginFrame();
+    for (int i = 0; i < 8; i++) stream.Write(blob.data(), (GLsizeiptr)blob.size());
+    stream.EndFrame();
+  }, finish);
+  stream.Delete();
+
+  runBench("gl/shader_create", 20, [&](uint64_t)
+  {
+    kdr::Graphics::Shader shader {"resources/Shaders/default.vert", "resources/Shaders/default.frag"};
+    shader.Delete();
+  }, finish);
+
+  // Whole frames of the synthetic scene: transform update, instance upload and draw
+  window.setObjectCount(objectCount);
+  window.setFrameLimit(frameCount);
+  runBench("scene/instanced_frame_" + std::to_string(objectCount), 1, [&](uint64_t)
+  {
+    window.loop();
+  }, finish);
+  results.back().iterations = frameCount;
+  results.back().nsPerOp /= frameCount;
+  results.back().minNsPerOp /= frameCount;
+}
+
+std::string toJson(const std::string& renderer)
+{
+  std::ostringstream json;
+  json << "{\n";
+  json << "  \"simd\": \"" << kdr::Space::getSimdPath() << "\",\n";
+  json << "  \"renderer\": \"" << renderer << "\",\n";
+  json << "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    json << "    {\"name\": \"" << results[i].name << "\""
+         << ", \"iterations\": " << results[i].iterations
+         << ", \"ns_per_op\": " << results[i].nsPerOp
+         << ", \"min_ns_per_op\": " << results[i].minNsPerOp << "}"
+         << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  json << "  ]\n";
+  json << "}\n";
+  return json.str();
+}
+
+int main(int argc, char** argv)
+{
+  std::string  outputPath;
+  size_t       objectCount {10000};
+  unsigned int frameCount  {300};
+  bool         isGLEnabled {true};
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+    {
+      outputPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc)
+    {
+      objectCount = std::stoul(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+    {
+      frameCount = std::stoul(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--no-gl") == 0)
+    {
+      isGLEnabled = false;
+    }
+    else
+    {
+      std::cerr << "Usage: kedarium_bench [--output file.json] [--objects N] [--frames N] [--no-gl]\n";
+      return 1;
+    }
+  }
+
+  benchSpace();
+
+  std::string renderer {"none"};
+  if (isGLEnabled)
+  {
+    BenchWindow window {kdr::WindowProps(BENCH_WIDTH, BENCH_HEIGHT, BENCH_TITLE, true)};
+    if (window.getGlfwWindow() == NULL)
+    {
+      std::cerr << "Failed to create a headless context, skipping the graphics benchmarks!\n";
+    }
+    else
+    {
+      renderer = (const char*)glGetString(GL_RENDERER);
+
+      kdr::Camera camera {{60.f, (float)BENCH_WIDTH / BENCH_HEIGHT, 0.1f, 1000.f, 0.f, 0.f}};
+      window.setBoundCamera(&camera);
+      window.setup();
+
+      benchGraphics(window, objectCount, frameCount);
+    }
+  }
+
+  const std::string json = toJson(renderer);
+  if (outputPath.empty())
+  {
+    std::cout << json;
+  }
+  else if (!kdr::File::writeContents(outputPath.c_str(), json.data(), json.size()))
+  {
+    return 1;
+  }
+  return 0;
+}
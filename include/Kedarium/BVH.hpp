@@ -0,0 +1,125 @@
+#ifndef KDR_BVH_HPP
+#define KDR_BVH_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "Space.hpp"
+#include "Bounds.hpp"
+
+namespace kdr
+{
+  namespace Space
+  {
+    /**
+     * Bounding volume hierarchy over object bounds, used to find the objects inside a frustum.
+     *
+     * Leaf bounds are stored as structure-of-arrays in traversal order, so leaves are tested
+     * four boxes at a time. Subtrees fully inside the frustum are accepted without further tests.
+     */
+    class BVH
+    {
+      public:
+        /**
+         * Retrieves the number of objects in the hierarchy.
+         *
+         * @return The number of objects.
+         */
+        const size_t getObjectCount() const
+        { return this->objectIDs.size(); }
+        /**
+         * Retrieves the number of nodes in the hierarchy.
+         *
+         * @return The number of nodes.
+         */
+        const size_t getNodeCount() const
+        { return this->nodes.size(); }
+        /**
+         * Retrieves the number of nodes and boxes tested by the last cull().
+         *
+         * @return The number of tests.
+         */
+        const size_t getTestCount() const
+        { return this->testCount; }
+
+        /**
+         * Builds the hierarchy from scratch.
+         *
+         * @param bounds The world bounds of every object. Object IDs are indices into this array.
+         */
+        void build(const std::vector<kdr::Space::AABB>& bounds);
+        /**
+         * Updates the bounds of moved objects without changing the tree structure.
+         * Cheaper than build(), but the tree degrades when objects move far.
+         *
+         * @param bounds The world bounds of every object, in the order passed to build().
+         */
+        void refit(const std::vector<kdr::Space::AABB>& bounds);
+        /**
+         * Collects the objects whose bounds are at least partially inside a frustum.
+         *
+         * @param frustum The view frustum.
+         * @param visible Receives the IDs of the visible objects. Cleared first.
+         */
+        void cull(const kdr::Space::Frustum& frustum, std::vector<uint32_t>& visible);
+
+      private:
+        struct Node
+        {
+          kdr::Space::AABB bounds;
+          uint32_t         first {0}; // First object of a leaf, or the left child of an inner node
+          uint32_t         count {0}; // Number of objects of a leaf, 0 for inner nodes
+        };
+
+        std::vector<Node>     nodes;
+        std::vector<uint32_t> objectIDs;
+
+        // Leaf bounds in traversal order, padded to a multiple of four
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+
+        size_t testCount {0};
+
+        /**
+         * Splits a range of objects into a subtree.
+         *
+         * @param nodeIndex The node covering the range.
+         * @param first     The first object of the range.
+         * @param count     The number of objects in the range.
+         * @param bounds    The object bounds.
+         * @param centroids The object centroids.
+         */
+        void _split(
+          const uint32_t nodeIndex,
+          const uint32_t first,
+          const uint32_t count,
+          const std::vector<kdr::Space::AABB>& bounds,
+          const std::vector<kdr::Space::Vec3>& centroids
+        );
+        /**
+         * Copies object bounds into the structure-of-arrays leaf storage.
+         *
+         * @param bounds The object bounds.
+         */
+        void _storeLeafBounds(const std::vector<kdr::Space::AABB>& bounds);
+        /**
+         * Appends every object of a subtree.
+         *
+         * @param nodeIndex The root of the subtree.
+         * @param visible   The visible object IDs.
+         */
+        void _appendSubtree(const uint32_t nodeIndex, std::vector<uint32_t>& visible);
+        /**
+         * Tests the objects of a leaf against the planes still intersecting it.
+         *
+         * @param node      The leaf.
+         * @param frustum   The view frustum.
+         * @param planeMask The planes to test against, one bit per plane.
+         * @param visible   The visible object IDs.
+         */
+        void _cullLeaf(const Node& node, const kdr::Space::Frustum& frustum, const uint32_t planeMask, std::vector<uint32_t>& visible);
+    };
+  }
+}
+
+#endif // KDR_BVH_HPP
@@ -0,0 +1,166 @@
+#ifndef KDR_BOUNDS_HPP
+#define KDR_BOUNDS_HPP
+
+#include <math.h>
+
+#include "Space.hpp"
+
+namespace kdr
+{
+  namespace Space
+  {
+    /**
+     * Represents a plane as a unit normal and a signed distance from the origin.
+     * Points with dot(normal, point) + distance >= 0 are in front of the plane.
+     */
+    struct Plane
+    {
+      kdr::Space::Vec3 normal;
+      float            distance {0.f};
+
+      /**
+       * Calculates the signed distance of a point to the plane.
+       *
+       * @param point The point.
+       * @return The signed distance, positive in front of the plane.
+       */
+      const float getDistance(const kdr::Space::Vec3& point) const
+      { return normal.x * point.x + normal.y * point.y + normal.z * point.z + distance; }
+    };
+
+    /**
+     * Represents an axis-aligned bounding box.
+     */
+    struct AABB
+    {
+      kdr::Space::Vec3 min;
+      kdr::Space::Vec3 max;
+
+      /**
+       * Constructs an empty (inverted) bounding box that grows to fit the first point added.
+       */
+      AABB()
+      : min(INFINITY), max(-INFINITY)
+      {}
+      /**
+       * Constructs a bounding box from its corners.
+       *
+       * @param min The minimum corner.
+       * @param max The maximum corner.
+       */
+      AABB(const kdr::Space::Vec3& min, const kdr::Space::Vec3& max)
+      : min(min), max(max)
+      {}
+
+      /**
+       * Retrieves the center of the box.
+       *
+       * @return The center point.
+       */
+      const kdr::Space::Vec3 getCenter() const
+      { return (min + max) * 0.5f; }
+      /**
+       * Retrieves the half size of the box along each axis.
+       *
+       * @return The half extents.
+       */
+      const kdr::Space::Vec3 getExtents() const
+      { return (max - min) * 0.5f; }
+      /**
+       * Checks whether the box contains anything.
+       *
+       * @return True if every minimum is at most the matching maximum, false otherwise.
+       */
+      const bool getIsValid() const
+      { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+      /**
+       * Grows the box to contain a point.
+       *
+       * @param point The point.
+       */
+      void expand(const kdr::Space::Vec3& point)
+      {
+        min = kdr::Space::Vec3(fminf(min.x, point.x), fminf(min.y, point.y), fminf(min.z, point.z));
+        max = kdr::Space::Vec3(fmaxf(max.x, point.x), fmaxf(max.y, point.y), fmaxf(max.z, point.z));
+      }
+      /**
+       * Grows the box to contain another box.
+       *
+       * @param other The other box.
+       */
+      void expand(const kdr::Space::AABB& other)
+      {
+        min = kdr::Space::Vec3(fminf(min.x, other.min.x), fminf(min.y, other.min.y), fminf(min.z, other.min.z));
+        max = kdr::Space::Vec3(fmaxf(max.x, other.max.x), fmaxf(max.y, other.max.y), fmaxf(max.z, other.max.z));
+      }
+    };
+
+    /**
+     * Represents a bounding sphere.
+     */
+    struct Sphere
+    {
+      kdr::Space::Vec3 center;
+      float            radius {0.f};
+    };
+
+    /**
+     * Represents the six planes of a view volume, pointing inwards.
+     */
+    class Frustum
+    {
+      public:
+        enum PlaneIndex
+        {
+          Left,
+          Right,
+          Bottom,
+          Top,
+          Near,
+          Far,
+          PlaneCount
+        };
+
+        kdr::Space::Plane planes[PlaneCount];
+
+        /**
+         * Constructs a frustum that contains everything.
+         */
+        Frustum()
+        {}
+        /**
+         * Extracts the frustum planes of a projection * view matrix.
+         *
+         * @param viewProjection The camera matrix mapping world space to clip space.
+         */
+        Frustum(const kdr::Space::Mat4& viewProjection);
+
+        /**
+         * Checks whether a sphere is at least partially inside the frustum.
+         *
+         * @param sphere The bounding sphere.
+         * @return True if the sphere may be visible, false if it is fully outside.
+         */
+        const bool intersects(const kdr::Space::Sphere& sphere) const;
+        /**
+         * Checks whether a box is at least partially inside the frustum.
+         *
+         * @param box The bounding box.
+         * @return True if the box may be visible, false if it is fully outside.
+         */
+        const bool intersects(const kdr::Space::AABB& box) const;
+    };
+
+    /**
+     * Calculates the world bounds of a box transformed by a matrix.
+     *
+     * @param box The box in local space.
+     * @param mat The transformation matrix.
+     * @return The smallest axis-aligned box containing the transformed box.
+     */
+    kdr::Space::AABB transformBounds(const kdr::Space::AABB& box, const kdr::Space::Mat4& mat);
+  }
+}
+
+#endif // KDR_BOUNDS_HPP
@@ -7,6 +7,8 @@
 
 #include "Keys.hpp"
 #include "Space.hpp"
+#include "Bounds.hpp"
+#include "Graphics.hpp"
 
 namespace kdr
 {
@@ -31,6 +33,17 @@ namespace kdr
   };
   
 
+  /**
+   * Mirrors the std140 layout of the shared "Camera" uniform block.
+   */
+  struct CameraBlock
+  {
+    kdr::Space::Mat4 matrix;
+    kdr::Space::Mat4 view;
+    kdr::Space::Mat4 projection;
+    float            position[4];
+  };
+
   class Camera
   {
     public:
@@ -57,6 +70,33 @@ namespace kdr
        */
       const kdr::Space::Mat4 getMatrix() const
       { return this->matrix; }
+      /**
+       * Retrieves the view matrix of the camera.
+       *
+       * @return The view matrix of the camera.
+       */
+      const kdr::Space::Mat4& getViewMatrix() const
+      { return this->view; }
+      /**
+       * Retrieves the projection matrix of the camera.
+       *
+       * @return The projection matrix of the camera.
+       */
+      const kdr::Space::Mat4& getProjectionMatrix() const
+      { return this->projection; }
+      /**
+       * Retrieves the view frustum of the camera, as of the last updateMatrix().
+       *
+       * @return The world-space frustum planes.
+       */
+      const kdr::Space::Frustum getFrustum() const
+      { return kdr::Space::Frustum(this->matrix); }
+      /**
+       * Retrieves the camera data in the layout of the shared "Camera" uniform block.
+       *
+       * @return The camera uniform block contents.
+       */
+      const kdr::CameraBlock getBlock() const;
       /**
        * Retrieves the field of view of the camera.
        *
@@ -140,12 +180,21 @@ namespace kdr
        * @param uniformName The name of the uniform variable in the shader.
        */
       void applyMatrix(const GLuint shaderID, const char* uniformName);
+      /**
+       * Applies the camera matrix to a shader uniform using the shader's cached uniform location.
+       *
+       * @param shader      The shader program. It must be the program in use.
+       * @param uniformName The name of the uniform variable in the shader.
+       */
+      void applyMatrix(const kdr::Graphics::Shader& shader, const std::string& uniformName);
 
     private:
       kdr::Space::Vec3 position {0.f, 0.f,  3.f};
       kdr::Space::Vec3 front    {0.f, 0.f, -1.f};
       kdr::Space::Vec3 up       {0.f, 1.f,  0.f};
-      kdr::Space::Mat4 matrix   {1.f};
+      kdr::Space::Mat4 matrix     {1.f};
+      kdr::Space::Mat4 view       {1.f};
+      kdr::Space::Mat4 projection {1.f};
 
       float fov         {60.f};
       float aspect      {1.f};
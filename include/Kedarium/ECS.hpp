@@ -0,0 +1,505 @@
+#ifndef KDR_ECS_HPP
+#define KDR_ECS_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Space.hpp"
+#include "Bounds.hpp"
+#include "Jobs.hpp"
+#include "Renderer.hpp"
+#include "MeshPool.hpp"
+
+namespace kdr
+{
+  namespace ECS
+  {
+    /**
+     * Identifies an entity. The low 20 bits are its index, the high 12 bits count how many times
+     * the index was reused, so handles of destroyed entities never refer to their successors.
+     */
+    typedef uint32_t Entity;
+    /**
+     * Entity value that never refers to a live entity.
+     */
+    const kdr::ECS::Entity nullEntity {0xFFFFFFFF};
+
+    /**
+     * Number of bits of an entity holding its index.
+     */
+    constexpr uint32_t entityIndexBits {20};
+    /**
+     * Mask extracting the index of an entity.
+     */
+    constexpr uint32_t entityIndexMask {(1u << entityIndexBits) - 1};
+
+    /**
+     * Retrieves the index of an entity, which addresses the sparse arrays of component pools.
+     *
+     * @param entity The entity.
+     * @return The entity index.
+     */
+    inline uint32_t getEntityIndex(const kdr::ECS::Entity entity)
+    { return entity & kdr::ECS::entityIndexMask; }
+
+    /**
+     * Hands out a unique number per call, used to number component types.
+     *
+     * @return The next component type ID.
+     */
+    uint32_t nextComponentID();
+    /**
+     * Retrieves the ID of a component type, assigned on first use.
+     *
+     * @return The component type ID.
+     */
+    template <typename T>
+    uint32_t getComponentID()
+    {
+      static const uint32_t ID = kdr::ECS::nextComponentID();
+      return ID;
+    }
+
+    /**
+     * Type-erased interface of a component pool, so entities can be destroyed without knowing
+     * their component types.
+     */
+    class PoolBase
+    {
+      public:
+        /**
+         * Virtual destructor for the PoolBase class.
+         */
+        virtual ~PoolBase() {}
+
+        /**
+         * Retrieves the number of components in the pool.
+         *
+         * @return The number of components.
+         */
+        const size_t getSize() const
+        { return this->entities.size(); }
+        /**
+         * Retrieves the entities owning the components, in component order.
+         *
+         * @return The entities of the pool.
+         */
+        const std::vector<kdr::ECS::Entity>& getEntities() const
+        { return this->entities; }
+        /**
+         * Checks whether an entity has a component in the pool.
+         *
+         * @param entity The entity.
+         * @return True if the entity has a component, false otherwise.
+         */
+        const bool getHas(const kdr::ECS::Entity entity) const
+        {
+          const uint32_t index = kdr::ECS::getEntityIndex(entity);
+          return index < this->sparse.size() && this->sparse[index] != Empty && this->entities[this->sparse[index]] == entity;
+        }
+
+        /**
+         * Removes the component of an entity, if it has one.
+         *
+         * @param entity The entity.
+         */
+        virtual void remove(const kdr::ECS::Entity entity) = 0;
+
+      protected:
+        static constexpr uint32_t Empty = 0xFFFFFFFF;
+
+        // Component position of each entity index, and the entity of each component position
+        std::vector<uint32_t>         sparse;
+        std::vector<kdr::ECS::Entity> entities;
+    };
+
+    /**
+     * Stores the components of one type contiguously, in a sparse set keyed by entity.
+     *
+     * Adding and removing are constant time. Removing moves the last component into the hole,
+     * so references and iteration order are invalidated by removals.
+     */
+    template <typename T>
+    class Pool : public kdr::ECS::PoolBase
+    {
+      public:
+        /**
+         * Retrieves the component of an entity.
+         *
+         * @param entity An entity with a component in the pool.
+         * @return A reference to the component.
+         */
+        T& get(const kdr::ECS::Entity entity)
+        { return this->components[this->sparse[kdr::ECS::getEntityIndex(entity)]]; }
+        /**
+         * Retrieves the component of an entity.
+         *
+         * @param entity An entity with a component in the pool.
+         * @return A reference to the component.
+         */
+        const T& get(const kdr::ECS::Entity entity) const
+        { return this->components[this->sparse[kdr::ECS::getEntityIndex(entity)]]; }
+        /**
+         * Retrieves every component of the pool, for linear iteration.
+         *
+         * @return The components, in the order of getEntities().
+         */
+        std::vector<T>& getComponents()
+        { return this->components; }
+
+        /**
+         * Adds a component to an entity, replacing its existing one.
+         *
+         * @param entity    The entity.
+         * @param arguments The arguments to construct the component with.
+         * @return A reference to the component.
+         */
+        template <typename... Args>
+        T& add(const kdr::ECS::Entity entity, Args&&... arguments)
+        {
+          if (this->getHas(entity))
+          {
+            T& component = this->get(entity);
+            component = T{std::forward<Args>(arguments)...};
+            return component;
+          }
+
+          const uint32_t index = kdr::ECS::getEntityIndex(entity);
+          if (index >= this->sparse.size())
+          {
+            this->sparse.resize(index + 1, Empty);
+          }
+          this->sparse[index] = (uint32_t)this->entities.size();
+          this->entities.push_back(entity);
+          this->components.push_back(T{std::forward<Args>(arguments)...});
+          return this->components.back();
+        }
+        /**
+         * Removes the component of an entity, if it has one.
+         *
+         * @param entity The entity.
+         */
+        void remove(const kdr::ECS::Entity entity) override
+        {
+          if (!this->getHas(entity)) return;
+
+          const uint32_t index = kdr::ECS::getEntityIndex(entity);
+          const uint32_t position = this->sparse[index];
+          const uint32_t last = (uint32_t)this->entities.size() - 1;
+          if (position != last)
+          {
+            this->entities[position] = this->entities[last];
+            this->components[position] = std::move(this->components[last]);
+            this->sparse[kdr::ECS::getEntityIndex(this->entities[position])] = position;
+          }
+          this->entities.pop_back();
+          this->components.pop_back();
+          this->sparse[index] = Empty;
+        }
+        /**
+         * Reorders the components, for example by material or depth, so later iteration follows that order.
+         *
+         * @param compare The strict weak ordering of two components.
+         */
+        void sort(const std::function<bool(const T&, const T&)>& compare)
+        {
+          std::vector<uint32_t> order(this->entities.size());
+          for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+          std::sort(order.begin(), order.end(), [this, &compare](const uint32_t a, const uint32_t b)
+          {
+            return compare(this->components[a], this->components[b]);
+          });
+
+          std::vector<T> sortedComponents;
+          std::vector<kdr::ECS::Entity> sortedEntities;
+          sortedComponents.reserve(order.size());
+          sortedEntities.reserve(order.size());
+          for (const uint32_t position : order)
+          {
+            sortedComponents.push_back(std::move(this->components[position]));
+            sortedEntities.push_back(this->entities[position]);
+          }
+          this->components.swap(sortedComponents);
+          this->entities.swap(sortedEntities);
+
+          for (uint32_t position = 0; position < this->entities.size(); position++)
+          {
+            this->sparse[kdr::ECS::getEntityIndex(this->entities[position])] = position;
+          }
+        }
+
+      private:
+        std::vector<T> components;
+    };
+
+    /**
+     * Owns the entities of a scene and their component pools.
+     */
+    class Registry
+    {
+      public:
+        /**
+         * Retrieves the number of live entities.
+         *
+         * @return The number of entities.
+         */
+        const size_t getEntityCount() const
+        { return this->versions.size() - this->freeIndices.size(); }
+        /**
+         * Checks whether an entity is alive.
+         *
+         * @param entity The entity.
+         * @return True if the entity was created and not destroyed since, false otherwise.
+         */
+        const bool getIsAlive(const kdr::ECS::Entity entity) const;
+        /**
+         * Checks whether an entity has a component.
+         *
+         * @param entity The entity.
+         * @return True if the entity has a component of type T, false otherwise.
+         */
+        template <typename T>
+        const bool getHas(const kdr::ECS::Entity entity) const
+        {
+          const uint32_t ID = kdr::ECS::getComponentID<T>();
+          return ID < this->pools.size() && this->pools[ID] && this->pools[ID]->getHas(entity);
+        }
+        /**
+         * Retrieves the component of an entity.
+         *
+         * @param entity An entity with a component of type T.
+         * @return A reference to the component.
+         */
+        template <typename T>
+        T& get(const kdr::ECS::Entity entity)
+        { return this->getPool<T>().get(entity); }
+        /**
+         * Retrieves the pool of a component type, creating it on first use.
+         *
+         * @return A reference to the pool.
+         */
+        template <typename T>
+        kdr::ECS::Pool<T>& getPool()
+        {
+          const uint32_t ID = kdr::ECS::getComponentID<T>();
+          if (ID >= this->pools.size())
+          {
+            this->pools.resize(ID + 1);
+          }
+          if (!this->pools[ID])
+          {
+            this->pools[ID].reset(new kdr::ECS::Pool<T>());
+          }
+          return *static_cast<kdr::ECS::Pool<T>*>(this->pools[ID].get());
+        }
+
+        /**
+         * Creates an entity without components.
+         *
+         * @return The new entity.
+         */
+        kdr::ECS::Entity create();
+        /**
+         * Destroys an entity and removes all of its components.
+         *
+         * @param entity The entity.
+         */
+        void destroy(const kdr::ECS::Entity entity);
+        /**
+         * Adds a component to an entity, replacing its existing one.
+         *
+         * @param entity    The entity.
+         * @param arguments The arguments to construct the component with.
+         * @return A reference to the component.
+         */
+        template <typename T, typename... Args>
+        T& add(const kdr::ECS::Entity entity, Args&&... arguments)
+        { return this->getPool<T>().add(entity, std::forward<Args>(arguments)...); }
+        /**
+         * Removes a component from an entity, if it has one.
+         *
+         * @param entity The entity.
+         */
+        template <typename T>
+        void remove(const kdr::ECS::Entity entity)
+        { this->getPool<T>().remove(entity); }
+
+        /**
+         * Calls a function for every entity having all the given components.
+         *
+         * The smallest of the pools is walked linearly and the others are only probed. Components
+         * must not be added or removed from the visited pools during the walk.
+         *
+         * @param function The function receiving the entity and a reference to each component.
+         */
+        template <typename First, typename... Rest, typename Function>
+        void each(Function function)
+        {
+          const std::vector<kdr::ECS::Entity>& driver = this->_getQueryDriver<First, Rest...>();
+          for (size_t i = 0; i < driver.size(); i++)
+          {
+            const kdr::ECS::Entity entity = driver[i];
+            if (!this->_getHasAll<First, Rest...>(entity)) continue;
+            function(entity, this->get<First>(entity), this->get<Rest>(entity)...);
+          }
+        }
+        /**
+         * Calls a function for every entity having all the given components, spread over the job
+         * scheduler. The function must only touch the components it receives.
+         *
+         * @param grainSize The minimum number of entities per job.
+         * @param function  The function receiving the entity and a reference to each component.
+         */
+        template <typename First, typename... Rest, typename Function>
+        void parallelEach(const size_t grainSize, Function function)
+        {
+          // Fetching the pools up front also creates missing ones, so no job resizes the pool list
+          const std::vector<kdr::ECS::Entity>& driver = this->_getQueryDriver<First, Rest...>();
+          kdr::Jobs::parallelFor(0, driver.size(), grainSize, [this, &driver, &function](const size_t begin, const size_t end)
+          {
+            for (size_t i = begin; i < end; i++)
+            {
+              const kdr::ECS::Entity entity = driver[i];
+              if (!this->_getHasAll<First, Rest...>(entity)) continue;
+              function(entity, this->get<First>(entity), this->get<Rest>(entity)...);
+            }
+          });
+        }
+
+      private:
+        std::vector<uint32_t>                            versions;
+        std::vector<uint32_t>                            freeIndices;
+        std::vector<std::unique_ptr<kdr::ECS::PoolBase>> pools;
+
+        /**
+         * Finds the smallest pool of a query, the cheapest one to walk.
+         *
+         * @return The entities of the smallest pool.
+         */
+        template <typename First, typename... Rest>
+        const std::vector<kdr::ECS::Entity>& _getQueryDriver()
+        {
+          const kdr::ECS::PoolBase* candidates[] = {&this->getPool<First>(), &this->getPool<Rest>()...};
+          const kdr::ECS::PoolBase* smallest = candidates[0];
+          for (const kdr::ECS::PoolBase* candidate : candidates)
+          {
+            if (candidate->getSize() < smallest->getSize()) smallest = candidate;
+          }
+          return smallest->getEntities();
+        }
+        /**
+         * Checks whether an entity has every component of a query.
+         *
+         * @param entity The entity.
+         * @return True if the entity has all the components, false otherwise.
+         */
+        template <typename First, typename... Rest>
+        bool _getHasAll(const kdr::ECS::Entity entity)
+        {
+          const bool has[] = {this->getPool<First>().getHas(entity), this->getPool<Rest>().getHas(entity)...};
+          for (const bool component : has)
+          {
+            if (!component) return false;
+          }
+          return true;
+        }
+    };
+
+    /**
+     * A named function run over a registry once per frame.
+     */
+    struct System
+    {
+      const char*                                     name;
+      std::function<void(kdr::ECS::Registry&, float)> function;
+      bool                                            isEnabled {true};
+    };
+
+    /**
+     * Runs systems over a registry in the order they were added.
+     */
+    class SystemScheduler
+    {
+      public:
+        /**
+         * Retrieves the number of systems.
+         *
+         * @return The number of systems.
+         */
+        const size_t getSystemCount() const
+        { return this->systems.size(); }
+
+        /**
+         * Appends a system to the schedule.
+         *
+         * @param name     The name shown in profiler captures. Must outlive the scheduler, such as a string literal.
+         * @param function The function receiving the registry and the time step in seconds.
+         */
+        void add(const char* name, const std::function<void(kdr::ECS::Registry&, float)>& function);
+        /**
+         * Enables or disables a system without changing its place in the schedule.
+         *
+         * @param name      The name of the system.
+         * @param isEnabled True to run the system, false to skip it.
+         */
+        void setIsEnabled(const char* name, const bool isEnabled);
+        /**
+         * Runs every enabled system in order.
+         *
+         * @param registry  The registry to run the systems over.
+         * @param deltaTime The time step in seconds.
+         */
+        void run(kdr::ECS::Registry& registry, const float deltaTime);
+
+      private:
+        std::vector<kdr::ECS::System> systems;
+    };
+
+    /**
+     * Places an entity in the world. Written by gameplay systems, read by rendering.
+     */
+    struct Transform
+    {
+      kdr::Space::Mat4 matrix {1.f};
+    };
+    /**
+     * Bounds of an entity in world space, used for culling.
+     */
+    struct WorldBounds
+    {
+      kdr::Space::AABB bounds;
+    };
+    /**
+     * Draws an entity as a mesh from a mesh pool.
+     */
+    struct MeshRenderer
+    {
+      kdr::Graphics::Shader*    shader   {NULL};
+      kdr::Graphics::MeshPool*  pool     {NULL};
+      kdr::Graphics::MeshHandle handle   {kdr::Graphics::invalidMesh};
+      uint16_t                  material {0};
+    };
+
+    /**
+     * Submits every entity with a mesh renderer whose world bounds, if it has any, touch the frustum.
+     *
+     * @param registry       The registry.
+     * @param frustum        The view frustum.
+     * @param cameraPosition The world position of the camera, used for the depth of each draw.
+     * @param renderer       The renderer to submit to.
+     * @return The number of submitted entities.
+     */
+    size_t submitVisible(
+      kdr::ECS::Registry& registry,
+      const kdr::Space::Frustum& frustum,
+      const kdr::Space::Vec3& cameraPosition,
+      kdr::Graphics::Renderer& renderer
+    );
+  }
+}
+
+#endif // KDR_ECS_HPP
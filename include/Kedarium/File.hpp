@@ -5,6 +5,7 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace kdr
 {
@@ -18,6 +19,97 @@ namespace kdr
      *         an error message is printed to the standard error stream, and an empty string is returned.
      */
     const std::string getContents(const char* path);
+    /**
+     * Retrieves the raw bytes of a file specified by its path.
+     *
+     * @param path     The path to the file.
+     * @param contents Receives the bytes of the file.
+     * @return True if the file was read, false if it could not be opened.
+     */
+    bool getBinaryContents(const char* path, std::vector<char>& contents);
+    /**
+     * Writes raw bytes to a file, replacing its previous contents.
+     *
+     * @param path The path to the file.
+     * @param data The bytes to write.
+     * @param size The number of bytes to write.
+     * @return True if every byte was written, false otherwise.
+     */
+    bool writeContents(const char* path, const void* data, const size_t size);
+    /**
+     * Reads one byte of every memory page in a range, so the disk reads of a mapped file happen
+     * on the calling thread instead of wherever the bytes are used later.
+     *
+     * @param data The first byte of the range.
+     * @param size The size of the range in bytes.
+     */
+    void touchPages(const void* data, const size_t size);
+
+    /**
+     * Maps a file into memory read-only, so its bytes can be used in place without reading them.
+     * Falls back to reading the whole file where memory mapping is not available.
+     */
+    class MappedFile
+    {
+      public:
+        /**
+         * Constructs a mapped file without a file.
+         */
+        MappedFile() {}
+        /**
+         * Constructs a mapped file and maps a file.
+         *
+         * @param path The path to the file.
+         */
+        MappedFile(const char* path)
+        { this->open(path); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        /**
+         * Unmaps the file.
+         */
+        ~MappedFile()
+        { this->close(); }
+
+        /**
+         * Retrieves the contents of the file.
+         *
+         * @return A pointer to the first byte, or NULL if no file is mapped.
+         */
+        const unsigned char* getData() const
+        { return this->data; }
+        /**
+         * Retrieves the size of the file.
+         *
+         * @return The size in bytes.
+         */
+        const size_t getSize() const
+        { return this->size; }
+        /**
+         * Checks whether a file is mapped.
+         *
+         * @return True if a file is mapped, false otherwise.
+         */
+        const bool getIsOpen() const
+        { return this->data != NULL; }
+
+        /**
+         * Maps a file, unmapping the previous one.
+         *
+         * @param path The path to the file.
+         * @return True if the file was mapped, false otherwise.
+         */
+        bool open(const char* path);
+        /**
+         * Unmaps the file.
+         */
+        void close();
+
+      private:
+        const unsigned char* data {NULL};
+        size_t               size {0};
+        std::vector<char>    fallback;
+    };
   }
 }
 
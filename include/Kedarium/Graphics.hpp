@@ -2,13 +2,39 @@
 #define KDR_GRAPHICS_HPP
 
 #include <GL/glew.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "File.hpp"
+#include "Space.hpp"
+#include "Color.hpp"
+#include "StateCache.hpp"
+#include "Profiler.hpp"
 
 namespace kdr
 {
   namespace Graphics
   {
+    /**
+     * Binding point shared by every program for the per-frame camera uniform block.
+     */
+    const GLuint cameraBlockBinding {0};
+    /**
+     * Name of the per-frame camera uniform block in shader sources.
+     */
+    inline const std::string cameraBlockName {"Camera"};
+
+    /**
+     * Retrieves the location of the legacy cameraMatrix uniform of a program, as reflected when
+     * it was linked.
+     *
+     * @param program The OpenGL ID of the shader program.
+     * @return The location of the uniform, or -1 if the program has no such active uniform.
+     */
+    GLint getCameraMatrixLocation(const GLuint program);
+
     /**
      * Sets the rendering mode to point mode, rendering only the vertices as points.
      */
@@ -22,6 +48,34 @@ namespace kdr
      */
     void useFillmode();
 
+    /**
+     * Holds the preprocessed sources of a shader program, ready to be handed to OpenGL.
+     */
+    struct ShaderSource
+    {
+      std::string vertexPath;
+      std::string fragmentPath;
+      std::string vertexSource;
+      std::string fragmentSource;
+      uint64_t    cacheKey {0};
+    };
+
+    /**
+     * Reads a shader file, recursively expanding #include "path" directives relative to it.
+     *
+     * @param path The path to the shader file.
+     * @return The preprocessed source.
+     */
+    std::string readShaderFile(const std::string& path);
+    /**
+     * Reads and preprocesses both stages of a shader program. Safe to call from worker threads.
+     *
+     * @param vertexPath   The path to the vertex shader file.
+     * @param fragmentPath The path to the fragment shader file.
+     * @return The shader sources, with their program cache key if the cache is enabled.
+     */
+    kdr::Graphics::ShaderSource readShaderSource(const std::string& vertexPath, const std::string& fragmentPath);
+
     /**
      * Represents an OpenGL shader program in the Kedarium Engine.
      */
@@ -35,28 +89,178 @@ namespace kdr
          * @param fragmentPath The path to the fragment shader file.
          */
         Shader(const char* vertexPath, const char* fragmentPath);
+        /**
+         * Constructs a shader program from already loaded sources.
+         *
+         * A deferred program is only submitted for compilation and linking; its status is not
+         * queried until it is first used, so the driver can build many programs in parallel.
+         *
+         * @param source     The preprocessed shader sources.
+         * @param isDeferred True to defer the status checks until first use, false to finish now.
+         */
+        Shader(const kdr::Graphics::ShaderSource& source, const bool isDeferred = false);
+        Shader(const Shader&) = delete;
+        Shader& operator=(const Shader&) = delete;
+        /**
+         * Takes over the program of another shader, including a pending compile, so that only
+         * one shader ever finalizes it.
+         *
+         * @param other The shader to move from. It is left without a program.
+         */
+        Shader(Shader&& other);
+        /**
+         * Takes over the program of another shader, including a pending compile. The program
+         * this shader held is not deleted.
+         *
+         * @param other The shader to move from. It is left without a program.
+         * @return A reference to this shader.
+         */
+        Shader& operator=(Shader&& other);
 
         /**
-         * Retrieves the OpenGL ID of the shader program.
+         * Retrieves the OpenGL ID of the shader program. The program may still be compiling.
          *
          * @return The OpenGL ID of the shader program.
          */
         const GLuint getID() const
         { return this->ID; }
+        /**
+         * Checks whether the program can be finalized without waiting on the driver.
+         *
+         * Without KHR_parallel_shader_compile a pending program is never reported ready,
+         * since querying its status would block.
+         *
+         * @return True if the program is finalized or done compiling, false otherwise.
+         */
+        const bool getIsReady() const;
+        /**
+         * Retrieves the location of an active uniform, as reflected when the program was linked.
+         *
+         * @param name The name of the uniform.
+         * @return The location of the uniform, or -1 if the program has no such active uniform.
+         */
+        const GLint getUniformLocation(const std::string& name) const
+        {
+          this->Finalize();
+          std::unordered_map<std::string, GLint>::const_iterator it = this->uniformLocations.find(name);
+          return it != this->uniformLocations.end() ? it->second : -1;
+        }
+        /**
+         * Retrieves the index of an active uniform block, as reflected when the program was linked.
+         *
+         * @param name The name of the uniform block.
+         * @return The index of the uniform block, or GL_INVALID_INDEX if the program has no such block.
+         */
+        const GLuint getUniformBlockIndex(const std::string& name) const
+        {
+          this->Finalize();
+          std::unordered_map<std::string, GLuint>::const_iterator it = this->uniformBlocks.find(name);
+          return it != this->uniformBlocks.end() ? it->second : GL_INVALID_INDEX;
+        }
 
+        /**
+         * Waits for a deferred program to finish linking, then validates and reflects it.
+         */
+        void Finalize() const
+        {
+          if (this->isPending) this->_finalize();
+        }
         /**
          * Activates the shader program for use in rendering.
          */
         void Use()
-        { glUseProgram(this->ID); }
+        {
+          this->Finalize();
+          kdr::Graphics::getStateCache().useProgram(this->ID);
+        }
         /**
          * Deletes the shader program from OpenGL memory.
          */
-        void Delete()
-        { glDeleteProgram(this->ID); }
+        void Delete();
 
       private:
         GLuint ID;
+
+        std::string vertexPath;
+        std::string fragmentPath;
+
+        mutable bool     isPending        {false};
+        mutable GLuint   vertexShaderID   {0};
+        mutable GLuint   fragmentShaderID {0};
+        uint64_t         cacheKey         {0};
+        double           submitTime       {0.};
+
+        mutable std::unordered_map<std::string, GLint>  uniformLocations;
+        mutable std::unordered_map<std::string, GLuint> uniformBlocks;
+
+        /**
+         * Compiles both stages and links the program without querying any status.
+         *
+         * @param source The preprocessed shader sources.
+         */
+        void _submit(const kdr::Graphics::ShaderSource& source);
+        /**
+         * Reports compile and link errors, reflects the program, stores it in the program
+         * cache and releases the stage objects.
+         */
+        void _finalize() const;
+        /**
+         * Reflects the active uniforms and uniform blocks of the linked program and binds
+         * well-known blocks to their shared binding points.
+         */
+        void _reflect() const;
+    };
+
+    /**
+     * Represents an OpenGL Uniform Buffer Object (UBO) attached to a fixed binding point.
+     */
+    class UniformBuffer
+    {
+      public:
+        /**
+         * Constructs a Uniform Buffer Object (UBO) and attaches it to a binding point.
+         *
+         * @param size    The size of the buffer in bytes.
+         * @param binding The uniform block binding point.
+         */
+        UniformBuffer(const GLsizeiptr size, const GLuint binding);
+
+        /**
+         * Retrieves the OpenGL ID of the Uniform Buffer Object (UBO).
+         *
+         * @return The OpenGL ID of the UBO.
+         */
+        const GLuint getID() const
+        { return this->ID; }
+        /**
+         * Retrieves the binding point of the Uniform Buffer Object (UBO).
+         *
+         * @return The uniform block binding point.
+         */
+        const GLuint getBinding() const
+        { return this->binding; }
+
+        /**
+         * Uploads data into the Uniform Buffer Object (UBO).
+         *
+         * @param data   The data laid out according to std140.
+         * @param size   The size of the data in bytes.
+         * @param offset The byte offset in the buffer to write at.
+         */
+        void Update(const void* data, const GLsizeiptr size, const GLintptr offset = 0);
+        /**
+         * Deletes the Uniform Buffer Object (UBO) from OpenGL memory.
+         */
+        void Delete()
+        {
+          kdr::Graphics::getStateCache().onBufferDeleted(this->ID);
+          glDeleteBuffers(1, &this->ID);
+        }
+
+      private:
+        GLuint     ID;
+        GLuint     binding;
+        GLsizeiptr size;
     };
 
     /**
@@ -68,10 +272,11 @@ namespace kdr
         /**
          * Constructs a Vertex Buffer Object (VBO) with the provided vertex data.
          *
-         * @param vertices An array of GLfloat representing the vertex data.
-         * @param size     The size of the vertex data array in bytes.
+         * @param vertices The vertex data, such as an array of GLfloat or a mapped cooked mesh.
+         * @param size     The size of the vertex data in bytes.
+         * @param usage    The expected usage pattern, such as GL_STATIC_DRAW or GL_DYNAMIC_DRAW.
          */
-        VBO(GLfloat vertices[], GLsizeiptr size);
+        VBO(const void* vertices, GLsizeiptr size, GLenum usage = GL_STATIC_DRAW);
 
         /**
          * Retrieves the OpenGL ID of the Vertex Buffer Object (VBO).
@@ -81,21 +286,37 @@ namespace kdr
         const GLuint getID() const
         { return this->ID; }
 
+        /**
+         * Overwrites part of the Vertex Buffer Object (VBO) in place.
+         *
+         * @param data   The new vertex data.
+         * @param size   The size of the data in bytes.
+         * @param offset The byte offset in the buffer to write at.
+         */
+        void Update(const void* data, const GLsizeiptr size, const GLintptr offset = 0)
+        {
+          KDR_PROFILE_SCOPE("VBO::Update");
+          this->Bind();
+          glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+        }
         /**
          * Binds the Vertex Buffer Object (VBO) for use.
          */
         void Bind()
-        { glBindBuffer(GL_ARRAY_BUFFER, this->ID); }
+        { kdr::Graphics::getStateCache().bindBuffer(GL_ARRAY_BUFFER, this->ID); }
         /**
          * Unbinds the Vertex Buffer Object (VBO).
          */
         void Unbind()
-        { glBindBuffer(GL_ARRAY_BUFFER, 0); }
+        { kdr::Graphics::getStateCache().bindBuffer(GL_ARRAY_BUFFER, 0); }
         /**
          * Deletes the Vertex Buffer Object (VBO) from OpenGL memory.
          */
         void Delete()
-        { glDeleteBuffers(1, &this->ID); }
+        {
+          kdr::Graphics::getStateCache().onBufferDeleted(this->ID);
+          glDeleteBuffers(1, &this->ID);
+        }
 
       private:
         GLuint ID;
@@ -110,10 +331,11 @@ namespace kdr
         /**
          * Constructs an Element Buffer Object (EBO) with the provided index data.
          *
-         * @param indices An array of GLuint representing the index data.
-         * @param size    The size of the index data array in bytes.
+         * @param indices The index data.
+         * @param size    The size of the index data in bytes.
+         * @param usage   The expected usage pattern, such as GL_STATIC_DRAW or GL_DYNAMIC_DRAW.
          */
-        EBO(GLuint indices[], GLsizeiptr size);
+        EBO(const GLuint* indices, GLsizeiptr size, GLenum usage = GL_STATIC_DRAW);
 
         /**
          * Retrieves the OpenGL ID of the Element Buffer Object (EBO).
@@ -123,21 +345,37 @@ namespace kdr
         const GLuint getID() const
         { return this->ID; }
 
+        /**
+         * Overwrites part of the Element Buffer Object (EBO) in place.
+         *
+         * @param data   The new index data.
+         * @param size   The size of the data in bytes.
+         * @param offset The byte offset in the buffer to write at.
+         */
+        void Update(const void* data, const GLsizeiptr size, const GLintptr offset = 0)
+        {
+          KDR_PROFILE_SCOPE("EBO::Update");
+          kdr::Graphics::getStateCache().bindBuffer(GL_COPY_WRITE_BUFFER, this->ID);
+          glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        }
         /**
          * Binds the Element Buffer Object (EBO) for use.
          */
         void Bind()
-        { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ID); }
+        { kdr::Graphics::getStateCache().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ID); }
         /**
          * Unbinds the Element Buffer Object (EBO).
          */
         void Unbind()
-        { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
+        { kdr::Graphics::getStateCache().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
         /**
          * Deletes the Element Buffer Object (EBO) from OpenGL memory.
          */
         void Delete()
-        { glDeleteBuffers(1, &this->ID); }
+        {
+          kdr::Graphics::getStateCache().onBufferDeleted(this->ID);
+          glDeleteBuffers(1, &this->ID);
+        }
 
       private:
         GLuint ID;
@@ -172,27 +410,331 @@ namespace kdr
          * @param type    The data type of each component.
          * @param stride  The stride between consecutive attributes.
          * @param offset  The offset of the first component in the VBO.
+         * @param divisor The number of instances that share each attribute value. 0 advances per vertex.
          */
-        void LinkAtrib(kdr::Graphics::VBO& VBO, GLuint layout, GLuint size, GLenum type, GLsizeiptr stride, const void* offset);
+        void LinkAtrib(kdr::Graphics::VBO& VBO, GLuint layout, GLuint size, GLenum type, GLsizeiptr stride, const void* offset, GLuint divisor = 0);
         /**
          * Binds the Vertex Array Object (VAO) for use.
          */
         void Bind()
-        { glBindVertexArray(this->ID); }
+        { kdr::Graphics::getStateCache().bindVertexArray(this->ID); }
         /**
          * Unbinds the Vertex Array Object (VAO).
          */
         void Unbind()
-        { glBindVertexArray(0); }
+        { kdr::Graphics::getStateCache().bindVertexArray(0); }
         /**
          * Deletes the Vertex Array Object (VAO) from OpenGL memory.
          */
         void Delete()
-        { glDeleteVertexArrays(1, &this->ID); }
+        {
+          kdr::Graphics::getStateCache().onVertexArrayDeleted(this->ID);
+          glDeleteVertexArrays(1, &this->ID);
+        }
 
       private:
         GLuint ID;
     };
+
+    /**
+     * Represents a growable buffer of per-instance model matrices and colors.
+     *
+     * Matrices and colors live in two regions of the same buffer, so both can be uploaded
+     * straight from the caller's arrays without an interleaving copy.
+     */
+    class InstanceBuffer
+    {
+      public:
+        /**
+         * Constructs an instance buffer.
+         *
+         * @param capacity The number of instances to allocate storage for up front.
+         */
+        InstanceBuffer(const GLsizei capacity = 64);
+
+        /**
+         * Retrieves the OpenGL ID of the instance buffer.
+         *
+         * @return The OpenGL ID of the instance buffer.
+         */
+        const GLuint getID() const
+        { return this->ID; }
+        /**
+         * Retrieves the number of instances uploaded by the last update.
+         *
+         * @return The number of instances.
+         */
+        const GLsizei getCount() const
+        { return this->count; }
+        /**
+         * Retrieves the number of instances the buffer can hold without growing.
+         *
+         * @return The capacity of the buffer in instances.
+         */
+        const GLsizei getCapacity() const
+        { return this->capacity; }
+
+        /**
+         * Uploads the per-instance data, growing the buffer when needed.
+         *
+         * @param models The model matrix of each instance.
+         * @param colors The color of each instance, or NULL to draw every instance white.
+         * @param count  The number of instances.
+         */
+        void Update(const kdr::Space::Mat4* models, const kdr::Color::RGBA* colors, const GLsizei count);
+        /**
+         * Links the instance attributes to a Vertex Array Object (VAO).
+         *
+         * The model matrix occupies locations layout to layout + 3 and the color layout + 4.
+         *
+         * @param VAO    The VAO to link the attributes to.
+         * @param layout The first layout location in the shader program.
+         */
+        void Link(kdr::Graphics::VAO& VAO, const GLuint layout);
+        /**
+         * Draws the currently bound VAO once per uploaded instance.
+         *
+         * @param mode       The primitive type to render.
+         * @param indexCount The number of indices in the bound EBO to draw per instance.
+         */
+        void DrawElements(const GLenum mode, const GLsizei indexCount)
+        { glDrawElementsInstanced(mode, indexCount, GL_UNSIGNED_INT, NULL, this->count); }
+        /**
+         * Binds the instance buffer for use.
+         */
+        void Bind()
+        { kdr::Graphics::getStateCache().bindBuffer(GL_ARRAY_BUFFER, this->ID); }
+        /**
+         * Unbinds the instance buffer.
+         */
+        void Unbind()
+        { kdr::Graphics::getStateCache().bindBuffer(GL_ARRAY_BUFFER, 0); }
+        /**
+         * Deletes the instance buffer from OpenGL memory.
+         */
+        void Delete()
+        {
+          kdr::Graphics::getStateCache().onBufferDeleted(this->ID);
+          glDeleteBuffers(1, &this->ID);
+        }
+
+      private:
+        GLuint  ID;
+        GLsizei count    {0};
+        GLsizei capacity {0};
+
+        std::vector<std::pair<GLuint, GLuint>> links;
+        std::vector<kdr::Color::RGBA>          defaultColors;
+
+        /**
+         * Reallocates the buffer storage, orphaning the previous contents.
+         *
+         * @param capacity The new capacity in instances.
+         */
+        void _allocate(const GLsizei capacity);
+        /**
+         * Points the instance attributes of a VAO at the current buffer regions.
+         *
+         * @param vaoID  The OpenGL ID of the VAO.
+         * @param layout The first layout location.
+         */
+        void _linkAttributes(const GLuint vaoID, const GLuint layout);
+    };
+
+    /**
+     * Represents a ring buffer for geometry that is rewritten every frame.
+     *
+     * The buffer is split into one region per frame in flight. Where ARB_buffer_storage is
+     * available, it stays persistently mapped and a fence guards each region; otherwise writes
+     * go through glBufferSubData and the storage is orphaned whenever the ring wraps around.
+     */
+    class StreamBuffer
+    {
+      public:
+        /**
+         * Constructs a stream buffer.
+         *
+         * @param target     The buffer target the data is used through, such as GL_ARRAY_BUFFER.
+         * @param frameSize  The number of bytes that can be written per frame.
+         * @param frameCount The number of frames that may be in flight at once.
+         */
+        StreamBuffer(const GLenum target, const GLsizeiptr frameSize, const GLuint frameCount = 3);
+
+        /**
+         * Retrieves the OpenGL ID of the stream buffer.
+         *
+         * @return The OpenGL ID of the stream buffer.
+         */
+        const GLuint getID() const
+        { return this->ID; }
+        /**
+         * Retrieves whether the buffer is persistently mapped.
+         *
+         * @return True if ARB_buffer_storage is in use, false if writes fall back to glBufferSubData.
+         */
+        const bool getIsPersistent() const
+        { return this->mapped != NULL; }
+        /**
+         * Retrieves the number of bytes that can be written per frame.
+         *
+         * @return The size of one frame region in bytes.
+         */
+        const GLsizeiptr getFrameSize() const
+        { return this->frameSize; }
+        /**
+         * Retrieves the number of bytes written so far in the current frame.
+         *
+         * @return The number of bytes used in the current frame region.
+         */
+        const GLsizeiptr getUsedSize() const
+        { return this->cursor; }
+
+        /**
+         * Waits until the GPU is done with the next frame region and makes it current.
+         */
+        void BeginFrame();
+        /**
+         * Fences the current frame region once the frame's draws have been submitted.
+         */
+        void EndFrame();
+        /**
+         * Reserves space in the current frame region for direct writes.
+         *
+         * @param size      The number of bytes to reserve.
+         * @param offset    Receives the byte offset of the reservation from the start of the buffer.
+         * @param alignment The multiple the offset is rounded up to.
+         * @return A pointer to write the data to, or NULL if the frame region is full.
+         */
+        void* Map(const GLsizeiptr size, GLintptr& offset, const GLsizeiptr alignment = 16);
+        /**
+         * Publishes the data written since the last Map() call.
+         */
+        void Unmap();
+        /**
+         * Copies data into the current frame region.
+         *
+         * @param data      The data to copy.
+         * @param size      The size of the data in bytes.
+         * @param alignment The multiple the offset is rounded up to.
+         * @return The byte offset of the data from the start of the buffer, or -1 if the frame region is full.
+         */
+        GLintptr Write(const void* data, const GLsizeiptr size, const GLsizeiptr alignment = 16);
+        /**
+         * Binds the stream buffer to its target.
+         */
+        void Bind()
+        { kdr::Graphics::getStateCache().bindBuffer(this->target, this->ID); }
+        /**
+         * Deletes the stream buffer and its fences from OpenGL memory.
+         */
+        void Delete();
+
+      private:
+        GLuint     ID;
+        GLenum     target;
+        GLsizeiptr frameSize;
+        GLuint     frameCount;
+        GLuint     frame  {0};
+        GLsizeiptr cursor {0};
+
+        char*               mapped {NULL};
+        std::vector<GLsync> fences;
+
+        std::vector<char> staging;
+        GLintptr          stagingOffset {0};
+        GLsizeiptr        stagingSize   {0};
+
+        /**
+         * Claims space in the current frame region.
+         *
+         * @param size      The number of bytes to claim.
+         * @param alignment The multiple the offset is rounded up to.
+         * @return The byte offset from the start of the buffer, or -1 if the frame region is full.
+         */
+        GLintptr _reserve(const GLsizeiptr size, const GLsizeiptr alignment);
+        /**
+         * Binds the stream buffer to GL_COPY_WRITE_BUFFER to be written, so the element array
+         * binding of whichever VAO is bound stays untouched.
+         */
+        void _bindForWrite()
+        { kdr::Graphics::getStateCache().bindBuffer(GL_COPY_WRITE_BUFFER, this->ID); }
+    };
+
+    /**
+     * Represents an OpenGL Framebuffer Object (FBO) with a color and a depth attachment.
+     */
+    class Framebuffer
+    {
+      public:
+        /**
+         * Constructs a Framebuffer Object (FBO) with RGBA8 color and 24-bit depth storage.
+         *
+         * @param width  The width of the attachments in pixels.
+         * @param height The height of the attachments in pixels.
+         */
+        Framebuffer(const GLsizei width, const GLsizei height);
+
+        /**
+         * Retrieves the OpenGL ID of the Framebuffer Object (FBO).
+         *
+         * @return The OpenGL ID of the FBO.
+         */
+        const GLuint getID() const
+        { return this->ID; }
+        /**
+         * Retrieves the width of the attachments.
+         *
+         * @return The width in pixels.
+         */
+        const GLsizei getWidth() const
+        { return this->width; }
+        /**
+         * Retrieves the height of the attachments.
+         *
+         * @return The height in pixels.
+         */
+        const GLsizei getHeight() const
+        { return this->height; }
+
+        /**
+         * Binds the Framebuffer Object (FBO) as the render target and fits the viewport to it.
+         */
+        void Bind();
+        /**
+         * Binds the default framebuffer as the render target.
+         */
+        void Unbind()
+        { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+        /**
+         * Reallocates the attachments with a new size. Their contents are lost.
+         *
+         * @param width  The new width in pixels.
+         * @param height The new height in pixels.
+         */
+        void Resize(const GLsizei width, const GLsizei height);
+        /**
+         * Reads the color attachment back to memory as tightly packed RGBA8 rows, bottom row first.
+         *
+         * @param pixels Receives width * height * 4 bytes.
+         */
+        void ReadPixels(std::vector<unsigned char>& pixels);
+        /**
+         * Deletes the Framebuffer Object (FBO) and its attachments from OpenGL memory.
+         */
+        void Delete();
+
+      private:
+        GLuint  ID;
+        GLuint  colorID;
+        GLuint  depthID;
+        GLsizei width;
+        GLsizei height;
+
+        /**
+         * Allocates the storage of both attachments for the current size.
+         */
+        void _allocate();
+    };
   }
 }
 
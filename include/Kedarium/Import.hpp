@@ -0,0 +1,93 @@
+#ifndef KDR_IMPORT_HPP
+#define KDR_IMPORT_HPP
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+#include "Graphics.hpp"
+#include "Bounds.hpp"
+#include "MeshPool.hpp"
+
+namespace kdr
+{
+  namespace Import
+  {
+    /**
+     * Interleaved vertex layout of imported models. Position at layout 0, normal at 1 and
+     * texture coordinates at 2.
+     */
+    struct Vertex
+    {
+      GLfloat position[3];
+      GLfloat normal[3];
+      GLfloat uv[2];
+    };
+
+    /**
+     * Names a contiguous range of a model's indices, e.g. one OBJ group or one glTF primitive.
+     */
+    struct Submesh
+    {
+      std::string name;
+      GLuint      firstIndex {0};
+      GLuint      indexCount {0};
+    };
+
+    /**
+     * Holds an imported model as one indexed triangle list, ready to be uploaded.
+     */
+    struct Model
+    {
+      std::vector<kdr::Import::Vertex>  vertices;
+      std::vector<GLuint>               indices;
+      std::vector<kdr::Import::Submesh> submeshes;
+      kdr::Space::AABB                  bounds;
+    };
+
+    /**
+     * Retrieves the attributes of the imported vertex layout, in the form mesh pools take.
+     *
+     * @return The vertex attributes.
+     */
+    const std::vector<kdr::Graphics::VertexAttribute> getVertexAttributes();
+    /**
+     * Links the imported vertex layout to a Vertex Array Object (VAO). Both must be bound.
+     *
+     * @param VAO The VAO to link the attributes to.
+     * @param VBO The VBO holding the model's vertices.
+     */
+    void linkAttributes(kdr::Graphics::VAO& VAO, kdr::Graphics::VBO& VBO);
+
+    /**
+     * Imports a Wavefront OBJ file. The file is parsed in parallel chunks on the job scheduler,
+     * polygons are fan triangulated and corners with the same position, texture coordinate and
+     * normal share one vertex. Every o, g and usemtl statement starts a new submesh.
+     *
+     * @param path  The path to the OBJ file.
+     * @param model Receives the model.
+     * @return True if the file was imported, false otherwise.
+     */
+    bool loadObj(const char* path, kdr::Import::Model& model);
+    /**
+     * Imports the triangle primitives of the default scene of a glTF 2.0 file, either .gltf with
+     * external or embedded buffers, or binary .glb. Node transforms are applied, and primitives
+     * are converted in parallel on the job scheduler, one submesh each.
+     *
+     * @param path  The path to the glTF file.
+     * @param model Receives the model.
+     * @return True if the file was imported, false otherwise.
+     */
+    bool loadGltf(const char* path, kdr::Import::Model& model);
+    /**
+     * Imports a model, choosing the importer by the file extension.
+     *
+     * @param path  The path to the .obj, .gltf or .glb file.
+     * @param model Receives the model.
+     * @return True if the file was imported, false otherwise.
+     */
+    bool loadModel(const char* path, kdr::Import::Model& model);
+  }
+}
+
+#endif // KDR_IMPORT_HPP
@@ -0,0 +1,255 @@
+#ifndef KDR_JOBS_HPP
+#define KDR_JOBS_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kdr
+{
+  namespace Jobs
+  {
+    class Counter;
+
+    /**
+     * A unit of work, optionally signalling a counter when it finishes.
+     */
+    struct Job
+    {
+      std::function<void()> function;
+      kdr::Jobs::Counter*   counter {NULL};
+    };
+
+    /**
+     * Counts the unfinished jobs of a group. Jobs can wait on a group through it.
+     *
+     * A counter must outlive its jobs: only destroy it after Scheduler::wait() returned.
+     */
+    class Counter
+    {
+      public:
+        /**
+         * Constructs a counter with no pending jobs.
+         */
+        Counter() {}
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+        /**
+         * Retrieves the number of unfinished jobs.
+         *
+         * @return The number of unfinished jobs.
+         */
+        const uint32_t getValue() const
+        { return this->value.load(std::memory_order_acquire); }
+        /**
+         * Checks whether every job of the group has finished.
+         *
+         * @return True if no job is pending, false otherwise.
+         */
+        const bool getIsDone() const
+        { return this->getValue() == 0; }
+
+      private:
+        friend class Scheduler;
+
+        std::atomic<uint32_t>       value {0};
+        std::mutex                  mutex;
+        std::vector<kdr::Jobs::Job> waiting;
+    };
+
+    /**
+     * Utilization figures of one worker thread.
+     */
+    struct WorkerStats
+    {
+      uint64_t executedCount {0};
+      uint64_t stolenCount   {0};
+      double   busySeconds   {0.};
+      double   utilization   {0.};
+    };
+
+    /**
+     * Work-stealing job scheduler.
+     *
+     * Every worker owns a deque: it pushes and pops its own jobs at the back, while idle workers
+     * steal from the front of the others. Threads outside the pool submit to a shared queue and
+     * help execute jobs while they wait on a counter.
+     */
+    class Scheduler
+    {
+      public:
+        /**
+         * Constructs a scheduler. Worker threads are started on first use.
+         *
+         * @param threadCount The number of worker threads, or 0 for one less than the hardware concurrency.
+         */
+        Scheduler(const unsigned int threadCount = 0);
+        /**
+         * Finishes the queued jobs and stops the worker threads.
+         */
+        ~Scheduler();
+
+        /**
+         * Retrieves the number of worker threads.
+         *
+         * @return The number of worker threads.
+         */
+        const unsigned int getThreadCount() const
+        { return this->threadCount; }
+
+        /**
+         * Changes the number of worker threads. Must not be called while jobs are running.
+         *
+         * @param threadCount The number of worker threads, or 0 for one less than the hardware concurrency.
+         */
+        void setThreadCount(const unsigned int threadCount);
+
+        /**
+         * Queues a job.
+         *
+         * @param function   The work to run.
+         * @param counter    An optional counter incremented now and decremented when the job finishes.
+         * @param dependency An optional counter the job waits for before it is queued.
+         */
+        void run(
+          const std::function<void()>& function,
+          kdr::Jobs::Counter* counter = NULL,
+          kdr::Jobs::Counter* dependency = NULL
+        );
+        /**
+         * Executes queued jobs on the calling thread until a counter reaches zero.
+         *
+         * @param counter The counter to wait for.
+         */
+        void wait(kdr::Jobs::Counter& counter);
+        /**
+         * Splits a range into chunks, runs them as jobs and waits for all of them.
+         *
+         * @param begin     The first index of the range.
+         * @param end       One past the last index of the range.
+         * @param grainSize The minimum number of indices per chunk.
+         * @param function  The work to run, receiving the begin and end of a chunk.
+         */
+        void parallelFor(
+          const size_t begin,
+          const size_t end,
+          const size_t grainSize,
+          const std::function<void(size_t, size_t)>& function
+        );
+        /**
+         * Retrieves the utilization of every worker since the last reset. The last entry sums up
+         * the jobs run by threads outside the pool while waiting.
+         *
+         * @return The worker statistics.
+         */
+        std::vector<kdr::Jobs::WorkerStats> getWorkerStats() const;
+        /**
+         * Resets the worker statistics.
+         */
+        void resetStats();
+
+      private:
+        struct Worker
+        {
+          std::deque<kdr::Jobs::Job> jobs;
+          std::mutex                 mutex;
+          std::thread                thread;
+          std::atomic<uint64_t>      executedCount {0};
+          std::atomic<uint64_t>      stolenCount   {0};
+          std::atomic<uint64_t>      busyNanoseconds {0};
+        };
+
+        unsigned int threadCount {1};
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        Worker                               external;
+
+        std::deque<kdr::Jobs::Job> injected;
+        std::mutex                 injectedMutex;
+
+        std::atomic<bool>       isStarted   {false};
+        std::atomic<uint32_t>   queuedCount {0};
+        std::atomic<bool>       isStopping  {false};
+        std::mutex              sleepMutex;
+        std::condition_variable sleepCondition;
+        std::mutex              startMutex;
+
+        std::chrono::steady_clock::time_point statsEpoch;
+
+        /**
+         * Starts the worker threads if they aren't running.
+         */
+        void _start();
+        /**
+         * Stops and joins the worker threads.
+         */
+        void _stop();
+        /**
+         * Places a runnable job in the deque of the calling worker, or in the shared queue.
+         *
+         * @param job The job.
+         */
+        void _push(kdr::Jobs::Job&& job);
+        /**
+         * Takes a job from the worker's own deque, the shared queue or another worker.
+         *
+         * @param job         Receives the job.
+         * @param workerIndex The index of the calling worker, or -1 for outside threads.
+         * @return True if a job was taken, false if there was no work.
+         */
+        bool _tryPop(kdr::Jobs::Job& job, const int workerIndex);
+        /**
+         * Runs a job and signals its counter.
+         *
+         * @param job         The job.
+         * @param workerIndex The index of the calling worker, or -1 for outside threads.
+         */
+        void _execute(kdr::Jobs::Job& job, const int workerIndex);
+        /**
+         * Runs jobs until the scheduler stops.
+         *
+         * @param workerIndex The index of the worker.
+         */
+        void _workerLoop(const int workerIndex);
+        /**
+         * Finds the index of the calling thread in this scheduler's pool.
+         *
+         * @return The worker index, or -1 for outside threads.
+         */
+        int _getWorkerIndex() const;
+    };
+
+    /**
+     * Retrieves the scheduler shared by the whole engine.
+     *
+     * @return A reference to the scheduler.
+     */
+    kdr::Jobs::Scheduler& getScheduler();
+
+    /**
+     * Splits a range into chunks and runs them on the shared scheduler, returning when all are done.
+     *
+     * @param begin     The first index of the range.
+     * @param end       One past the last index of the range.
+     * @param grainSize The minimum number of indices per chunk.
+     * @param function  The work to run, receiving the begin and end of a chunk.
+     */
+    inline void parallelFor(
+      const size_t begin,
+      const size_t end,
+      const size_t grainSize,
+      const std::function<void(size_t, size_t)>& function
+    )
+    { kdr::Jobs::getScheduler().parallelFor(begin, end, grainSize, function); }
+  }
+}
+
+#endif // KDR_JOBS_HPP
@@ -0,0 +1,160 @@
+#ifndef KDR_LOD_HPP
+#define KDR_LOD_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Space.hpp"
+#include "Camera.hpp"
+#include "MeshPool.hpp"
+#include "MeshFile.hpp"
+
+namespace kdr
+{
+  namespace Mesh
+  {
+    /**
+     * Describes one detail level of a mesh.
+     */
+    struct LODLevel
+    {
+      kdr::Graphics::MeshHandle handle     {kdr::Graphics::invalidMesh};
+      GLsizei                   indexCount {0};
+      float                     error      {0.f}; // Estimated deviation from the full mesh, in model units
+    };
+
+    /**
+     * Represents a mesh stored at several detail levels in a mesh pool.
+     */
+    class LODMesh
+    {
+      public:
+        /**
+         * Simplifies a mesh into detail levels and uploads each into a mesh pool. Level 0 is the
+         * mesh itself, and each further level keeps about `reduction` of the previous one's triangles.
+         *
+         * @param pool        The mesh pool to store the levels in.
+         * @param vertices    The vertex data. Every vertex must start with its position as three floats.
+         * @param vertexCount The number of vertices.
+         * @param indices     The triangle list indices.
+         * @param indexCount  The number of indices.
+         * @param maxLevels   The maximum number of levels, including the full mesh.
+         * @param reduction   The fraction of triangles each level keeps from the previous one.
+         */
+        LODMesh(
+          kdr::Graphics::MeshPool& pool,
+          const void* vertices,
+          const GLuint vertexCount,
+          const GLuint* indices,
+          const GLuint indexCount,
+          const unsigned int maxLevels = 4,
+          const float reduction = 0.5f
+        );
+        /**
+         * Uploads the detail levels of a cooked mesh into a mesh pool, straight from its mapping.
+         *
+         * @param pool The mesh pool to store the levels in. Must have the cooked mesh's vertex stride.
+         * @param mesh An open cooked mesh.
+         */
+        LODMesh(kdr::Graphics::MeshPool& pool, const kdr::Mesh::CookedMesh& mesh);
+
+        /**
+         * Retrieves the number of detail levels.
+         *
+         * @return The number of levels. Fewer than requested if the mesh could not be simplified further.
+         */
+        const unsigned int getLevelCount() const
+        { return (unsigned int)this->levels.size(); }
+        /**
+         * Retrieves a detail level.
+         *
+         * @param level The level index. 0 is the full mesh.
+         * @return The level description.
+         */
+        const kdr::Mesh::LODLevel& getLevel(const unsigned int level) const
+        { return this->levels[level]; }
+
+        /**
+         * Removes every level from the mesh pool.
+         */
+        void Remove();
+
+      private:
+        kdr::Graphics::MeshPool*         pool {NULL};
+        std::vector<kdr::Mesh::LODLevel> levels;
+    };
+
+    /**
+     * Picks mesh detail levels by how large their error appears on screen.
+     */
+    class LODSelector
+    {
+      public:
+        /**
+         * Retrieves the on-screen error allowed before a finer level is used.
+         *
+         * @return The threshold in pixels.
+         */
+        const float getErrorThreshold() const
+        { return this->errorThreshold; }
+        /**
+         * Retrieves how far below the threshold a coarser level must be before switching to it.
+         *
+         * @return The hysteresis as a fraction of the threshold.
+         */
+        const float getHysteresis() const
+        { return this->hysteresis; }
+
+        /**
+         * Sets the on-screen error allowed before a finer level is used.
+         *
+         * @param errorThreshold The threshold in pixels.
+         */
+        void setErrorThreshold(const float errorThreshold)
+        { this->errorThreshold = errorThreshold; }
+        /**
+         * Sets how far below the threshold a coarser level must be before switching to it, so
+         * objects near a switching distance don't alternate between levels.
+         *
+         * @param hysteresis The hysteresis as a fraction of the threshold, between 0 and 1.
+         */
+        void setHysteresis(const float hysteresis)
+        { this->hysteresis = hysteresis; }
+
+        /**
+         * Captures the camera position and projection scale for the following selections.
+         *
+         * @param camera         The camera the frame is rendered from.
+         * @param viewportHeight The height of the viewport in pixels.
+         */
+        void update(const kdr::Camera& camera, const unsigned int viewportHeight);
+        /**
+         * Computes how large a world-space error appears on screen.
+         *
+         * @param error  The error in world units.
+         * @param center The world position the error is at.
+         * @return The projected error in pixels.
+         */
+        const float getScreenError(const float error, const kdr::Space::Vec3& center) const;
+        /**
+         * Picks the coarsest level of a mesh whose on-screen error stays within the threshold.
+         *
+         * @param mesh   The mesh.
+         * @param center The world position of the object.
+         * @param scale  The largest scale factor of the object's model matrix.
+         * @param level  The level the object was drawn with last time, which receives the new level.
+         * @return The new level.
+         */
+        unsigned int select(const kdr::Mesh::LODMesh& mesh, const kdr::Space::Vec3& center, const float scale, unsigned int& level) const;
+
+      private:
+        kdr::Space::Vec3 cameraPosition  {0.f, 0.f, 0.f};
+        float            projectionScale {1.f};
+        float            errorThreshold  {1.f};
+        float            hysteresis      {0.25f};
+    };
+  }
+}
+
+#endif // KDR_LOD_HPP
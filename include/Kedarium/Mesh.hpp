@@ -0,0 +1,92 @@
+#ifndef KDR_MESH_HPP
+#define KDR_MESH_HPP
+
+#include <GL/glew.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace kdr
+{
+  namespace Mesh
+  {
+    /**
+     * Holds one simplified detail level of a mesh, with its own compacted vertices.
+     */
+    struct MeshLevel
+    {
+      std::vector<unsigned char> vertices;
+      GLuint                     vertexCount {0};
+      std::vector<GLuint>        indices;
+      float                      error       {0.f};
+    };
+
+    /**
+     * Reduces the triangle count of an indexed mesh by quadric error edge collapses.
+     *
+     * Vertices are only ever collapsed onto other existing vertices, so the result indexes the
+     * same vertex data. Vertices on open borders or on attribute seams (several vertices at one
+     * position) are kept in place, so simplified meshes never crack open.
+     *
+     * @param vertices         The vertex data. Every vertex must start with its position as three floats.
+     * @param vertexCount      The number of vertices.
+     * @param vertexStride     The size of one vertex in bytes.
+     * @param indices          The triangle list indices.
+     * @param indexCount       The number of indices.
+     * @param targetIndexCount The number of indices to stop at. Not reached if the locked vertices prevent it.
+     * @param error            Receives the estimated deviation from the original surface, in model units. Can be NULL.
+     * @return The indices of the simplified triangle list.
+     */
+    std::vector<GLuint> simplify(
+      const void* vertices,
+      const size_t vertexCount,
+      const size_t vertexStride,
+      const GLuint* indices,
+      const size_t indexCount,
+      const size_t targetIndexCount,
+      float* error = NULL
+    );
+    /**
+     * Copies the vertices referenced by an index buffer into a tightly packed array, in first-use
+     * order, and rewrites the indices to match.
+     *
+     * @param vertices     The vertex data.
+     * @param vertexCount  The number of vertices.
+     * @param vertexStride The size of one vertex in bytes.
+     * @param indices      The indices to rewrite.
+     * @param compacted    Receives the referenced vertices.
+     * @return The number of referenced vertices.
+     */
+    GLuint compactVertices(
+      const void* vertices,
+      const size_t vertexCount,
+      const size_t vertexStride,
+      std::vector<GLuint>& indices,
+      std::vector<unsigned char>& compacted
+    );
+    /**
+     * Simplifies a mesh into successively coarser detail levels. Stops early once a level would
+     * not remove at least a tenth of the previous level's triangles.
+     *
+     * @param vertices     The vertex data. Every vertex must start with its position as three floats.
+     * @param vertexCount  The number of vertices.
+     * @param vertexStride The size of one vertex in bytes.
+     * @param indices      The triangle list indices.
+     * @param indexCount   The number of indices.
+     * @param levelCount   The maximum number of levels to build, not counting the full mesh.
+     * @param reduction    The fraction of triangles each level keeps from the previous one.
+     * @return The levels, from finest to coarsest. Their errors never decrease.
+     */
+    std::vector<kdr::Mesh::MeshLevel> buildLevels(
+      const void* vertices,
+      const size_t vertexCount,
+      const size_t vertexStride,
+      const GLuint* indices,
+      const size_t indexCount,
+      const unsigned int levelCount,
+      const float reduction
+    );
+  }
+}
+
+#endif // KDR_MESH_HPP
@@ -0,0 +1,212 @@
+#ifndef KDR_MESH_FILE_HPP
+#define KDR_MESH_FILE_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <vector>
+
+#include "File.hpp"
+#include "Bounds.hpp"
+#include "MeshPool.hpp"
+
+namespace kdr
+{
+  namespace Mesh
+  {
+    /**
+     * Identifies a cooked mesh file.
+     */
+    constexpr char cookedMagic[4] {'K', 'M', 'S', 'H'};
+    /**
+     * Version of the cooked mesh layout written by this build. Files of other versions are rejected.
+     */
+    constexpr uint32_t cookedVersion {1};
+    /**
+     * Alignment of every section of a cooked mesh, from the start of the file.
+     */
+    constexpr uint64_t cookedAlignment {64};
+
+    /**
+     * Leads a cooked mesh file. All fields are little-endian.
+     *
+     * The file continues with aligned sections: the attribute table, the level table, the vertex
+     * data of every level and the indices of every level, each at the offset given here.
+     */
+    struct CookedHeader
+    {
+      char     magic[4];
+      uint32_t version;
+      uint32_t vertexStride;
+      uint32_t attributeCount;
+      uint32_t levelCount;
+      uint32_t reserved;
+      float    boundsMin[3];
+      float    boundsMax[3];
+      uint64_t attributesOffset;
+      uint64_t levelsOffset;
+      uint64_t verticesOffset;
+      uint64_t verticesSize;
+      uint64_t indicesOffset;
+      uint64_t indicesSize;
+    };
+
+    /**
+     * Describes one vertex attribute in a cooked mesh.
+     */
+    struct CookedAttribute
+    {
+      uint32_t layout;
+      uint32_t size;
+      uint32_t type;
+      uint32_t offset;
+    };
+
+    /**
+     * Locates one detail level in a cooked mesh. Indices are relative to the level's first vertex.
+     */
+    struct CookedLevel
+    {
+      uint32_t firstVertex;
+      uint32_t vertexCount;
+      uint32_t firstIndex;
+      uint32_t indexCount;
+      float    error;
+      uint32_t reserved;
+    };
+
+    /**
+     * Gives access to a cooked mesh file mapped into memory. Vertex and index data are used in
+     * place, so uploads read straight from the mapping.
+     */
+    class CookedMesh
+    {
+      public:
+        /**
+         * Constructs a cooked mesh without a file.
+         */
+        CookedMesh() {}
+        /**
+         * Constructs a cooked mesh and opens a file.
+         *
+         * @param path The path to the cooked mesh file.
+         */
+        CookedMesh(const char* path)
+        { this->open(path); }
+
+        /**
+         * Checks whether a valid cooked mesh is open.
+         *
+         * @return True if a file passed validation, false otherwise.
+         */
+        const bool getIsOpen() const
+        { return this->header != NULL; }
+        /**
+         * Retrieves the size of one vertex.
+         *
+         * @return The vertex stride in bytes.
+         */
+        const GLsizeiptr getVertexStride() const
+        { return this->header->vertexStride; }
+        /**
+         * Retrieves the number of detail levels.
+         *
+         * @return The number of levels. Level 0 is the full mesh.
+         */
+        const unsigned int getLevelCount() const
+        { return this->header->levelCount; }
+        /**
+         * Retrieves a detail level.
+         *
+         * @param level The level index.
+         * @return The level description.
+         */
+        const kdr::Mesh::CookedLevel& getLevel(const unsigned int level) const
+        { return this->levels[level]; }
+        /**
+         * Retrieves the vertices of a detail level.
+         *
+         * @param level The level index.
+         * @return A pointer into the mapping, to getLevel(level).vertexCount vertices.
+         */
+        const void* getVertices(const unsigned int level) const
+        { return this->vertices + (size_t)this->levels[level].firstVertex * this->header->vertexStride; }
+        /**
+         * Retrieves the indices of a detail level.
+         *
+         * @param level The level index.
+         * @return A pointer into the mapping, to getLevel(level).indexCount indices.
+         */
+        const GLuint* getIndices(const unsigned int level) const
+        { return this->indices + this->levels[level].firstIndex; }
+        /**
+         * Retrieves the bounds of the full mesh.
+         *
+         * @return The bounding box in model space.
+         */
+        const kdr::Space::AABB getBounds() const;
+        /**
+         * Retrieves the vertex attributes, in the form mesh pools take.
+         *
+         * @return The vertex attributes.
+         */
+        const std::vector<kdr::Graphics::VertexAttribute> getAttributes() const;
+
+        /**
+         * Maps and validates a cooked mesh file, closing the previous one. Every index of a level
+         * is checked against the level's vertex count.
+         *
+         * @param path The path to the cooked mesh file.
+         * @return True if the file is a valid cooked mesh of this version, false otherwise.
+         */
+        bool open(const char* path);
+        /**
+         * Unmaps the file.
+         */
+        void close();
+        /**
+         * Uploads one detail level into a mesh pool, straight from the mapping.
+         *
+         * @param pool  A mesh pool with this mesh's vertex stride.
+         * @param level The level index.
+         * @return A handle to the mesh, or kdr::Graphics::invalidMesh if the strides differ.
+         */
+        kdr::Graphics::MeshHandle Upload(kdr::Graphics::MeshPool& pool, const unsigned int level = 0) const;
+
+      private:
+        kdr::File::MappedFile             file;
+        const kdr::Mesh::CookedHeader*    header     {NULL};
+        const kdr::Mesh::CookedAttribute* attributes {NULL};
+        const kdr::Mesh::CookedLevel*     levels     {NULL};
+        const unsigned char*              vertices   {NULL};
+        const GLuint*                     indices    {NULL};
+    };
+
+    /**
+     * Builds a cooked mesh with detail levels and writes it to a file.
+     *
+     * @param path         The path of the cooked mesh file.
+     * @param vertices     The vertex data. Every vertex must start with its position as three floats.
+     * @param vertexCount  The number of vertices.
+     * @param vertexStride The size of one vertex in bytes.
+     * @param attributes   The vertex attributes.
+     * @param indices      The triangle list indices.
+     * @param indexCount   The number of indices.
+     * @param maxLevels    The maximum number of detail levels, including the full mesh.
+     * @param reduction    The fraction of triangles each level keeps from the previous one.
+     * @return True if the file was written, false otherwise.
+     */
+    bool writeCookedMesh(
+      const char* path,
+      const void* vertices,
+      const GLuint vertexCount,
+      const GLsizeiptr vertexStride,
+      const std::vector<kdr::Graphics::VertexAttribute>& attributes,
+      const GLuint* indices,
+      const GLuint indexCount,
+      const unsigned int maxLevels = 4,
+      const float reduction = 0.5f
+    );
+  }
+}
+
+#endif // KDR_MESH_FILE_HPP
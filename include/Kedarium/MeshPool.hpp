@@ -0,0 +1,332 @@
+#ifndef KDR_MESH_POOL_HPP
+#define KDR_MESH_POOL_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "Graphics.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Hands out ranges of a linear space with best-fit placement and coalescing frees.
+     */
+    class RangeAllocator
+    {
+      public:
+        /**
+         * Constructs a range allocator with a single free range.
+         *
+         * @param capacity The size of the space in elements.
+         */
+        RangeAllocator(const GLuint capacity = 0)
+        { this->reset(capacity); }
+
+        /**
+         * Retrieves the size of the space.
+         *
+         * @return The capacity in elements.
+         */
+        const GLuint getCapacity() const
+        { return this->capacity; }
+        /**
+         * Retrieves the number of unallocated elements.
+         *
+         * @return The free size in elements.
+         */
+        const GLuint getFreeSize() const
+        { return this->freeSize; }
+        /**
+         * Retrieves the number of separate free ranges.
+         *
+         * @return The number of free ranges. More than one means the space is fragmented.
+         */
+        const size_t getFreeRangeCount() const
+        { return this->freeByOffset.size(); }
+        /**
+         * Checks whether every allocated range is packed at the start of the space.
+         *
+         * @return True if the only free space, if any, ends at the capacity, false otherwise.
+         */
+        const bool getIsCompact() const
+        {
+          if (this->freeByOffset.empty()) return true;
+          if (this->freeByOffset.size() > 1) return false;
+          return this->freeByOffset.begin()->first + this->freeByOffset.begin()->second == this->capacity;
+        }
+
+        /**
+         * Claims a range of the space.
+         *
+         * @param size   The size of the range in elements.
+         * @param offset Receives the offset of the range.
+         * @return True if a large enough free range existed, false otherwise.
+         */
+        bool allocate(const GLuint size, GLuint& offset);
+        /**
+         * Returns a range to the space, merging it with adjacent free ranges.
+         *
+         * @param offset The offset of the range.
+         * @param size   The size of the range in elements.
+         */
+        void free(const GLuint offset, const GLuint size);
+        /**
+         * Extends the space, appending the new elements as free.
+         *
+         * @param capacity The new capacity in elements. Must not be smaller than the current one.
+         */
+        void grow(const GLuint capacity);
+        /**
+         * Discards every allocation.
+         *
+         * @param capacity  The new capacity in elements.
+         * @param allocated The number of leading elements to leave allocated.
+         */
+        void reset(const GLuint capacity, const GLuint allocated = 0);
+
+      private:
+        GLuint capacity {0};
+        GLuint freeSize {0};
+
+        std::map<GLuint, GLuint>      freeByOffset;
+        std::multimap<GLuint, GLuint> freeBySize;
+
+        /**
+         * Inserts a free range into both indices.
+         *
+         * @param offset The offset of the range.
+         * @param size   The size of the range in elements.
+         */
+        void _insert(const GLuint offset, const GLuint size);
+        /**
+         * Removes a free range from both indices.
+         *
+         * @param offset The offset of the range.
+         * @param size   The size of the range in elements.
+         */
+        void _erase(const GLuint offset, const GLuint size);
+    };
+
+    /**
+     * Describes one vertex attribute of the meshes in a pool.
+     */
+    struct VertexAttribute
+    {
+      GLuint     layout;
+      GLuint     size;
+      GLenum     type;
+      GLsizeiptr offset;
+
+      /**
+       * Constructs a vertex attribute description.
+       *
+       * @param layout The layout location in the shader program.
+       * @param size   The number of components.
+       * @param type   The data type of each component.
+       * @param offset The byte offset of the attribute within a vertex.
+       */
+      VertexAttribute(
+        const GLuint layout,
+        const GLuint size,
+        const GLenum type,
+        const GLsizeiptr offset
+      ) : layout(layout), size(size), type(type), offset(offset)
+      {}
+    };
+
+    /**
+     * Locates a mesh inside the shared buffers of a pool.
+     */
+    struct MeshRange
+    {
+      GLint   baseVertex  {0};
+      GLuint  firstIndex  {0};
+      GLsizei vertexCount {0};
+      GLsizei indexCount  {0};
+    };
+
+    /**
+     * Identifies a mesh in a pool. Handles stay valid across growth and defragmentation.
+     */
+    typedef uint32_t MeshHandle;
+    /**
+     * Handle value that never refers to a mesh.
+     */
+    const kdr::Graphics::MeshHandle invalidMesh {0xFFFFFFFF};
+
+    /**
+     * Packs many meshes with the same vertex layout into one vertex buffer and one index buffer
+     * sharing a single VAO, to be drawn with base-vertex offsets.
+     */
+    class MeshPool
+    {
+      public:
+        /**
+         * Constructs a mesh pool.
+         *
+         * @param vertexStride   The size of one vertex in bytes.
+         * @param attributes     The vertex attributes shared by every mesh.
+         * @param vertexCapacity The number of vertices to allocate up front.
+         * @param indexCapacity  The number of indices to allocate up front.
+         */
+        MeshPool(
+          const GLsizeiptr vertexStride,
+          const std::vector<kdr::Graphics::VertexAttribute>& attributes,
+          const GLuint vertexCapacity = 65536,
+          const GLuint indexCapacity = 196608
+        );
+
+        /**
+         * Retrieves the OpenGL ID of the pool's Vertex Array Object (VAO).
+         *
+         * @return The OpenGL ID of the VAO.
+         */
+        const GLuint getVAOID() const
+        { return this->vaoID; }
+        /**
+         * Retrieves the OpenGL ID of the shared vertex buffer.
+         *
+         * @return The OpenGL ID of the vertex buffer.
+         */
+        const GLuint getVertexBufferID() const
+        { return this->vertexBufferID; }
+        /**
+         * Retrieves the OpenGL ID of the shared index buffer.
+         *
+         * @return The OpenGL ID of the index buffer.
+         */
+        const GLuint getIndexBufferID() const
+        { return this->indexBufferID; }
+        /**
+         * Retrieves the size of one vertex of the pool's meshes.
+         *
+         * @return The vertex stride in bytes.
+         */
+        const GLsizeiptr getVertexStride() const
+        { return this->vertexStride; }
+        /**
+         * Retrieves the vertex allocator, for inspecting usage and fragmentation.
+         *
+         * @return The vertex range allocator.
+         */
+        const kdr::Graphics::RangeAllocator& getVertexAllocator() const
+        { return this->vertexAllocator; }
+        /**
+         * Retrieves the index allocator, for inspecting usage and fragmentation.
+         *
+         * @return The index range allocator.
+         */
+        const kdr::Graphics::RangeAllocator& getIndexAllocator() const
+        { return this->indexAllocator; }
+        /**
+         * Checks whether a handle refers to a mesh in the pool.
+         *
+         * @param handle The mesh handle.
+         * @return True if the mesh exists, false otherwise.
+         */
+        const bool getIsValid(const kdr::Graphics::MeshHandle handle) const
+        { return handle < this->meshes.size() && this->meshes[handle].live; }
+        /**
+         * Retrieves where a mesh lives in the shared buffers.
+         *
+         * @param handle A valid mesh handle.
+         * @return The base vertex, first index and counts of the mesh.
+         */
+        const kdr::Graphics::MeshRange& getRange(const kdr::Graphics::MeshHandle handle) const
+        { return this->meshes[handle].range; }
+
+        /**
+         * Uploads a mesh into the pool, growing the shared buffers if needed.
+         *
+         * @param vertices    The vertex data, laid out with the pool's stride.
+         * @param vertexCount The number of vertices.
+         * @param indices     The indices, relative to the mesh's first vertex.
+         * @param indexCount  The number of indices.
+         * @return A handle to the mesh, or invalidMesh if the mesh is empty or doesn't fit.
+         */
+        kdr::Graphics::MeshHandle Add(const void* vertices, const GLuint vertexCount, const GLuint* indices, const GLuint indexCount);
+        /**
+         * Allocates space for a mesh without uploading anything, growing the shared buffers if
+         * needed. The caller fills the ranges given by getRange() later, e.g. by buffer copies.
+         *
+         * @param vertexCount The number of vertices.
+         * @param indexCount  The number of indices.
+         * @return A handle to the mesh, or invalidMesh if the mesh is empty or doesn't fit.
+         */
+        kdr::Graphics::MeshHandle Reserve(const GLuint vertexCount, const GLuint indexCount);
+        /**
+         * Frees the space of a mesh. The handle may be reused by a later Add().
+         *
+         * @param handle The mesh handle.
+         */
+        void Remove(const kdr::Graphics::MeshHandle handle);
+        /**
+         * Moves every mesh to the front of the shared buffers, merging all free space.
+         */
+        void Defragment();
+        /**
+         * Binds the pool's Vertex Array Object (VAO) for use.
+         */
+        void Bind()
+        { kdr::Graphics::getStateCache().bindVertexArray(this->vaoID); }
+        /**
+         * Draws a single mesh from the pool.
+         *
+         * @param handle The mesh handle.
+         * @param mode   The primitive type to render.
+         */
+        void Draw(const kdr::Graphics::MeshHandle handle, const GLenum mode = GL_TRIANGLES);
+        /**
+         * Deletes the shared buffers and the VAO from OpenGL memory.
+         */
+        void Delete();
+
+      private:
+        struct Slot
+        {
+          kdr::Graphics::MeshRange range;
+          bool                     live {false};
+        };
+
+        GLuint vaoID;
+        GLuint vertexBufferID;
+        GLuint indexBufferID;
+
+        GLsizeiptr                                 vertexStride;
+        std::vector<kdr::Graphics::VertexAttribute> attributes;
+
+        kdr::Graphics::RangeAllocator vertexAllocator;
+        kdr::Graphics::RangeAllocator indexAllocator;
+
+        std::vector<Slot>                      meshes;
+        std::vector<kdr::Graphics::MeshHandle> freeHandles;
+
+        /**
+         * Creates an uninitialized buffer of the given size.
+         *
+         * @param size The size of the new buffer in bytes.
+         * @return The OpenGL ID of the new buffer.
+         */
+        GLuint _createBuffer(const GLsizeiptr size);
+        /**
+         * Replaces a shared buffer with a larger one holding the same contents.
+         *
+         * @param bufferID The buffer to replace. Receives the new ID.
+         * @param oldSize  The current size in bytes.
+         * @param newSize  The new size in bytes.
+         */
+        void _growBuffer(GLuint& bufferID, const GLsizeiptr oldSize, const GLsizeiptr newSize);
+        /**
+         * Points the VAO at the current shared buffers.
+         */
+        void _link();
+    };
+  }
+}
+
+#endif // KDR_MESH_POOL_HPP
@@ -0,0 +1,132 @@
+#ifndef KDR_OCCLUSION_HPP
+#define KDR_OCCLUSION_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Space.hpp"
+#include "Bounds.hpp"
+#include "Graphics.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Hides objects behind occluders using hardware occlusion queries on their bounding boxes.
+     *
+     * Every frame, cull() sorts the frustum-visible objects by the latest finished query of each,
+     * without waiting on the GPU. Query() then rasterizes the bounding boxes against the depth
+     * pre-pass, and its queries decide the next frame. Objects hidden last time are handed out as
+     * conditional draws, so the GPU still draws them in the frame they come into view.
+     */
+    class OcclusionCuller
+    {
+      public:
+        /**
+         * Constructs an occlusion culler and its bounding box program.
+         */
+        OcclusionCuller();
+
+        /**
+         * Retrieves the number of queries issued by the last Query().
+         *
+         * @return The number of queries.
+         */
+        const size_t getQueryCount() const
+        { return this->queryCount; }
+        /**
+         * Retrieves the number of objects the last cull() found hidden, which are only drawn
+         * conditionally.
+         *
+         * @return The number of occluded objects.
+         */
+        const size_t getOccludedCount() const
+        { return this->occludedCount; }
+        /**
+         * Retrieves the distance around the camera within which objects are never culled.
+         *
+         * @return The margin in world units.
+         */
+        const float getCameraMargin() const
+        { return this->cameraMargin; }
+        /**
+         * Retrieves the query that decides a conditional draw of an object this frame. It may still
+         * be in flight from an earlier frame, in which case the draw is not skipped.
+         *
+         * @param objectID The object ID.
+         * @return The OpenGL ID of the query, to be used as DrawCommand::conditionQuery.
+         */
+        const GLuint getQuery(const uint32_t objectID) const
+        { return objectID < this->objects.size() ? this->objects[objectID].query : 0; }
+
+        /**
+         * Sets the distance around the camera within which objects are never culled. Boxes this
+         * close may be clipped by the near plane, which would make their queries fail.
+         *
+         * @param cameraMargin The margin in world units, at least the camera's near distance.
+         */
+        void setCameraMargin(const float cameraMargin)
+        { this->cameraMargin = cameraMargin; }
+
+        /**
+         * Sorts frustum-visible objects by their last known visibility and queues their queries.
+         *
+         * @param cameraPosition The world position of the camera.
+         * @param bounds         The world bounds of every object, indexed by object ID.
+         * @param candidates     The IDs of the objects inside the frustum.
+         * @param visible        Receives the IDs of the objects to draw normally. Cleared first.
+         * @param conditional    Receives the IDs of the objects to draw conditioned on getQuery(). Cleared first.
+         */
+        void cull(
+          const kdr::Space::Vec3& cameraPosition,
+          const std::vector<kdr::Space::AABB>& bounds,
+          const std::vector<uint32_t>& candidates,
+          std::vector<uint32_t>& visible,
+          std::vector<uint32_t>& conditional
+        );
+        /**
+         * Issues the queries queued by the last cull() against the bound depth buffer. Meant to
+         * run right after the depth pre-pass, such as from Renderer::setPrePassCallback().
+         */
+        void Query();
+        /**
+         * Deletes the queries and the bounding box program from OpenGL memory.
+         */
+        void Delete();
+
+      private:
+        struct ObjectState
+        {
+          GLuint query     {0};
+          bool   isPending {false};
+          bool   isVisible {true};
+        };
+
+        kdr::Graphics::Shader* shader {NULL};
+        kdr::Graphics::VAO*    VAO    {NULL};
+        kdr::Graphics::VBO*    VBO    {NULL};
+        kdr::Graphics::EBO*    EBO    {NULL};
+        GLint boxMinLocation {-1};
+        GLint boxMaxLocation {-1};
+
+        std::vector<ObjectState>      objects;
+        std::vector<uint32_t>         queuedIDs;
+        std::vector<kdr::Space::AABB> queuedBounds;
+
+        float  cameraMargin  {0.5f};
+        size_t queryCount    {0};
+        size_t occludedCount {0};
+
+        /**
+         * Reads the result of an object's query if the GPU has finished it.
+         *
+         * @param state The object state.
+         */
+        void _poll(ObjectState& state);
+    };
+  }
+}
+
+#endif // KDR_OCCLUSION_HPP
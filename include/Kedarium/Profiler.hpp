@@ -0,0 +1,258 @@
+#ifndef KDR_PROFILER_HPP
+#define KDR_PROFILER_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define KDR_PROFILE_CONCAT_INNER(a, b) a##b
+#define KDR_PROFILE_CONCAT(a, b) KDR_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef KDR_PROFILER_ENABLED
+  /**
+   * Times the rest of the enclosing block on the CPU. The name must be a string literal.
+   */
+  #define KDR_PROFILE_SCOPE(name) kdr::Profile::Scope KDR_PROFILE_CONCAT(kdrProfileScope, __LINE__) {name}
+  /**
+   * Times the GPU work issued in the rest of the enclosing block. The name must be a string literal.
+   */
+  #define KDR_PROFILE_GPU_SCOPE(name) kdr::Profile::GpuScope KDR_PROFILE_CONCAT(kdrProfileGpuScope, __LINE__) {name}
+#else
+  #define KDR_PROFILE_SCOPE(name)
+  #define KDR_PROFILE_GPU_SCOPE(name)
+#endif
+
+namespace kdr
+{
+  namespace Profile
+  {
+    /**
+     * A timed CPU scope. Times are in seconds since the profiler was created.
+     */
+    struct CpuEvent
+    {
+      const char* name;
+      double      start;
+      double      duration;
+      uint32_t    thread;
+      uint32_t    depth;
+    };
+
+    /**
+     * A timed GPU scope. The start is the CPU time at which its commands were issued.
+     */
+    struct GpuEvent
+    {
+      const char* name;
+      double      start;
+      double      duration;
+    };
+
+    /**
+     * Everything recorded during one frame.
+     */
+    struct FrameRecord
+    {
+      uint64_t                           index    {0};
+      double                             start    {0.};
+      double                             duration {0.};
+      std::vector<kdr::Profile::CpuEvent> cpuEvents;
+      std::vector<kdr::Profile::GpuEvent> gpuEvents;
+    };
+
+    /**
+     * Records CPU scopes and GPU timer queries for the last frames in a ring buffer.
+     *
+     * GPU results are read back a few frames late from a rotating set of query pools,
+     * so the CPU never waits on the GPU to report a timing.
+     */
+    class Profiler
+    {
+      public:
+        /**
+         * Constructs a profiler holding the default number of frames.
+         */
+        Profiler();
+
+        /**
+         * Checks whether frames are being recorded.
+         *
+         * @return True if the profiler is enabled, false otherwise.
+         */
+        const bool getIsEnabled() const
+        { return this->isEnabled; }
+        /**
+         * Retrieves the number of frames kept in the ring buffer.
+         *
+         * @return The frame capacity.
+         */
+        const size_t getFrameCapacity() const
+        { return this->frames.size(); }
+        /**
+         * Retrieves the number of frames recorded since the profiler was enabled.
+         *
+         * @return The number of recorded frames.
+         */
+        const uint64_t getFrameCount() const
+        { return this->frameCount; }
+
+        /**
+         * Enables or disables recording. Takes effect at the next frame.
+         *
+         * @param enabled True to record frames, false to stop.
+         */
+        void setIsEnabled(const bool enabled)
+        { this->isEnabled = enabled; }
+        /**
+         * Sets the number of frames kept in the ring buffer, discarding recorded frames.
+         *
+         * @param capacity The frame capacity. Values below the usual GPU readback latency are raised to it.
+         */
+        void setFrameCapacity(const size_t capacity);
+
+        /**
+         * Retrieves the recorded frames, oldest first. GPU events of the newest frames may still be missing.
+         *
+         * @return The recorded frames.
+         */
+        std::vector<const kdr::Profile::FrameRecord*> getFrames() const;
+        /**
+         * Retrieves the seconds elapsed since the profiler was created.
+         *
+         * @return The current profiler time.
+         */
+        double getTime() const
+        { return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->epoch).count(); }
+
+        /**
+         * Starts recording a frame.
+         */
+        void beginFrame();
+        /**
+         * Finishes the current frame and collects the GPU timings of an older one.
+         */
+        void endFrame();
+        /**
+         * Records a finished CPU scope into the current frame. Safe to call from any thread.
+         *
+         * @param name  The name of the scope. Must outlive the profiler.
+         * @param start The start of the scope in profiler time.
+         * @param end   The end of the scope in profiler time.
+         * @param depth The nesting depth of the scope on its thread.
+         */
+        void recordCpu(const char* name, const double start, const double end, const uint32_t depth);
+        /**
+         * Starts a GPU timer query. Timer queries cannot nest, so inner GPU scopes are ignored.
+         *
+         * @param name The name of the scope. Must outlive the profiler.
+         * @return True if a query was started, false otherwise.
+         */
+        bool beginGpu(const char* name);
+        /**
+         * Ends the GPU timer query started by beginGpu().
+         */
+        void endGpu();
+        /**
+         * Writes the recorded frames in the Chrome trace event format, for chrome://tracing or Perfetto.
+         *
+         * @param path The path of the JSON file.
+         * @return True if the file was written, false otherwise.
+         */
+        bool exportChromeTrace(const std::string& path) const;
+        /**
+         * Deletes the timer queries from OpenGL memory.
+         */
+        void Delete();
+
+      private:
+        struct PendingQuery
+        {
+          const char* name;
+          double      start;
+          GLuint      query;
+          uint64_t    frameIndex;
+        };
+
+        // GPU results usually arrive a few frames late, and their frame has to still be recorded
+        static constexpr size_t minFrameCapacity {3};
+
+        std::chrono::steady_clock::time_point epoch;
+
+        bool     isEnabled     {false};
+        bool     isFrameActive {false};
+        bool     isGpuActive   {false};
+        uint64_t frameCount    {0};
+
+        std::vector<kdr::Profile::FrameRecord> frames;
+        mutable std::mutex                     mutex;
+
+        std::vector<GLuint>       freeQueries;
+        std::deque<PendingQuery>  pendingQueries;
+
+        /**
+         * Reads back the queries the GPU has finished, oldest first, into their frame records if
+         * still in the ring. Queries without a result yet are kept for a later frame.
+         */
+        void _resolve();
+    };
+
+    /**
+     * Retrieves the profiler shared by the whole engine.
+     *
+     * @return A reference to the profiler.
+     */
+    kdr::Profile::Profiler& getProfiler();
+
+    /**
+     * Records the lifetime of a block as a CPU event.
+     */
+    class Scope
+    {
+      public:
+        /**
+         * Starts timing a scope.
+         *
+         * @param name The name of the scope. Must outlive the profiler.
+         */
+        Scope(const char* name);
+        /**
+         * Stops timing the scope and records it.
+         */
+        ~Scope();
+
+      private:
+        const char* name;
+        double      start {-1.};
+    };
+
+    /**
+     * Records the GPU work issued during the lifetime of a block as a GPU event.
+     */
+    class GpuScope
+    {
+      public:
+        /**
+         * Starts a GPU timer query.
+         *
+         * @param name The name of the scope. Must outlive the profiler.
+         */
+        GpuScope(const char* name)
+        { this->isActive = kdr::Profile::getProfiler().beginGpu(name); }
+        /**
+         * Ends the GPU timer query.
+         */
+        ~GpuScope()
+        { if (this->isActive) kdr::Profile::getProfiler().endGpu(); }
+
+      private:
+        bool isActive {false};
+    };
+  }
+}
+
+#endif // KDR_PROFILER_HPP
@@ -0,0 +1,126 @@
+#ifndef KDR_PROGRAM_CACHE_HPP
+#define KDR_PROGRAM_CACHE_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <iostream>
+#include <string>
+
+#include "File.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Counters describing how well the program binary cache performed.
+     */
+    struct ProgramCacheStats
+    {
+      unsigned int hits       {0};
+      unsigned int misses     {0};
+      unsigned int rejections {0};
+      double compileSeconds   {0.};
+      double loadSeconds      {0.};
+      double savedSeconds     {0.};
+
+      /**
+       * Retrieves the share of lookups that were served from the cache.
+       *
+       * @return The hit rate between 0 and 1.
+       */
+      const double getHitRate() const
+      {
+        const unsigned int lookups = this->hits + this->misses;
+        return lookups > 0 ? (double)this->hits / lookups : 0.;
+      }
+    };
+
+    /**
+     * Stores linked program binaries on disk so later runs can skip GLSL compilation.
+     *
+     * Entries are keyed by a hash of the shader sources together with the vendor, renderer
+     * and version strings of the driver, so a driver update simply misses the cache.
+     */
+    class ProgramCache
+    {
+      public:
+        /**
+         * Retrieves the directory the cache reads from and writes to.
+         *
+         * @return The cache directory, or an empty string if the cache is disabled.
+         */
+        const std::string& getDirectory() const
+        { return this->directory; }
+        /**
+         * Checks whether programs are looked up in and stored to the cache.
+         *
+         * @return True if the cache is enabled, false otherwise.
+         */
+        const bool getIsEnabled() const
+        { return !this->directory.empty(); }
+        /**
+         * Retrieves the cache counters accumulated since startup.
+         *
+         * @return The cache statistics.
+         */
+        const kdr::Graphics::ProgramCacheStats& getStats() const
+        { return this->stats; }
+
+        /**
+         * Enables the cache in a directory, creating it if needed. Requires a current context.
+         *
+         * @param directory The cache directory, or an empty string to disable the cache.
+         * @return True if the cache is usable, false if the driver cannot retrieve program binaries.
+         */
+        bool setDirectory(const std::string& directory);
+        /**
+         * Computes the cache key of a program for the current driver.
+         *
+         * @param vertexSource   The vertex shader source.
+         * @param fragmentSource The fragment shader source.
+         * @return The cache key.
+         */
+        uint64_t makeKey(const std::string& vertexSource, const std::string& fragmentSource);
+        /**
+         * Loads a cached binary into a program object.
+         *
+         * @param programID The OpenGL ID of an unlinked program.
+         * @param key       The cache key of the program.
+         * @return True if the program was linked from the cache, false on a miss or a rejected binary.
+         */
+        bool load(const GLuint programID, const uint64_t key);
+        /**
+         * Writes the binary of a freshly linked program to the cache.
+         *
+         * @param programID      The OpenGL ID of the linked program.
+         * @param key            The cache key of the program.
+         * @param compileSeconds The time it took to compile and link the program.
+         */
+        void store(const GLuint programID, const uint64_t key, const double compileSeconds);
+
+      private:
+        std::string directory;
+        std::string driverSignature;
+
+        kdr::Graphics::ProgramCacheStats stats;
+
+        /**
+         * Builds the path of the cache entry for a key.
+         *
+         * @param key The cache key.
+         * @return The path of the cache entry.
+         */
+        std::string _getPath(const uint64_t key) const;
+    };
+
+    /**
+     * Retrieves the program binary cache shared by every shader.
+     *
+     * @return A reference to the program binary cache.
+     */
+    kdr::Graphics::ProgramCache& getProgramCache();
+  }
+}
+
+#endif // KDR_PROGRAM_CACHE_HPP
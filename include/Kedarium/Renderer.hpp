@@ -0,0 +1,253 @@
+#ifndef KDR_RENDERER_HPP
+#define KDR_RENDERER_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include "Graphics.hpp"
+#include "MeshPool.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Represents a single deferred indexed draw.
+     */
+    struct DrawCommand
+    {
+      uint64_t   key;
+      GLuint     shaderID;
+      GLuint     vaoID;
+      uint16_t   material;
+      GLenum     mode;
+      GLsizei    count;
+      GLsizeiptr offset;
+      GLint      baseVertex     {0};
+      GLsizei    instanceCount  {1};
+      GLuint     baseInstance   {0};
+      bool       isOccluder     {false}; // Also drawn into the depth pre-pass
+      GLuint     conditionQuery {0};     // Occlusion query the draw is conditioned on, or 0
+    };
+
+    /**
+     * Mirrors the command layout read by glMultiDrawElementsIndirect.
+     */
+    struct DrawElementsIndirectCommand
+    {
+      GLuint count;
+      GLuint instanceCount;
+      GLuint firstIndex;
+      GLint  baseVertex;
+      GLuint baseInstance;
+    };
+
+    /**
+     * Collects draw submissions during a frame and issues them in state-sorted order.
+     */
+    class Renderer
+    {
+      public:
+        /**
+         * Builds the 64-bit sort key of a draw, ordered by shader, VAO, material and depth.
+         *
+         * Only the low 16 bits of each ID take part in the ordering; binds are still decided
+         * on the full IDs, so collisions cost extra binds but never wrong state.
+         *
+         * @param shaderID The OpenGL ID of the shader program.
+         * @param vaoID    The OpenGL ID of the VAO.
+         * @param material A user-defined material identifier.
+         * @param depth    The non-negative view depth of the draw. Nearer draws sort first.
+         * @return The sort key.
+         */
+        static uint64_t makeSortKey(const GLuint shaderID, const GLuint vaoID, const uint16_t material, const float depth);
+
+        /**
+         * Retrieves the number of draws submitted before the last flush.
+         *
+         * @return The number of submitted draws.
+         */
+        const size_t getSubmittedCount() const
+        { return this->submittedCount; }
+        /**
+         * Retrieves the number of draw calls issued by the last flush.
+         *
+         * @return The number of draw calls.
+         */
+        const size_t getDrawCallCount() const
+        { return this->drawCallCount; }
+        /**
+         * Retrieves the number of shader program binds issued by the last flush.
+         *
+         * @return The number of program binds.
+         */
+        const size_t getProgramBindCount() const
+        { return this->programBindCount; }
+        /**
+         * Retrieves the number of VAO binds issued by the last flush.
+         *
+         * @return The number of VAO binds.
+         */
+        const size_t getVAOBindCount() const
+        { return this->vaoBindCount; }
+        /**
+         * Retrieves the number of occluder draws in the depth pre-pass of the last flush.
+         *
+         * @return The number of occluder draws.
+         */
+        const size_t getOccluderCount() const
+        { return this->occluderCount; }
+        /**
+         * Checks whether flushes are submitted through glMultiDrawElementsIndirect.
+         *
+         * @return True if indirect mode is enabled and supported by the context, false otherwise.
+         */
+        const bool getIsIndirectActive() const;
+
+        /**
+         * Enables or disables multi-draw indirect submission. Contexts without GL 4.3 or
+         * ARB_multi_draw_indirect keep issuing one draw call per command.
+         *
+         * @param enabled True to submit through indirect command buffers, false to draw directly.
+         */
+        void setIsIndirectEnabled(const bool enabled)
+        { this->isIndirectEnabled = enabled; }
+
+        /**
+         * Sets the function called after a shader program is bound during a flush.
+         *
+         * @param callback The function receiving the OpenGL ID of the bound program.
+         */
+        void setProgramCallback(const std::function<void(GLuint)>& callback)
+        { this->programCallback = callback; }
+        /**
+         * Sets the function called when the material changes during a flush.
+         *
+         * @param callback The function receiving the material and the OpenGL ID of the bound program.
+         */
+        void setMaterialCallback(const std::function<void(uint16_t, GLuint)>& callback)
+        { this->materialCallback = callback; }
+        /**
+         * Sets the function called between the depth pre-pass and the main pass, while the
+         * occluder depth is bound. Occlusion queries such as OcclusionCuller::Query() go here.
+         *
+         * @param callback The function to call.
+         */
+        void setPrePassCallback(const std::function<void()>& callback)
+        { this->prePassCallback = callback; }
+
+        /**
+         * Queues an indexed draw of the provided VAO.
+         *
+         * @param shader     The shader program to draw with.
+         * @param VAO        The VAO holding the vertex and index bindings.
+         * @param mode       The primitive type to render.
+         * @param count      The number of indices to draw.
+         * @param material   A user-defined material identifier.
+         * @param depth      The non-negative view depth of the draw.
+         * @param offset     The byte offset of the first index in the EBO.
+         * @param isOccluder True to also draw it into the depth pre-pass.
+         */
+        void submit(
+          kdr::Graphics::Shader& shader,
+          kdr::Graphics::VAO& VAO,
+          const GLenum mode,
+          const GLsizei count,
+          const uint16_t material = 0,
+          const float depth = 0.f,
+          const GLsizeiptr offset = 0,
+          const bool isOccluder = false
+        );
+        /**
+         * Queues a draw of a mesh stored in a mesh pool.
+         *
+         * @param shader     The shader program to draw with.
+         * @param pool       The mesh pool holding the mesh.
+         * @param handle     The mesh handle.
+         * @param material   A user-defined material identifier.
+         * @param depth      The non-negative view depth of the draw.
+         * @param mode       The primitive type to render.
+         * @param isOccluder True to also draw it into the depth pre-pass.
+         */
+        void submit(
+          kdr::Graphics::Shader& shader,
+          kdr::Graphics::MeshPool& pool,
+          const kdr::Graphics::MeshHandle handle,
+          const uint16_t material = 0,
+          const float depth = 0.f,
+          const GLenum mode = GL_TRIANGLES,
+          const bool isOccluder = false
+        );
+        /**
+         * Queues a fully specified draw command. Its key should come from makeSortKey().
+         *
+         * @param command The draw command.
+         */
+        void submit(const kdr::Graphics::DrawCommand& command);
+        /**
+         * Sorts, merges and issues every queued draw, then clears the queue.
+         *
+         * Occluders are first drawn depth-only, after which the main pass tests with GL_LEQUAL
+         * so hidden fragments are rejected before shading.
+         */
+        void flush();
+        /**
+         * Deletes the indirect command buffer from OpenGL memory.
+         */
+        void Delete();
+
+      private:
+        std::vector<kdr::Graphics::DrawCommand> commands;
+
+        std::function<void(GLuint)>           programCallback;
+        std::function<void(uint16_t, GLuint)> materialCallback;
+        std::function<void()>                 prePassCallback;
+
+        size_t submittedCount   {0};
+        size_t drawCallCount    {0};
+        size_t programBindCount {0};
+        size_t vaoBindCount     {0};
+        size_t occluderCount    {0};
+
+        GLuint   boundShaderID {0};
+        GLuint   boundVAOID    {0};
+        uint16_t boundMaterial {0};
+        bool     hasMaterial   {false};
+
+        bool isBaseInstanceWarned {false};
+
+        bool                                                    isIndirectEnabled {false};
+        kdr::Graphics::StreamBuffer*                            indirectBuffer    {NULL};
+        std::vector<kdr::Graphics::DrawElementsIndirectCommand> indirectCommands;
+
+        /**
+         * Folds sorted commands that continue each other's index range into one.
+         */
+        void _merge();
+        /**
+         * Draws the occluders into the depth buffer only, then runs the pre-pass callback.
+         */
+        void _flushDepthPrePass();
+        /**
+         * Binds the program, VAO and material of a command where they differ from the current ones.
+         *
+         * @param command The draw command.
+         */
+        void _bind(const kdr::Graphics::DrawCommand& command);
+        /**
+         * Uploads the sorted commands as indirect commands and issues one multi-draw per state run.
+         */
+        void _flushIndirect();
+        /**
+         * Issues a single draw command against the currently bound state.
+         *
+         * @param command The draw command.
+         */
+        void _draw(const kdr::Graphics::DrawCommand& command);
+    };
+  }
+}
+
+#endif // KDR_RENDERER_HPP
@@ -0,0 +1,202 @@
+#ifndef KDR_RESIDENCY_HPP
+#define KDR_RESIDENCY_HPP
+
+#include <GL/glew.h>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Stream.hpp"
+#include "Texture.hpp"
+#include "TextureFile.hpp"
+
+namespace kdr
+{
+  namespace Stream
+  {
+    /**
+     * A texture streamed in mip by mip, from the coarsest level to the finest it needs.
+     *
+     * The asset turns resident once its coarse levels are uploaded. Finer levels keep arriving
+     * and may be evicted again afterwards, so the texture is the same object throughout but the
+     * detail it samples changes from frame to frame.
+     */
+    class TextureAsset : public kdr::Stream::Asset
+    {
+      public:
+        /**
+         * Retrieves the texture. Only valid once resident.
+         *
+         * @return A pointer to the texture, a Texture2D or a TextureArray.
+         */
+        kdr::Graphics::Texture* getTexture() const
+        { return this->texture; }
+        /**
+         * Retrieves the size the texture was last reported to cover on screen.
+         *
+         * @return The size in pixels.
+         */
+        const float getScreenSize() const
+        { return this->screenSize; }
+        /**
+         * Retrieves the mip level the texture needs at its current screen size.
+         *
+         * @return The wanted level.
+         */
+        const GLsizei getWantedLevel() const
+        { return this->wantedLevel; }
+
+        /**
+         * Reports how large the texture is drawn, e.g. by passing the size of the textured object
+         * to kdr::Mesh::LODSelector::getScreenError(). Drives which mip levels stay resident.
+         *
+         * @param screenSize The largest on-screen size of the texture this frame in pixels, or 0 if it is not visible.
+         */
+        void setScreenSize(const float screenSize)
+        { this->screenSize = screenSize; }
+
+      private:
+        std::shared_ptr<kdr::Graphics::TextureFile> file;
+        kdr::Graphics::Texture*                     texture {NULL};
+
+        float   screenSize   {INFINITY};
+        GLsizei wantedLevel  {0};
+        GLsizei definedLevel {0};
+        bool    isLoading    {false};
+        bool    isFailed     {false};
+
+        friend class TextureResidency;
+    };
+
+    /**
+     * Keeps the mip levels of streamed textures in video memory under a budget.
+     *
+     * Every frame, each texture asks for the level whose size matches its on-screen size. Missing
+     * levels are streamed in through the streamer, coarsest first and most needed texture first.
+     * When the budget runs out, the finest levels of the textures that need them least are
+     * released, starting with levels finer than their texture wants.
+     */
+    class TextureResidency
+    {
+      public:
+        /**
+         * Constructs a residency manager.
+         *
+         * @param streamer The streamer to upload through. Must outlive the manager.
+         * @param budget   The video memory textures may take, in bytes.
+         */
+        TextureResidency(kdr::Stream::Streamer& streamer, const GLsizeiptr budget = 256 << 20)
+        : streamer(streamer), budget(budget) {}
+        TextureResidency(const TextureResidency&) = delete;
+        TextureResidency& operator=(const TextureResidency&) = delete;
+
+        /**
+         * Retrieves the video memory textures may take.
+         *
+         * @return The budget in bytes.
+         */
+        const GLsizeiptr getBudget() const
+        { return this->budget; }
+        /**
+         * Retrieves the video memory taken by the defined mip levels of every texture.
+         *
+         * @return The size in bytes.
+         */
+        const GLsizeiptr getMemorySize() const
+        { return this->memorySize; }
+        /**
+         * Retrieves the number of textures being managed.
+         *
+         * @return The number of textures.
+         */
+        const size_t getTextureCount() const
+        { return this->assets.size(); }
+        /**
+         * Retrieves the number of level uploads that may be in flight at once.
+         *
+         * @return The maximum number of loads.
+         */
+        const size_t getMaxLoadCount() const
+        { return this->maxLoadCount; }
+
+        /**
+         * Sets the video memory textures may take. Levels over the budget are released during
+         * the next Update().
+         *
+         * @param budget The budget in bytes.
+         */
+        void setBudget(const GLsizeiptr budget)
+        { this->budget = budget; }
+        /**
+         * Sets the number of level uploads that may be in flight at once. Fewer loads keep the
+         * upload order closer to the current priorities.
+         *
+         * @param maxLoadCount The maximum number of loads, at least 1.
+         */
+        void setMaxLoadCount(const size_t maxLoadCount)
+        { this->maxLoadCount = maxLoadCount > 0 ? maxLoadCount : 1; }
+
+        /**
+         * Streams a KTX2 or DDS texture. Files with more than one layer become texture arrays.
+         * The texture is unloaded once the returned asset is no longer referenced.
+         *
+         * @param path The path to the texture file.
+         * @return The asset, resident once its coarse levels are uploaded.
+         */
+        std::shared_ptr<kdr::Stream::TextureAsset> load(const std::string& path);
+        /**
+         * Picks the wanted level of every texture, releases levels over the budget and requests
+         * missing ones. Called once per frame by the window, before Streamer::Update().
+         */
+        void Update();
+        /**
+         * Deletes every texture. The streamer must have been deleted first, so that no upload
+         * is left writing into them.
+         */
+        void Delete();
+
+      private:
+        kdr::Stream::Streamer& streamer;
+        GLsizeiptr             budget;
+        GLsizeiptr             memorySize   {0};
+        size_t                 loadCount    {0};
+        size_t                 maxLoadCount {4};
+
+        std::vector<std::shared_ptr<kdr::Stream::TextureAsset>> assets;
+        std::vector<std::shared_ptr<kdr::Stream::TextureAsset>> openedAssets;
+        std::mutex                                              openedMutex;
+
+        /**
+         * Creates the textures of the files the I/O thread opened since the last frame.
+         */
+        void _adoptOpened();
+        /**
+         * Releases the finest defined level of a texture.
+         *
+         * @param asset The texture asset.
+         */
+        void _evict(kdr::Stream::TextureAsset& asset);
+        /**
+         * Releases levels finer than wanted from textures less in need than a given one, until a
+         * number of bytes fits into the budget.
+         *
+         * @param size     The number of bytes to make room for.
+         * @param priority The priority of the texture that needs the room.
+         * @param except   The texture that needs the room.
+         * @return True if the bytes fit into the budget, false otherwise.
+         */
+        bool _makeRoom(const GLsizeiptr size, const float priority, const kdr::Stream::TextureAsset* except);
+        /**
+         * Defines the levels of a texture down to a finer level and streams them in, coarsest first.
+         *
+         * @param asset The texture asset.
+         * @param level The finest level to load.
+         */
+        void _load(const std::shared_ptr<kdr::Stream::TextureAsset>& asset, const GLsizei level);
+    };
+  }
+}
+
+#endif // KDR_RESIDENCY_HPP
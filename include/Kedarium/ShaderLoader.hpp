@@ -0,0 +1,73 @@
+#ifndef KDR_SHADER_LOADER_HPP
+#define KDR_SHADER_LOADER_HPP
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+#include "Graphics.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Timings of the last batch built by a shader loader.
+     */
+    struct ShaderLoaderStats
+    {
+      size_t programCount  {0};
+      double readSeconds   {0.};
+      double submitSeconds {0.};
+    };
+
+    /**
+     * Builds many shader programs at once. Sources are read and preprocessed as jobs on the
+     * engine's scheduler while the calling thread submits each program to the driver as soon
+     * as it is available.
+     *
+     * The returned programs are deferred: with KHR_parallel_shader_compile the driver compiles
+     * them concurrently, and each one only blocks the first time it is used.
+     */
+    class ShaderLoader
+    {
+      public:
+        /**
+         * Retrieves the timings of the last call to load().
+         *
+         * @return The loader statistics.
+         */
+        const kdr::Graphics::ShaderLoaderStats& getStats() const
+        { return this->stats; }
+        /**
+         * Checks whether the driver compiles programs on its own threads.
+         *
+         * @return True if KHR_parallel_shader_compile is available, false otherwise.
+         */
+        static const bool getIsParallelCompileSupported()
+        { return GLEW_KHR_parallel_shader_compile; }
+
+        /**
+         * Queues a shader program to be built by the next call to load().
+         *
+         * @param vertexPath   The path to the vertex shader file.
+         * @param fragmentPath The path to the fragment shader file.
+         * @return The index of the program in the vector returned by load().
+         */
+        size_t add(const std::string& vertexPath, const std::string& fragmentPath);
+        /**
+         * Reads and submits every queued program, then clears the queue. Requires a current context.
+         *
+         * @return The deferred shader programs, in the order they were added.
+         */
+        std::vector<kdr::Graphics::Shader> load();
+
+      private:
+        std::vector<std::pair<std::string, std::string>> queued;
+
+        kdr::Graphics::ShaderLoaderStats stats;
+    };
+  }
+}
+
+#endif // KDR_SHADER_LOADER_HPP
@@ -2,6 +2,7 @@
 #define KDR_SPACE_HPP
 
 #include <math.h>
+#include <stddef.h>
 
 namespace kdr
 {
@@ -119,9 +120,9 @@ namespace kdr
     };
 
     /**
-     * Represents a 4x4 matrix.
+     * Represents a 4x4 matrix stored column by column, aligned for SIMD loads.
      */
-    class Mat4
+    class alignas(16) Mat4
     {
       public:
         float elements[4][4];
@@ -188,17 +189,7 @@ namespace kdr
          * @param other The matrix to multiply with.
          * @return The resulting matrix after multiplication.
          */
-        Mat4 operator*(const Mat4& other) const {
-          Mat4 result {0.f};
-          for (int i = 0; i < 4; i++) {
-            for (int j = 0; j < 4; j++) {
-              for (int k = 0; k < 4; k++) {
-                result[i][j] += other[i][k] * elements[k][j];
-              }
-            }
-          }
-          return result;
-        }
+        Mat4 operator*(const Mat4& other) const;
     };
 
     /**
@@ -259,6 +250,40 @@ namespace kdr
      * @return The view matrix.
      */
     kdr::Space::Mat4 lookAt(const kdr::Space::Vec3& eye, const kdr::Space::Vec3& target, const kdr::Space::Vec3& up);
+    /**
+     * Creates a model matrix from a translation, a rotation and a scale.
+     *
+     * @param position The translation of the model.
+     * @param rotation The rotation around the x, y and z axes in degrees, applied as yaw * pitch * roll.
+     * @param scale    The scale along each axis.
+     * @return The model matrix (translation * rotation * scale).
+     */
+    kdr::Space::Mat4 compose(const kdr::Space::Vec3& position, const kdr::Space::Vec3& rotation, const kdr::Space::Vec3& scale);
+
+    /**
+     * Multiplies pairs of matrices, writing out[i] = a[i] * b[i] for every i.
+     *
+     * @param a   The left-hand matrices.
+     * @param b   The right-hand matrices.
+     * @param out The destination matrices. May alias either input.
+     * @param n   The number of matrix pairs.
+     */
+    void multiplyMany(const kdr::Space::Mat4* a, const kdr::Space::Mat4* b, kdr::Space::Mat4* out, const size_t n);
+    /**
+     * Transforms points by a matrix, treating each point as (x, y, z, 1) without a perspective divide.
+     *
+     * @param mat The transformation matrix.
+     * @param in  The source points.
+     * @param out The destination points. May alias the source.
+     * @param n   The number of points.
+     */
+    void transformPoints(const kdr::Space::Mat4& mat, const kdr::Space::Vec3* in, kdr::Space::Vec3* out, const size_t n);
+    /**
+     * Retrieves the name of the SIMD path the math kernels were compiled with.
+     *
+     * @return "avx2", "sse" or "scalar".
+     */
+    const char* getSimdPath();
   }
 }
 
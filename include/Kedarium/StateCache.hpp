@@ -0,0 +1,245 @@
+#ifndef KDR_STATE_CACHE_HPP
+#define KDR_STATE_CACHE_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Tracks the OpenGL state set through the engine and skips calls that would not change it.
+     *
+     * The cache assumes it is the only writer of the state it tracks. Code that changes the same
+     * state with raw OpenGL calls must call invalidate() afterwards.
+     */
+    class GLStateCache
+    {
+      public:
+        /**
+         * Retrieves the OpenGL ID of the program in use.
+         *
+         * @return The OpenGL ID of the program in use.
+         */
+        const GLuint getProgram() const
+        { return this->program; }
+        /**
+         * Retrieves the OpenGL ID of the bound Vertex Array Object (VAO), to restore it after
+         * editing another one.
+         *
+         * @return The OpenGL ID of the bound VAO, or 0 while it is unknown after invalidate().
+         */
+        const GLuint getVertexArray() const
+        { return this->vertexArray != Unknown ? this->vertexArray : 0; }
+        /**
+         * Checks whether depth testing is enabled, to restore it after a pass that changes it.
+         *
+         * @return True if depth testing is enabled, false otherwise. Asks OpenGL while it is unknown after invalidate().
+         */
+        const bool getDepthTest() const
+        { return this->depthTest != -1 ? this->depthTest != 0 : glIsEnabled(GL_DEPTH_TEST) == GL_TRUE; }
+        /**
+         * Retrieves the number of OpenGL calls the cache let through.
+         *
+         * @return The number of issued calls.
+         */
+        const uint64_t getIssuedCount() const
+        { return this->issuedCount; }
+        /**
+         * Retrieves the number of OpenGL calls the cache skipped as redundant.
+         *
+         * @return The number of elided calls.
+         */
+        const uint64_t getElidedCount() const
+        { return this->elidedCount; }
+
+        /**
+         * Resets the issued and elided call counters.
+         */
+        void resetCounters()
+        {
+          this->issuedCount = 0;
+          this->elidedCount = 0;
+        }
+
+        /**
+         * Sets the shader program in use.
+         *
+         * @param program The OpenGL ID of the program.
+         */
+        void useProgram(const GLuint program);
+        /**
+         * Binds a buffer to a target.
+         *
+         * @param target The buffer target, such as GL_ARRAY_BUFFER.
+         * @param buffer The OpenGL ID of the buffer.
+         */
+        void bindBuffer(const GLenum target, const GLuint buffer);
+        /**
+         * Binds a buffer to an indexed binding point. This also binds it to the generic target.
+         *
+         * @param target The indexed buffer target, such as GL_UNIFORM_BUFFER.
+         * @param index  The binding point index.
+         * @param buffer The OpenGL ID of the buffer.
+         */
+        void bindBufferBase(const GLenum target, const GLuint index, const GLuint buffer);
+        /**
+         * Binds a Vertex Array Object (VAO).
+         *
+         * @param vertexArray The OpenGL ID of the VAO.
+         */
+        void bindVertexArray(const GLuint vertexArray);
+        /**
+         * Binds a texture to a texture unit, making the unit active even if the texture was
+         * already bound there.
+         *
+         * @param unit    The texture unit index.
+         * @param target  The texture target, such as GL_TEXTURE_2D.
+         * @param texture The OpenGL ID of the texture.
+         */
+        void bindTexture(const GLuint unit, const GLenum target, const GLuint texture);
+        /**
+         * Sets the polygon rasterization mode for front and back faces.
+         *
+         * @param mode GL_POINT, GL_LINE or GL_FILL.
+         */
+        void setPolygonMode(const GLenum mode);
+        /**
+         * Enables or disables depth testing.
+         *
+         * @param enabled True to enable depth testing, false to disable it.
+         */
+        void setDepthTest(const bool enabled);
+        /**
+         * Enables or disables depth buffer writes.
+         *
+         * @param enabled True to enable depth writes, false to disable them.
+         */
+        void setDepthMask(const bool enabled);
+        /**
+         * Sets the depth comparison function.
+         *
+         * @param function The comparison function, such as GL_LESS.
+         */
+        void setDepthFunc(const GLenum function);
+        /**
+         * Enables or disables blending.
+         *
+         * @param enabled True to enable blending, false to disable it.
+         */
+        void setBlend(const bool enabled);
+        /**
+         * Sets the blending factors.
+         *
+         * @param source      The source factor.
+         * @param destination The destination factor.
+         */
+        void setBlendFunc(const GLenum source, const GLenum destination);
+
+        /**
+         * Forgets a deleted program so a recycled ID isn't mistaken for the bound one.
+         *
+         * @param program The OpenGL ID of the deleted program.
+         */
+        void onProgramDeleted(const GLuint program);
+        /**
+         * Forgets a deleted buffer, which OpenGL unbinds from every target.
+         *
+         * @param buffer The OpenGL ID of the deleted buffer.
+         */
+        void onBufferDeleted(const GLuint buffer);
+        /**
+         * Forgets a deleted Vertex Array Object (VAO), which OpenGL unbinds if bound.
+         *
+         * @param vertexArray The OpenGL ID of the deleted VAO.
+         */
+        void onVertexArrayDeleted(const GLuint vertexArray);
+        /**
+         * Forgets a deleted texture, which OpenGL unbinds from every unit.
+         *
+         * @param texture The OpenGL ID of the deleted texture.
+         */
+        void onTextureDeleted(const GLuint texture);
+        /**
+         * Marks every tracked state as unknown so the next call of each kind reaches OpenGL.
+         */
+        void invalidate();
+
+      private:
+        enum BufferSlot
+        {
+          ArrayBufferSlot,
+          ElementArrayBufferSlot,
+          CopyReadBufferSlot,
+          CopyWriteBufferSlot,
+          UniformBufferSlot,
+          PixelPackBufferSlot,
+          PixelUnpackBufferSlot,
+          DrawIndirectBufferSlot,
+          BufferSlotCount
+        };
+        enum TextureSlot
+        {
+          Texture2DSlot,
+          Texture2DArraySlot,
+          TextureSlotCount
+        };
+
+        static constexpr GLuint Unknown = 0xFFFFFFFF;
+        static constexpr GLuint TextureUnitCount = 16;
+
+        GLuint program     {0};
+        GLuint vertexArray {0};
+        GLuint buffers[BufferSlotCount] {0, 0, 0, 0, 0, 0, 0, 0};
+        GLuint textureUnit {0};
+        GLuint textures[TextureUnitCount][TextureSlotCount] {};
+
+        GLenum polygonMode      {GL_FILL};
+        GLenum depthFunc        {GL_LESS};
+        GLenum blendSource      {GL_ONE};
+        GLenum blendDestination {GL_ZERO};
+        int    depthTest        {0};
+        int    depthMask        {1};
+        int    blend            {0};
+
+        uint64_t issuedCount {0};
+        uint64_t elidedCount {0};
+
+        /**
+         * Maps a buffer target to its tracking slot.
+         *
+         * @param target The buffer target.
+         * @return The slot index, or BufferSlotCount for untracked targets.
+         */
+        static int _getBufferSlot(const GLenum target);
+        /**
+         * Maps a texture target to its tracking slot.
+         *
+         * @param target The texture target.
+         * @return The slot index, or TextureSlotCount for untracked targets.
+         */
+        static int _getTextureSlot(const GLenum target);
+        /**
+         * Records whether a call was issued or elided.
+         *
+         * @param changed True if the call reached OpenGL.
+         * @return The value of changed.
+         */
+        bool _count(const bool changed)
+        {
+          changed ? this->issuedCount++ : this->elidedCount++;
+          return changed;
+        }
+    };
+
+    /**
+     * Retrieves the state cache shared by every engine object on the current context.
+     *
+     * @return A reference to the state cache.
+     */
+    kdr::Graphics::GLStateCache& getStateCache();
+  }
+}
+
+#endif // KDR_STATE_CACHE_HPP
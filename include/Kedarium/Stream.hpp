@@ -0,0 +1,310 @@
+#ifndef KDR_STREAM_HPP
+#define KDR_STREAM_HPP
+
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Graphics.hpp"
+#include "MeshPool.hpp"
+#include "Bounds.hpp"
+#include "Jobs.hpp"
+
+namespace kdr
+{
+  namespace Stream
+  {
+    /**
+     * Tracks one streamed resource from the request until it is resident on the GPU. States only
+     * ever move forward, and the results of an asset may be read once it is resident.
+     */
+    class Asset
+    {
+      public:
+        enum State
+        {
+          Loading,
+          Uploading,
+          Resident,
+          Failed
+        };
+
+        /**
+         * Retrieves the current state. Safe to call from any thread.
+         *
+         * @return The state of the asset.
+         */
+        const State getState() const
+        { return this->state.load(std::memory_order_acquire); }
+        /**
+         * Checks whether the asset has been uploaded and can be drawn.
+         *
+         * @return True if the asset is resident, false otherwise.
+         */
+        const bool getIsResident() const
+        { return this->getState() == Resident; }
+        /**
+         * Checks whether the asset is done, either resident or failed.
+         *
+         * @return True if the asset will not change anymore, false otherwise.
+         */
+        const bool getIsDone() const
+        { return this->getState() >= Resident; }
+
+        /**
+         * Moves the asset to a new state, publishing everything written before.
+         *
+         * @param state The new state.
+         */
+        void setState(const State state)
+        { this->state.store(state, std::memory_order_release); }
+
+      private:
+        std::atomic<State> state {Loading};
+    };
+
+    /**
+     * A mesh streamed into a mesh pool.
+     */
+    class MeshAsset : public kdr::Stream::Asset
+    {
+      public:
+        /**
+         * Retrieves the handle of the mesh in its pool. Only valid once resident.
+         *
+         * @return The mesh handle.
+         */
+        const kdr::Graphics::MeshHandle getHandle() const
+        { return this->handle; }
+        /**
+         * Retrieves the bounds of the mesh. Only valid once resident.
+         *
+         * @return The bounding box in model space.
+         */
+        const kdr::Space::AABB getBounds() const
+        { return this->bounds; }
+
+      private:
+        kdr::Graphics::MeshHandle handle {kdr::Graphics::invalidMesh};
+        kdr::Space::AABB          bounds;
+
+        friend class Streamer;
+    };
+
+    /**
+     * Describes one upload waiting for the GL thread. The source bytes are copied through the
+     * staging buffer in pieces, as many per frame as the budget allows.
+     */
+    struct Upload
+    {
+      const unsigned char*  data        {NULL};
+      GLsizeiptr            size        {0};
+      GLsizeiptr            granularity {1};
+      std::shared_ptr<void> owner;
+
+      // Runs on the GL thread before the first piece. Returning false fails the upload
+      std::function<bool()> begin;
+      // Issues the copy of one piece, given the staging buffer, the piece's offset in it, and its
+      // offset and size within the upload
+      std::function<void(GLuint, GLintptr, GLsizeiptr, GLsizeiptr)> write;
+      // Runs on the GL thread after the last piece, or when the upload failed
+      std::function<void(bool)> end;
+    };
+
+    /**
+     * Loads resources without stalling the frame. Files are read on an I/O thread and decoded on
+     * the job scheduler, and the resulting GPU uploads are drained once per frame by Update()
+     * under a time and byte budget, through a persistently mapped staging buffer.
+     */
+    class Streamer
+    {
+      public:
+        /**
+         * Constructs a streamer and starts its I/O thread. Needs a current OpenGL context.
+         *
+         * @param stagingSize The size of the staging region of one frame in bytes.
+         */
+        Streamer(const GLsizeiptr stagingSize = 8 << 20);
+        Streamer(const Streamer&) = delete;
+        Streamer& operator=(const Streamer&) = delete;
+        /**
+         * Stops the I/O thread.
+         */
+        ~Streamer();
+
+        /**
+         * Retrieves the upload time allowed per frame.
+         *
+         * @return The time budget in milliseconds.
+         */
+        const double getBudgetMilliseconds() const
+        { return this->budgetMilliseconds; }
+        /**
+         * Retrieves the number of bytes allowed to be uploaded per frame.
+         *
+         * @return The byte budget.
+         */
+        const GLsizeiptr getBudgetBytes() const
+        { return this->budgetBytes; }
+        /**
+         * Retrieves the number of bytes uploaded during the last Update().
+         *
+         * @return The number of bytes.
+         */
+        const GLsizeiptr getUploadedBytes() const
+        { return this->uploadedBytes; }
+        /**
+         * Retrieves the number of requests that are not resident or failed yet.
+         *
+         * @return The number of pending requests.
+         */
+        const size_t getPendingCount() const
+        { return this->pendingCount.load(std::memory_order_acquire); }
+
+        /**
+         * Sets the upload budget of one frame. At least one piece is uploaded per frame, so
+         * streaming always makes progress.
+         *
+         * @param milliseconds The time budget in milliseconds.
+         * @param bytes        The byte budget, capped by the staging size.
+         */
+        void setBudget(const double milliseconds, const GLsizeiptr bytes);
+
+        /**
+         * Streams a mesh file into a mesh pool. Cooked meshes are uploaded straight from their
+         * mapping; .obj, .gltf and .glb files are imported first and need the imported vertex layout.
+         *
+         * @param path  The path to the mesh file.
+         * @param pool  The mesh pool to store the mesh in. Must outlive the request.
+         * @param level The detail level to load from a cooked mesh.
+         * @return The asset, resident once the upload finished.
+         */
+        std::shared_ptr<kdr::Stream::MeshAsset> loadMesh(
+          const std::string& path,
+          kdr::Graphics::MeshPool& pool,
+          const unsigned int level = 0
+        );
+        /**
+         * Streams bytes into a range of an existing buffer object.
+         *
+         * @param bufferID The OpenGL ID of the buffer, e.g. VBO::getID(). Must outlive the request.
+         * @param offset   The byte offset to write to.
+         * @param data     The bytes to write.
+         * @return The asset, resident once the upload finished.
+         */
+        std::shared_ptr<kdr::Stream::Asset> writeBuffer(
+          const GLuint bufferID,
+          const GLintptr offset,
+          std::vector<unsigned char> data
+        );
+        /**
+         * Runs a job on the I/O thread, in request order. Meant for file reads; heavy decoding
+         * belongs on the job scheduler.
+         *
+         * @param job The work to run.
+         */
+        void read(const std::function<void()>& job);
+        /**
+         * Runs a job on the job scheduler, tracked so Delete() waits for it.
+         *
+         * @param job The work to run.
+         */
+        void decode(const std::function<void()>& job);
+        /**
+         * Queues an upload for the GL thread. Safe to call from any thread.
+         *
+         * @param upload The upload to queue.
+         */
+        void queue(const kdr::Stream::Upload& upload);
+        /**
+         * Counts a request as pending until finish() is called for it.
+         */
+        void start()
+        { this->pendingCount.fetch_add(1, std::memory_order_acq_rel); }
+        /**
+         * Marks a request as done, resident or failed.
+         *
+         * @param asset      The asset of the request.
+         * @param isResident True if the request succeeded, false otherwise.
+         */
+        void finish(kdr::Stream::Asset& asset, const bool isResident);
+
+        /**
+         * Uploads queued data until the frame budget is spent. Called once per frame by the window.
+         */
+        void Update();
+        /**
+         * Waits for the background work, drops the pending uploads and deletes the staging buffer.
+         *
+         * @param isEnding True to end the dropped uploads as failed, false to discard them without
+         *                 running their callbacks, for when their destinations may already be gone.
+         */
+        void Delete(const bool isEnding = true);
+
+      private:
+        kdr::Graphics::StreamBuffer staging;
+
+        double     budgetMilliseconds {2.};
+        GLsizeiptr budgetBytes        {4 << 20};
+        GLsizeiptr uploadedBytes      {0};
+
+        std::atomic<size_t>               pendingCount {0};
+        kdr::Jobs::Counter                decodeCounter;
+        std::thread                       ioThread;
+        std::deque<std::function<void()>> ioJobs;
+        std::mutex                        ioMutex;
+        std::condition_variable           ioCondition;
+        bool                              isStopping   {false};
+
+        std::deque<kdr::Stream::Upload> queuedUploads;
+        std::mutex                      uploadMutex;
+        std::deque<kdr::Stream::Upload> activeUploads;
+        bool                            isActiveStarted {false};
+        GLsizeiptr                      activeUploaded  {0};
+
+        /**
+         * Runs the I/O jobs until the streamer stops and no job is left.
+         */
+        void _runIOThread();
+        /**
+         * Lets the I/O thread finish its jobs and joins it.
+         */
+        void _stopIOThread();
+        /**
+         * Ends the upload at the front of the active queue and removes it.
+         *
+         * @param isSuccessful True if every piece was uploaded, false otherwise.
+         */
+        void _endActive(const bool isSuccessful);
+        /**
+         * Queues the uploads of one mesh, whose bytes are kept alive by an owner.
+         *
+         * @param asset       The asset to complete.
+         * @param pool        The mesh pool to store the mesh in.
+         * @param owner       Keeps the vertex and index data alive until the upload ends.
+         * @param vertices    The vertex data.
+         * @param vertexCount The number of vertices.
+         * @param indices     The indices.
+         * @param indexCount  The number of indices.
+         */
+        void _queueMesh(
+          const std::shared_ptr<kdr::Stream::MeshAsset>& asset,
+          kdr::Graphics::MeshPool& pool,
+          const std::shared_ptr<void>& owner,
+          const void* vertices,
+          const GLuint vertexCount,
+          const GLuint* indices,
+          const GLuint indexCount
+        );
+    };
+  }
+}
+
+#endif // KDR_STREAM_HPP
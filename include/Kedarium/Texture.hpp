@@ -0,0 +1,298 @@
+#ifndef KDR_TEXTURE_HPP
+#define KDR_TEXTURE_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+
+#include "StateCache.hpp"
+#include "TextureFile.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Checks whether the current context can sample a texture format as is. Block compressed
+     * formats are never decompressed on the CPU, so files in unsupported formats cannot be used.
+     *
+     * @param format The texture format.
+     * @return True if the format is supported, false otherwise.
+     */
+    bool isTextureFormatSupported(const kdr::Graphics::TextureFormat& format);
+
+    /**
+     * Represents an OpenGL texture whose mip levels are defined one at a time.
+     *
+     * Only the levels from the base level down to the coarsest are sampled, so a texture can be
+     * drawn while its finer levels are still streaming in, and their storage can be released
+     * again when memory runs short.
+     */
+    class Texture
+    {
+      public:
+        /**
+         * Retrieves the OpenGL ID of the texture.
+         *
+         * @return The OpenGL ID of the texture.
+         */
+        const GLuint getID() const
+        { return this->ID; }
+        /**
+         * Retrieves the texture target, GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+         *
+         * @return The texture target.
+         */
+        const GLenum getTarget() const
+        { return this->target; }
+        /**
+         * Retrieves the format of the texels.
+         *
+         * @return The texture format.
+         */
+        const kdr::Graphics::TextureFormat& getFormat() const
+        { return this->format; }
+        /**
+         * Retrieves the width of mip level 0.
+         *
+         * @return The width in texels.
+         */
+        const GLsizei getWidth() const
+        { return this->width; }
+        /**
+         * Retrieves the height of mip level 0.
+         *
+         * @return The height in texels.
+         */
+        const GLsizei getHeight() const
+        { return this->height; }
+        /**
+         * Retrieves the number of array layers.
+         *
+         * @return The number of layers, 1 for a 2D texture.
+         */
+        const GLsizei getLayerCount() const
+        { return this->layerCount; }
+        /**
+         * Retrieves the number of mip levels.
+         *
+         * @return The number of levels.
+         */
+        const GLsizei getLevelCount() const
+        { return this->levelCount; }
+        /**
+         * Retrieves the finest mip level that is sampled.
+         *
+         * @return The base level, or getLevelCount() while no level is sampled.
+         */
+        const GLsizei getBaseLevel() const
+        { return this->baseLevel; }
+        /**
+         * Retrieves the storage taken by the defined mip levels.
+         *
+         * @return The size in bytes.
+         */
+        const GLsizeiptr getMemorySize() const
+        { return this->memorySize; }
+        /**
+         * Checks whether a mip level has storage.
+         *
+         * @param level The mip level.
+         * @return True if the level is defined, false otherwise.
+         */
+        const bool getIsDefined(const GLsizei level) const
+        { return (this->definedLevels >> level & 1) != 0; }
+        /**
+         * Computes the width of a mip level.
+         *
+         * @param level The mip level.
+         * @return The width in texels.
+         */
+        const GLsizei getLevelWidth(const GLsizei level) const
+        { return (this->width >> level) > 0 ? this->width >> level : 1; }
+        /**
+         * Computes the height of a mip level.
+         *
+         * @param level The mip level.
+         * @return The height in texels.
+         */
+        const GLsizei getLevelHeight(const GLsizei level) const
+        { return (this->height >> level) > 0 ? this->height >> level : 1; }
+        /**
+         * Computes the storage of a mip level across all layers.
+         *
+         * @param level The mip level.
+         * @return The size in bytes.
+         */
+        const GLsizeiptr getLevelSize(const GLsizei level) const
+        { return this->format.getImageSize(this->getLevelWidth(level), this->getLevelHeight(level)) * this->layerCount; }
+
+        /**
+         * Allocates the storage of a mip level for every layer, leaving its contents undefined.
+         *
+         * @param level The mip level.
+         */
+        void Define(const GLsizei level);
+        /**
+         * Frees the storage of a mip level, moving the base level past it first if needed.
+         *
+         * @param level The mip level.
+         */
+        void Release(const GLsizei level);
+        /**
+         * Overwrites rows of one layer of a defined mip level. Rows of block compressed formats
+         * must start on a block boundary.
+         *
+         * @param level  The mip level.
+         * @param layer  The array layer, 0 for a 2D texture.
+         * @param y      The first texel row.
+         * @param height The number of texel rows.
+         * @param data   The texel data, or a byte offset into the bound GL_PIXEL_UNPACK_BUFFER.
+         * @param size   The size of the data in bytes.
+         */
+        void Upload(
+          const GLsizei level,
+          const GLsizei layer,
+          const GLsizei y,
+          const GLsizei height,
+          const void* data,
+          const GLsizeiptr size
+        );
+        /**
+         * Sets the finest mip level to sample. Every level from it down to the coarsest must be
+         * defined and uploaded for the texture to be complete.
+         *
+         * @param level The base level, or getLevelCount() to sample none.
+         */
+        void setBaseLevel(const GLsizei level);
+        /**
+         * Defines and uploads every mip level from a texture file right away, then samples all of them.
+         *
+         * @param file A file with the format and size of the texture, and at least as many levels and layers.
+         * @return True if the file matches the texture, false otherwise.
+         */
+        bool Load(const kdr::Graphics::TextureFile& file);
+        /**
+         * Binds the texture to a texture unit.
+         *
+         * @param unit The texture unit index.
+         */
+        void Bind(const GLuint unit = 0)
+        { kdr::Graphics::getStateCache().bindTexture(unit, this->target, this->ID); }
+        /**
+         * Unbinds the texture from a texture unit.
+         *
+         * @param unit The texture unit index.
+         */
+        void Unbind(const GLuint unit = 0)
+        { kdr::Graphics::getStateCache().bindTexture(unit, this->target, 0); }
+        /**
+         * Deletes the texture from OpenGL memory.
+         */
+        void Delete();
+
+      protected:
+        /**
+         * Constructs a texture without any defined mip level.
+         *
+         * @param target     The texture target, GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+         * @param format     The format of the texels.
+         * @param width      The width of mip level 0 in texels.
+         * @param height     The height of mip level 0 in texels.
+         * @param layerCount The number of array layers.
+         * @param levelCount The number of mip levels, at most 16.
+         */
+        Texture(
+          const GLenum target,
+          const kdr::Graphics::TextureFormat& format,
+          const GLsizei width,
+          const GLsizei height,
+          const GLsizei layerCount,
+          const GLsizei levelCount
+        );
+
+      private:
+        GLuint                       ID;
+        GLenum                       target;
+        kdr::Graphics::TextureFormat format;
+        GLsizei                      width;
+        GLsizei                      height;
+        GLsizei                      layerCount;
+        GLsizei                      levelCount;
+        GLsizei                      baseLevel;
+
+        GLsizeiptr memorySize    {0};
+        uint32_t   definedLevels {0};
+
+        /**
+         * Binds the texture to unit 0 to be edited.
+         */
+        void _bind()
+        { kdr::Graphics::getStateCache().bindTexture(0, this->target, this->ID); }
+        /**
+         * Specifies the image of a mip level without data. A size of zero frees the level.
+         *
+         * @param level      The mip level.
+         * @param width      The width in texels.
+         * @param height     The height in texels.
+         * @param layerCount The number of layers.
+         */
+        void _specify(const GLsizei level, const GLsizei width, const GLsizei height, const GLsizei layerCount);
+    };
+
+    /**
+     * Represents an OpenGL 2D texture in the Kedarium Engine.
+     */
+    class Texture2D : public kdr::Graphics::Texture
+    {
+      public:
+        /**
+         * Constructs a 2D texture without any defined mip level.
+         *
+         * @param format     The format of the texels.
+         * @param width      The width of mip level 0 in texels.
+         * @param height     The height of mip level 0 in texels.
+         * @param levelCount The number of mip levels, at most 16.
+         */
+        Texture2D(const kdr::Graphics::TextureFormat& format, const GLsizei width, const GLsizei height, const GLsizei levelCount = 1)
+        : Texture(GL_TEXTURE_2D, format, width, height, 1, levelCount) {}
+        /**
+         * Constructs a 2D texture from the first layer of a texture file, uploading it right away.
+         *
+         * @param file An open texture file.
+         */
+        Texture2D(const kdr::Graphics::TextureFile& file);
+    };
+
+    /**
+     * Represents an OpenGL 2D texture array in the Kedarium Engine.
+     */
+    class TextureArray : public kdr::Graphics::Texture
+    {
+      public:
+        /**
+         * Constructs a texture array without any defined mip level.
+         *
+         * @param format     The format of the texels.
+         * @param width      The width of mip level 0 in texels.
+         * @param height     The height of mip level 0 in texels.
+         * @param layerCount The number of array layers.
+         * @param levelCount The number of mip levels, at most 16.
+         */
+        TextureArray(
+          const kdr::Graphics::TextureFormat& format,
+          const GLsizei width,
+          const GLsizei height,
+          const GLsizei layerCount,
+          const GLsizei levelCount = 1
+        ) : Texture(GL_TEXTURE_2D_ARRAY, format, width, height, layerCount, levelCount) {}
+        /**
+         * Constructs a texture array from every layer of a texture file, uploading it right away.
+         *
+         * @param file An open texture file.
+         */
+        TextureArray(const kdr::Graphics::TextureFile& file);
+    };
+  }
+}
+
+#endif // KDR_TEXTURE_HPP
@@ -0,0 +1,214 @@
+#ifndef KDR_TEXTURE_FILE_HPP
+#define KDR_TEXTURE_FILE_HPP
+
+#include <GL/glew.h>
+#include <stdint.h>
+#include <vector>
+
+#include "File.hpp"
+
+namespace kdr
+{
+  namespace Graphics
+  {
+    /**
+     * Describes how the texels of a texture are stored. Block compressed formats store 4x4 texel
+     * blocks, uncompressed formats are treated as 1x1 blocks of one texel.
+     */
+    struct TextureFormat
+    {
+      GLenum internalFormat {0};
+      GLenum format         {0};
+      GLenum type           {0};
+      GLuint blockSize      {1};
+      GLuint blockBytes     {0};
+
+      /**
+       * Checks whether the format is block compressed, in which case format and type are unused.
+       *
+       * @return True if the format is block compressed, false otherwise.
+       */
+      const bool getIsCompressed() const
+      { return this->blockSize > 1; }
+      /**
+       * Computes the number of block rows of an image.
+       *
+       * @param height The height of the image in texels.
+       * @return The number of block rows.
+       */
+      const GLsizei getRowCount(const GLsizei height) const
+      { return (height + (GLsizei)this->blockSize - 1) / (GLsizei)this->blockSize; }
+      /**
+       * Computes the size of one block row of an image.
+       *
+       * @param width The width of the image in texels.
+       * @return The size of the row in bytes.
+       */
+      const GLsizeiptr getRowSize(const GLsizei width) const
+      { return (GLsizeiptr)((width + (GLsizei)this->blockSize - 1) / (GLsizei)this->blockSize) * this->blockBytes; }
+      /**
+       * Computes the size of an image.
+       *
+       * @param width  The width of the image in texels.
+       * @param height The height of the image in texels.
+       * @return The size of the image in bytes.
+       */
+      const GLsizeiptr getImageSize(const GLsizei width, const GLsizei height) const
+      { return this->getRowSize(width) * this->getRowCount(height); }
+    };
+
+    /**
+     * Gives access to a KTX2 or DDS texture file mapped into memory. Block compressed data is used
+     * in place, so uploads read straight from the mapping and nothing is decompressed on the CPU.
+     *
+     * Supported are 2D textures and 2D texture arrays in the BC1 to BC7 formats and in RGBA8, with
+     * any number of mip levels. Cube maps, volume textures and supercompressed KTX2 files are not.
+     */
+    class TextureFile
+    {
+      public:
+        /**
+         * Constructs a texture file without a file.
+         */
+        TextureFile() {}
+        /**
+         * Constructs a texture file and opens a file.
+         *
+         * @param path The path to the .ktx2 or .dds file.
+         */
+        TextureFile(const char* path)
+        { this->open(path); }
+
+        /**
+         * Checks whether a valid texture file is open.
+         *
+         * @return True if a file passed validation, false otherwise.
+         */
+        const bool getIsOpen() const
+        { return this->file.getIsOpen(); }
+        /**
+         * Retrieves the format of the texels.
+         *
+         * @return The texture format.
+         */
+        const kdr::Graphics::TextureFormat& getFormat() const
+        { return this->format; }
+        /**
+         * Retrieves the width of the first mip level.
+         *
+         * @return The width in texels.
+         */
+        const GLsizei getWidth() const
+        { return this->width; }
+        /**
+         * Retrieves the height of the first mip level.
+         *
+         * @return The height in texels.
+         */
+        const GLsizei getHeight() const
+        { return this->height; }
+        /**
+         * Retrieves the number of array layers.
+         *
+         * @return The number of layers, 1 for a plain 2D texture.
+         */
+        const GLsizei getLayerCount() const
+        { return this->layerCount; }
+        /**
+         * Retrieves the number of mip levels.
+         *
+         * @return The number of levels. Level 0 is the full resolution image.
+         */
+        const GLsizei getLevelCount() const
+        { return this->levelCount; }
+        /**
+         * Checks whether the file holds a texture array, even one with a single layer.
+         *
+         * @return True if the file holds a texture array, false otherwise.
+         */
+        const bool getIsArray() const
+        { return this->isArray; }
+        /**
+         * Retrieves the image of one layer of a mip level.
+         *
+         * @param level The mip level.
+         * @param layer The array layer.
+         * @return A pointer into the mapping, to getImageSize(level) bytes.
+         */
+        const unsigned char* getData(const GLsizei level, const GLsizei layer = 0) const
+        { return this->images[(size_t)level * this->layerCount + layer]; }
+        /**
+         * Computes the size of the image of one layer of a mip level.
+         *
+         * @param level The mip level.
+         * @return The size of the image in bytes.
+         */
+        const GLsizeiptr getImageSize(const GLsizei level) const
+        { return this->format.getImageSize(this->getLevelWidth(level), this->getLevelHeight(level)); }
+        /**
+         * Computes the width of a mip level.
+         *
+         * @param level The mip level.
+         * @return The width in texels.
+         */
+        const GLsizei getLevelWidth(const GLsizei level) const
+        { return (this->width >> level) > 0 ? this->width >> level : 1; }
+        /**
+         * Computes the height of a mip level.
+         *
+         * @param level The mip level.
+         * @return The height in texels.
+         */
+        const GLsizei getLevelHeight(const GLsizei level) const
+        { return (this->height >> level) > 0 ? this->height >> level : 1; }
+
+        /**
+         * Maps and validates a texture file, closing the previous one. The container is detected
+         * from the contents, not the extension.
+         *
+         * @param path The path to the .ktx2 or .dds file.
+         * @return True if the file is a supported texture, false otherwise.
+         */
+        bool open(const char* path);
+        /**
+         * Unmaps the file.
+         */
+        void close();
+
+      private:
+        kdr::File::MappedFile        file;
+        kdr::Graphics::TextureFormat format;
+        GLsizei                      width      {0};
+        GLsizei                      height     {0};
+        GLsizei                      layerCount {0};
+        GLsizei                      levelCount {0};
+        bool                         isArray    {false};
+
+        std::vector<const unsigned char*> images;
+
+        /**
+         * Reads the header and level index of a KTX2 file.
+         *
+         * @param path The path, for error messages.
+         * @return True if the file is supported, false otherwise.
+         */
+        bool _openKTX2(const char* path);
+        /**
+         * Reads the header of a DDS file, with or without the DX10 extension.
+         *
+         * @param path The path, for error messages.
+         * @return True if the file is supported, false otherwise.
+         */
+        bool _openDDS(const char* path);
+        /**
+         * Checks the size of the texture and that its mip levels can be sampled as one chain.
+         *
+         * @param path The path, for error messages.
+         * @return True if the dimensions are valid, false otherwise.
+         */
+        bool _validateSize(const char* path) const;
+    };
+  }
+}
+
+#endif // KDR_TEXTURE_FILE_HPP
@@ -0,0 +1,209 @@
+#ifndef KDR_TRANSFORM_HPP
+#define KDR_TRANSFORM_HPP
+
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+
+#include "Space.hpp"
+
+namespace kdr
+{
+  namespace Space
+  {
+    /**
+     * Engine-owned storage for object transforms, kept as structure-of-arrays.
+     *
+     * Transforms are identified by their index. A parent is always created before its
+     * children, so a single front-to-back sweep resolves the whole hierarchy.
+     */
+    class TransformStore
+    {
+      public:
+        /**
+         * Index used for transforms without a parent.
+         */
+        static constexpr uint32_t None = 0xFFFFFFFF;
+
+        /**
+         * Constructs an empty transform store.
+         *
+         * @param capacity The number of transforms to reserve storage for.
+         */
+        TransformStore(const size_t capacity = 0)
+        { this->reserve(capacity); }
+
+        /**
+         * Retrieves the number of transforms in the store.
+         *
+         * @return The number of transforms.
+         */
+        const size_t getSize() const
+        { return this->parents.size(); }
+        /**
+         * Retrieves the maximum number of threads the update pass is spread over.
+         *
+         * @return The number of threads, or 0 to use every thread of the job scheduler.
+         */
+        const unsigned int getThreadCount() const
+        { return this->threadCount; }
+        /**
+         * Retrieves the position of a transform relative to its parent.
+         *
+         * @param id The index of the transform.
+         * @return The local position.
+         */
+        const kdr::Space::Vec3& getPosition(const uint32_t id) const
+        { return this->positions[id]; }
+        /**
+         * Retrieves the rotation of a transform relative to its parent.
+         *
+         * @param id The index of the transform.
+         * @return The local rotation in degrees.
+         */
+        const kdr::Space::Vec3& getRotation(const uint32_t id) const
+        { return this->rotations[id]; }
+        /**
+         * Retrieves the scale of a transform relative to its parent.
+         *
+         * @param id The index of the transform.
+         * @return The local scale.
+         */
+        const kdr::Space::Vec3& getScale(const uint32_t id) const
+        { return this->scales[id]; }
+        /**
+         * Retrieves the parent index of a transform.
+         *
+         * @param id The index of the transform.
+         * @return The parent index, or TransformStore::None for root transforms.
+         */
+        const uint32_t getParent(const uint32_t id) const
+        { return this->parents[id]; }
+        /**
+         * Retrieves the world matrix of a transform as of the last update.
+         *
+         * @param id The index of the transform.
+         * @return The world matrix.
+         */
+        const kdr::Space::Mat4& getWorldMatrix(const uint32_t id) const
+        { return this->worldMatrices[id]; }
+        /**
+         * Retrieves all world matrices, ordered by transform index.
+         *
+         * @return A pointer to getSize() contiguous world matrices.
+         */
+        const kdr::Space::Mat4* getWorldMatrices() const
+        { return this->worldMatrices.data(); }
+        /**
+         * Checks whether a world matrix changed during the last update.
+         *
+         * @param id The index of the transform.
+         * @return True if the world matrix was recomputed, false otherwise.
+         */
+        const bool getWasUpdated(const uint32_t id) const
+        { return (this->flags[id] & WorldChanged) != 0; }
+
+        /**
+         * Sets the maximum number of threads used to recompute local matrices.
+         *
+         * @param count The number of threads, or 0 to use every thread of the job scheduler.
+         */
+        void setThreadCount(const unsigned int count)
+        { this->threadCount = count; }
+        /**
+         * Sets the position of a transform relative to its parent.
+         *
+         * @param id       The index of the transform.
+         * @param position The new local position.
+         */
+        void setPosition(const uint32_t id, const kdr::Space::Vec3& position)
+        {
+          this->positions[id] = position;
+          this->flags[id] |= LocalDirty;
+        }
+        /**
+         * Sets the rotation of a transform relative to its parent.
+         *
+         * @param id       The index of the transform.
+         * @param rotation The new local rotation in degrees.
+         */
+        void setRotation(const uint32_t id, const kdr::Space::Vec3& rotation)
+        {
+          this->rotations[id] = rotation;
+          this->flags[id] |= LocalDirty;
+        }
+        /**
+         * Sets the scale of a transform relative to its parent.
+         *
+         * @param id    The index of the transform.
+         * @param scale The new local scale.
+         */
+        void setScale(const uint32_t id, const kdr::Space::Vec3& scale)
+        {
+          this->scales[id] = scale;
+          this->flags[id] |= LocalDirty;
+        }
+
+        /**
+         * Reserves storage for a number of transforms.
+         *
+         * @param capacity The number of transforms to reserve storage for.
+         */
+        void reserve(const size_t capacity);
+        /**
+         * Creates a new transform.
+         *
+         * @param position The local position.
+         * @param rotation The local rotation in degrees.
+         * @param scale    The local scale.
+         * @param parent   The index of an existing parent transform, or TransformStore::None.
+         * @return The index of the new transform, or TransformStore::None if the parent is invalid.
+         */
+        uint32_t create(
+          const kdr::Space::Vec3& position,
+          const kdr::Space::Vec3& rotation,
+          const kdr::Space::Vec3& scale,
+          const uint32_t parent = None
+        );
+        /**
+         * Removes every transform from the store.
+         */
+        void clear();
+        /**
+         * Recomputes the world matrices of all dirty transforms and their descendants.
+         */
+        void update();
+
+      private:
+        enum Flag : uint8_t
+        {
+          LocalDirty   = 1 << 0,
+          WorldChanged = 1 << 1,
+        };
+
+        std::vector<kdr::Space::Vec3> positions;
+        std::vector<kdr::Space::Vec3> rotations;
+        std::vector<kdr::Space::Vec3> scales;
+        std::vector<uint32_t>         parents;
+        std::vector<kdr::Space::Mat4> localMatrices;
+        std::vector<kdr::Space::Mat4> worldMatrices;
+        std::vector<uint8_t>          flags;
+
+        unsigned int threadCount {0};
+
+        /**
+         * Recomputes the local matrices of dirty transforms in a range.
+         *
+         * @param begin The first index of the range.
+         * @param end   One past the last index of the range.
+         */
+        void _updateLocalMatrices(const size_t begin, const size_t end);
+        /**
+         * Resolves world matrices front to back, propagating changes to children.
+         */
+        void _updateWorldMatrices();
+    };
+  }
+}
+
+#endif // KDR_TRANSFORM_HPP
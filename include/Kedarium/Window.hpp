@@ -3,11 +3,18 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "Graphics.hpp"
+#include "Renderer.hpp"
 #include "Camera.hpp"
+#include "Stream.hpp"
+#include "Residency.hpp"
 
 namespace kdr
 {
@@ -19,19 +26,22 @@ namespace kdr
     unsigned int width;
     unsigned int height;
     std::string  title;
+    bool         isHeadless;
 
     /**
      * Constructs window properties with specified width, height, and title.
      *
-     * @param width  The width of the window.
-     * @param height The height of the window.
-     * @param title  The title of the window.
+     * @param width      The width of the window.
+     * @param height     The height of the window.
+     * @param title      The title of the window.
+     * @param isHeadless True to render offscreen into a framebuffer without showing a window.
      */
     WindowProps(
       const unsigned int width,
       const unsigned int height,
-      const std::string& title
-    ) : width(width), height(height), title(title)
+      const std::string& title,
+      const bool isHeadless = false
+    ) : width(width), height(height), title(title), isHeadless(isHeadless)
     {}
   };
 
@@ -47,7 +57,7 @@ namespace kdr
        * @param windowProps The properties of the window.
        */
       Window(const WindowProps& windowProps)
-      : width(windowProps.width), height(windowProps.height), title(windowProps.title)
+      : width(windowProps.width), height(windowProps.height), title(windowProps.title), isHeadless(windowProps.isHeadless)
       { this->_initialize(); }
       /**
        * Constructs a window with specified width and height.
@@ -102,12 +112,71 @@ namespace kdr
       const std::string getTitle() const
       { return this->title; }
       /**
-       * Retrieves the time elapsed between the current and previous frame.
+       * Retrieves the time the current update() advances the simulation by. Set on the main
+       * thread while no step is running, so a threaded update() and render() can both read it.
        *
-       * @return The time elapsed between the current and previous frame in seconds.
+       * @return The fixed time step in fixed-step mode, otherwise the frame time, in seconds.
        */
       const float getDeltaTime() const
       { return this->deltaTime; }
+      /**
+       * Retrieves the real time elapsed between the current and previous frame.
+       *
+       * @return The frame time in seconds.
+       */
+      const float getFrameTime() const
+      { return this->frameTime; }
+      /**
+       * Retrieves the fixed simulation time step.
+       *
+       * @return The time step in seconds, or 0 if update() runs once per frame.
+       */
+      const double getFixedTimeStep() const
+      { return this->fixedTimeStep; }
+      /**
+       * Retrieves how far rendering is between the last two simulation steps.
+       *
+       * render() should blend the previous and current simulation states by this amount.
+       *
+       * @return The interpolation factor between 0 and 1, always 1 in variable-step mode.
+       */
+      const float getInterpolationAlpha() const
+      { return this->interpolationAlpha; }
+      /**
+       * Retrieves the vertical synchronization state of the window.
+       *
+       * @return True if buffer swaps wait for the display refresh, false otherwise.
+       */
+      const bool getIsVsyncOn() const
+      { return this->isVsyncOn; }
+      /**
+       * Retrieves the depth testing state of the window.
+       *
+       * @return True if frames are rendered with depth testing, false otherwise.
+       */
+      const bool getIsDepthTestOn() const
+      { return this->isDepthTestOn; }
+      /**
+       * Checks whether update() runs on a simulation thread, one frame ahead of render().
+       *
+       * @return True if the simulation is threaded, false otherwise.
+       */
+      const bool getIsSimulationThreaded() const
+      { return this->isSimulationThreaded; }
+      /**
+       * Retrieves the snapshot slot update() should write its render state to.
+       *
+       * @return 0 or 1. Equal to the read index unless the simulation is threaded.
+       */
+      const unsigned int getSnapshotWriteIndex() const
+      { return this->snapshotWriteIndex; }
+      /**
+       * Retrieves the snapshot slot render() should read its render state from.
+       *
+       * @return 0 or 1. Equal to the write index unless the simulation is threaded.
+       */
+      const unsigned int getSnapshotReadIndex() const
+      { return this->snapshotReadIndex; }
       /**
        * Retrieves the currently bound camera for the window.
        *
@@ -115,6 +184,14 @@ namespace kdr
        */
       kdr::Camera* getBoundCamera() const
       { return this->boundCamera; }
+      /**
+       * Retrieves the renderer flushed at the end of every frame. Its program callback applies
+       * the bound camera to programs with a legacy cameraMatrix uniform.
+       *
+       * @return A reference to the window's renderer.
+       */
+      kdr::Graphics::Renderer& getRenderer()
+      { return this->renderer; }
       /**
        * Retrieves the fullscreen state of the window.
        *
@@ -122,6 +199,41 @@ namespace kdr
        */
       const bool getIsFullscreenOn() const
       { return this->isFullscreenOn; }
+      /**
+       * Checks whether the window renders offscreen without being shown.
+       *
+       * @return True if the window is headless, false otherwise.
+       */
+      const bool getIsHeadless() const
+      { return this->isHeadless; }
+      /**
+       * Retrieves the offscreen framebuffer a headless window renders into.
+       *
+       * @return A pointer to the framebuffer, or NULL if the window is not headless.
+       */
+      kdr::Graphics::Framebuffer* getFramebuffer() const
+      { return this->framebuffer; }
+      /**
+       * Retrieves the asset streamer whose uploads are drained once per frame, creating it on
+       * first use. Uploads still pending when the window is destroyed are dropped unfinished.
+       *
+       * @return A pointer to the streamer, or NULL if the window failed to initialize.
+       */
+      kdr::Stream::Streamer* getStreamer();
+      /**
+       * Retrieves the texture residency manager, updated once per frame before the streamer,
+       * creating it on first use.
+       *
+       * @return A pointer to the residency manager, or NULL if the window failed to initialize.
+       */
+      kdr::Stream::TextureResidency* getTextureResidency();
+      /**
+       * Retrieves the number of frames rendered since the window was created.
+       *
+       * @return The number of rendered frames.
+       */
+      const unsigned int getFrameIndex() const
+      { return this->frameIndex; }
 
       /**
        * Sets the currently bound camera for the window.
@@ -130,6 +242,60 @@ namespace kdr
        */
       void setBoundCamera(kdr::Camera* camera)
       { this->boundCamera = camera; }
+      /**
+       * Sets the number of frames after which the main loop returns on its own.
+       *
+       * @param frameLimit The number of frames to render, or 0 to run until the window is closed.
+       */
+      void setFrameLimit(const unsigned int frameLimit)
+      { this->frameLimit = frameLimit; }
+      /**
+       * Runs update() at a fixed rate, independently of the frame rate.
+       *
+       * @param fixedTimeStep The simulation time step in seconds, or 0 to call update() once per frame.
+       */
+      void setFixedTimeStep(const double fixedTimeStep)
+      {
+        this->fixedTimeStep = fixedTimeStep > 0. ? fixedTimeStep : 0.;
+        this->accumulator = 0.;
+      }
+      /**
+       * Sets how many simulation steps a single frame may run to catch up. Time beyond that is dropped.
+       *
+       * @param maxStepsPerFrame The maximum number of update() calls per frame.
+       */
+      void setMaxStepsPerFrame(const unsigned int maxStepsPerFrame)
+      { this->maxStepsPerFrame = maxStepsPerFrame > 0 ? maxStepsPerFrame : 1; }
+      /**
+       * Caps the number of frames rendered per second by sleeping after each frame.
+       *
+       * @param frameRateLimit The maximum frame rate, or 0 for no limit.
+       */
+      void setFrameRateLimit(const double frameRateLimit)
+      { this->frameRateLimit = frameRateLimit > 0. ? frameRateLimit : 0.; }
+      /**
+       * Enables or disables vertical synchronization. Has no effect on headless windows.
+       *
+       * @param isVsyncOn True to wait for the display refresh on every buffer swap, false otherwise.
+       */
+      void setIsVsyncOn(const bool isVsyncOn);
+      /**
+       * Enables or disables depth testing for every frame. The depth buffer is cleared either way.
+       *
+       * @param isDepthTestOn True to hide fragments behind nearer ones, false to draw in submission order.
+       */
+      void setIsDepthTestOn(const bool isDepthTestOn)
+      { this->isDepthTestOn = isDepthTestOn; }
+      /**
+       * Runs update() on a simulation thread while the main thread renders the previous step.
+       *
+       * Threaded update() calls must not use OpenGL or GLFW, and must write everything render()
+       * needs to the snapshot slot at getSnapshotWriteIndex(). Takes effect at the next loop().
+       *
+       * @param isSimulationThreaded True to pipeline simulation and rendering, false otherwise.
+       */
+      void setIsSimulationThreaded(const bool isSimulationThreaded)
+      { this->isSimulationThreaded = isSimulationThreaded; }
 
       /**
        * Starts the main loop for the window.
@@ -139,6 +305,19 @@ namespace kdr
        * Closes the window.
        */
       void close();
+      /**
+       * Reads the last rendered frame back to memory as tightly packed RGBA8 rows, bottom row first.
+       *
+       * @param pixels Receives width * height * 4 bytes.
+       */
+      void readFrame(std::vector<unsigned char>& pixels);
+      /**
+       * Writes the last rendered frame to a binary PPM image, for image comparison.
+       *
+       * @param path The path of the image file.
+       * @return True if the image was written, false otherwise.
+       */
+      bool saveFrame(const std::string& path);
       /**
        * Maximizes the window to fill the entire screen.
        */
@@ -161,11 +340,21 @@ namespace kdr
        * To be implemented by derived classes. Renders the window state.
        */
       virtual void render() = 0;
+      /**
+       * Can be implemented by derived classes. Handles input on the main thread after events are
+       * polled, while no update() is running.
+       */
+      virtual void handleInput() {}
 
+      /**
+       * Activates a shader program and makes it the target of the camera's legacy matrix uniform.
+       *
+       * @param shader The shader program to bind.
+       */
       void bindShader(kdr::Graphics::Shader& shader)
       {
         shader.Use();
-        boundShaderID = shader.getID();
+        boundShader = &shader;
       }
 
     private:
@@ -175,13 +364,44 @@ namespace kdr
       unsigned int height {600};
       std::string  title  {"Kedarium Engine"};
 
-      float lastTime  {(float)glfwGetTime()};
-      float deltaTime {0.f};
+      double lastTime  {0.};
+      float  frameTime {0.f};
+      float  deltaTime {0.f};
+
+      double       fixedTimeStep      {0.};
+      double       accumulator        {0.};
+      unsigned int maxStepsPerFrame   {5};
+      float        interpolationAlpha {1.f};
+      float        simulationAlpha    {1.f};
+      double       frameRateLimit     {0.};
+      bool         isVsyncOn          {true};
+      bool         isDepthTestOn      {true};
+
+      bool                    isSimulationThreaded  {false};
+      bool                    isSimulationRequested {false};
+      bool                    isSimulationStopping  {false};
+      unsigned int            snapshotWriteIndex    {0};
+      unsigned int            snapshotReadIndex     {0};
+      std::thread             simulationThread;
+      std::mutex              simulationMutex;
+      std::condition_variable simulationCondition;
 
-      GLuint       boundShaderID {0};
-      kdr::Camera* boundCamera   {NULL};
+      kdr::Graphics::Shader* boundShader {NULL};
+      kdr::Camera*           boundCamera {NULL};
+
+      kdr::Graphics::UniformBuffer* cameraBuffer {NULL};
+
+      kdr::Graphics::Renderer renderer;
 
       bool isFullscreenOn {false};
+      bool isHeadless     {false};
+
+      kdr::Graphics::Framebuffer*    framebuffer      {NULL};
+      kdr::Stream::Streamer*         streamer         {NULL};
+      kdr::Stream::TextureResidency* textureResidency {NULL};
+
+      unsigned int frameLimit {0};
+      unsigned int frameIndex {0};
 
       /**
        * Initializes GLFW for the window.
@@ -195,6 +415,13 @@ namespace kdr
        * @return True if initialization is successful, false otherwise.
        */
       const bool _initializeGlew();
+      /**
+       * Creates the GLFW window. Headless windows fall back from the native context API to EGL
+       * and then OSMesa, so a context can be created without a display.
+       *
+       * @return True if a window was created, false otherwise.
+       */
+      const bool _createGlfwWindow();
       /**
        * Initializes OpenGL settings for the window.
        */
@@ -204,9 +431,38 @@ namespace kdr
        */
       void _initialize();
       /**
-       * Updates the time difference between the current and previous frames.
+       * Updates the time difference between the current and previous frames, and the delta time
+       * of the next step. Only called while no step is running.
        */
       void _updateDeltaTime();
+      /**
+       * Runs update() once per frame, or as many fixed steps as the elapsed time calls for.
+       */
+      void _updateSimulation();
+      /**
+       * Starts the simulation thread and requests the first step.
+       */
+      void _startSimulationThread();
+      /**
+       * Waits for the last requested step and stops the simulation thread.
+       */
+      void _stopSimulationThread();
+      /**
+       * Runs requested simulation steps until the thread is stopped.
+       */
+      void _runSimulationThread();
+      /**
+       * Asks the simulation thread to run the next step.
+       */
+      void _requestSimulation();
+      /**
+       * Blocks until the simulation thread has finished the requested step.
+       */
+      void _waitForSimulation();
+      /**
+       * Sleeps until the frame that started at lastTime has lasted as long as the frame rate limit demands.
+       */
+      void _limitFrameRate();
       /**
        * Updates the associated camera in the window.
        */
@@ -3,7 +3,13 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aCol;
 
-uniform mat4 cameraMatrix;
+layout (std140) uniform Camera
+{
+  mat4 cameraMatrix;
+  mat4 viewMatrix;
+  mat4 projectionMatrix;
+  vec4 cameraPosition;
+};
 
 out vec3 vertCol;
 
@@ -0,0 +1,22 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aCol;
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in vec4 aInstanceCol;
+
+layout (std140) uniform Camera
+{
+  mat4 cameraMatrix;
+  mat4 viewMatrix;
+  mat4 projectionMatrix;
+  vec4 cameraPosition;
+};
+
+out vec3 vertCol;
+
+void main()
+{
+  gl_Position = cameraMatrix * aModel * vec4(aPos, 1.f);
+  vertCol = aCol * aInstanceCol.rgb;
+}
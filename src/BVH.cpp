@@ -0,0 +1,296 @@
+#include "Kedarium/BVH.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define KDR_BVH_SSE
+  #include <emmintrin.h>
+#endif
+
+// Leaves this small are tested in one or two SIMD batches
+constexpr uint32_t MAX_LEAF_OBJECTS {8};
+
+// Result of testing a box against one plane
+enum PlaneResult
+{
+  Outside,
+  Intersecting,
+  Inside
+};
+
+static PlaneResult testPlane(const kdr::Space::Plane& plane, const kdr::Space::Vec3& center, const kdr::Space::Vec3& extents)
+{
+  const float distance = plane.getDistance(center);
+  const float radius =
+    extents.x * fabsf(plane.normal.x) +
+    extents.y * fabsf(plane.normal.y) +
+    extents.z * fabsf(plane.normal.z);
+
+  if (distance < -radius) return Outside;
+  if (distance < radius) return Intersecting;
+  return Inside;
+}
+
+void kdr::Space::BVH::build(const std::vector<kdr::Space::AABB>& bounds)
+{
+  nodes.clear();
+  objectIDs.resize(bounds.size());
+  if (bounds.empty())
+  {
+    _storeLeafBounds(bounds);
+    return;
+  }
+
+  std::vector<kdr::Space::Vec3> centroids(bounds.size());
+  for (size_t i = 0; i < bounds.size(); i++)
+  {
+    objectIDs[i] = (uint32_t)i;
+    centroids[i] = bounds[i].getCenter();
+  }
+
+  nodes.reserve(bounds.size() * 2 / MAX_LEAF_OBJECTS + 1);
+  nodes.push_back(Node());
+  _split(0, 0, (uint32_t)bounds.size(), bounds, centroids);
+  _storeLeafBounds(bounds);
+}
+
+void kdr::Space::BVH::refit(const std::vector<kdr::Space::AABB>& bounds)
+{
+  if (bounds.size() != objectIDs.size())
+  {
+    build(bounds);
+    return;
+  }
+  _storeLeafBounds(bounds);
+
+  // Children always follow their parent, so a reverse sweep visits them first
+  for (size_t i = nodes.size(); i-- > 0;)
+  {
+    Node& node = nodes[i];
+    node.bounds = kdr::Space::AABB();
+    if (node.count > 0)
+    {
+      for (uint32_t j = node.first; j < node.first + node.count; j++)
+      {
+        node.bounds.expand(bounds[objectIDs[j]]);
+      }
+    }
+    else
+    {
+      node.bounds.expand(nodes[node.first].bounds);
+      node.bounds.expand(nodes[node.first + 1].bounds);
+    }
+  }
+}
+
+void kdr::Space::BVH::cull(const kdr::Space::Frustum& frustum, std::vector<uint32_t>& visible)
+{
+  visible.clear();
+  testCount = 0;
+  if (nodes.empty()) return;
+
+  struct Entry
+  {
+    uint32_t nodeIndex;
+    uint32_t planeMask;
+  };
+  Entry stack[64];
+  int stackSize = 0;
+  stack[stackSize++] = {0, (1u << kdr::Space::Frustum::PlaneCount) - 1};
+
+  while (stackSize > 0)
+  {
+    const Entry entry = stack[--stackSize];
+    const Node& node = nodes[entry.nodeIndex];
+
+    // Planes a parent was fully inside of are skipped for its children
+    uint32_t planeMask = entry.planeMask;
+    const kdr::Space::Vec3 center = node.bounds.getCenter();
+    const kdr::Space::Vec3 extents = node.bounds.getExtents();
+    bool isOutside = false;
+    for (int i = 0; i < kdr::Space::Frustum::PlaneCount && !isOutside; i++)
+    {
+      if (!(planeMask & (1u << i))) continue;
+
+      testCount++;
+      const PlaneResult result = testPlane(frustum.planes[i], center, extents);
+      if (result == Outside) isOutside = true;
+      if (result == Inside) planeMask &= ~(1u << i);
+    }
+    if (isOutside) continue;
+
+    if (planeMask == 0)
+    {
+      _appendSubtree(entry.nodeIndex, visible);
+    }
+    else if (node.count > 0)
+    {
+      _cullLeaf(node, frustum, planeMask, visible);
+    }
+    else if (stackSize + 2 <= 64)
+    {
+      stack[stackSize++] = {node.first + 1, planeMask};
+      stack[stackSize++] = {node.first, planeMask};
+    }
+    else
+    {
+      // Deeper than a median split over 2^32 objects can go; accept rather than drop
+      _appendSubtree(entry.nodeIndex, visible);
+    }
+  }
+}
+
+void kdr::Space::BVH::_split(
+  const uint32_t nodeIndex,
+  const uint32_t first,
+  const uint32_t count,
+  const std::vector<kdr::Space::AABB>& bounds,
+  const std::vector<kdr::Space::Vec3>& centroids
+)
+{
+  kdr::Space::AABB nodeBounds;
+  kdr::Space::AABB centroidBounds;
+  for (uint32_t i = first; i < first + count; i++)
+  {
+    nodeBounds.expand(bounds[objectIDs[i]]);
+    centroidBounds.expand(centroids[objectIDs[i]]);
+  }
+  nodes[nodeIndex].bounds = nodeBounds;
+
+  if (count <= MAX_LEAF_OBJECTS)
+  {
+    nodes[nodeIndex].first = first;
+    nodes[nodeIndex].count = count;
+    return;
+  }
+
+  // Median split along the axis the centroids spread the most on
+  const kdr::Space::Vec3 spread = centroidBounds.max - centroidBounds.min;
+  int axis = 0;
+  if (spread.y > spread.x) axis = 1;
+  if (spread.z > (axis == 0 ? spread.x : spread.y)) axis = 2;
+
+  const uint32_t half = count / 2;
+  std::nth_element(
+    objectIDs.begin() + first,
+    objectIDs.begin() + first + half,
+    objectIDs.begin() + first + count,
+    [&centroids, axis](const uint32_t a, const uint32_t b)
+    {
+      const float* ca = &centroids[a].x;
+      const float* cb = &centroids[b].x;
+      return ca[axis] < cb[axis];
+    }
+  );
+
+  const uint32_t left = (uint32_t)nodes.size();
+  nodes.push_back(Node());
+  nodes.push_back(Node());
+  nodes[nodeIndex].first = left;
+  nodes[nodeIndex].count = 0;
+
+  _split(left, first, half, bounds, centroids);
+  _split(left + 1, first + half, count - half, bounds, centroids);
+}
+
+void kdr::Space::BVH::_storeLeafBounds(const std::vector<kdr::Space::AABB>& bounds)
+{
+  const size_t padded = (objectIDs.size() + 3) & ~(size_t)3;
+  centerX.assign(padded, 0.f);
+  centerY.assign(padded, 0.f);
+  centerZ.assign(padded, 0.f);
+  extentX.assign(padded, -1.f);
+  extentY.assign(padded, -1.f);
+  extentZ.assign(padded, -1.f);
+
+  for (size_t i = 0; i < objectIDs.size(); i++)
+  {
+    const kdr::Space::AABB& box = bounds[objectIDs[i]];
+    const kdr::Space::Vec3 center = box.getCenter();
+    const kdr::Space::Vec3 extents = box.getExtents();
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+    extentX[i] = extents.x;
+    extentY[i] = extents.y;
+    extentZ[i] = extents.z;
+  }
+}
+
+void kdr::Space::BVH::_appendSubtree(const uint32_t nodeIndex, std::vector<uint32_t>& visible)
+{
+  // Leaves of a subtree hold one contiguous object range, bounded by its leftmost and rightmost leaf
+  uint32_t firstLeaf = nodeIndex;
+  while (nodes[firstLeaf].count == 0) firstLeaf = nodes[firstLeaf].first;
+  uint32_t lastLeaf = nodeIndex;
+  while (nodes[lastLeaf].count == 0) lastLeaf = nodes[lastLeaf].first + 1;
+
+  const uint32_t begin = nodes[firstLeaf].first;
+  const uint32_t end = nodes[lastLeaf].first + nodes[lastLeaf].count;
+  visible.insert(visible.end(), objectIDs.begin() + begin, objectIDs.begin() + end);
+}
+
+void kdr::Space::BVH::_cullLeaf(const Node& node, const kdr::Space::Frustum& frustum, const uint32_t planeMask, std::vector<uint32_t>& visible)
+{
+  const uint32_t end = node.first + node.count;
+
+#if defined(KDR_BVH_SSE)
+  // Four boxes per batch; padding slots past the leaf are masked off below
+  for (uint32_t base = node.first & ~3u; base < end; base += 4)
+  {
+    const __m128 cx = _mm_loadu_ps(&centerX[base]);
+    const __m128 cy = _mm_loadu_ps(&centerY[base]);
+    const __m128 cz = _mm_loadu_ps(&centerZ[base]);
+    const __m128 ex = _mm_loadu_ps(&extentX[base]);
+    const __m128 ey = _mm_loadu_ps(&extentY[base]);
+    const __m128 ez = _mm_loadu_ps(&extentZ[base]);
+    const __m128 signMask = _mm_set1_ps(-0.f);
+
+    __m128 outside = _mm_setzero_ps();
+    for (int i = 0; i < kdr::Space::Frustum::PlaneCount; i++)
+    {
+      if (!(planeMask & (1u << i))) continue;
+
+      const kdr::Space::Plane& plane = frustum.planes[i];
+      const __m128 nx = _mm_set1_ps(plane.normal.x);
+      const __m128 ny = _mm_set1_ps(plane.normal.y);
+      const __m128 nz = _mm_set1_ps(plane.normal.z);
+
+      const __m128 distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(cx, nx), _mm_mul_ps(cy, ny)),
+        _mm_add_ps(_mm_mul_ps(cz, nz), _mm_set1_ps(plane.distance))
+      );
+      const __m128 radius = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(ex, _mm_andnot_ps(signMask, nx)), _mm_mul_ps(ey, _mm_andnot_ps(signMask, ny))),
+        _mm_mul_ps(ez, _mm_andnot_ps(signMask, nz))
+      );
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+    }
+    testCount += 4;
+
+    const int outsideBits = _mm_movemask_ps(outside);
+    for (uint32_t lane = 0; lane < 4; lane++)
+    {
+      const uint32_t index = base + lane;
+      if (index < node.first || index >= end) continue;
+      if (!(outsideBits & (1 << lane))) visible.push_back(objectIDs[index]);
+    }
+  }
+#else
+  for (uint32_t index = node.first; index < end; index++)
+  {
+    const kdr::Space::Vec3 center {centerX[index], centerY[index], centerZ[index]};
+    const kdr::Space::Vec3 extents {extentX[index], extentY[index], extentZ[index]};
+
+    bool isOutside = false;
+    for (int i = 0; i < kdr::Space::Frustum::PlaneCount && !isOutside; i++)
+    {
+      if (!(planeMask & (1u << i))) continue;
+      isOutside = testPlane(frustum.planes[i], center, extents) == Outside;
+    }
+    testCount++;
+
+    if (!isOutside) visible.push_back(objectIDs[index]);
+  }
+#endif
+}
@@ -0,0 +1,84 @@
+#include "Kedarium/Bounds.hpp"
+
+kdr::Space::Frustum::Frustum(const kdr::Space::Mat4& viewProjection)
+{
+  // Rows of the column-major matrix; each plane is the fourth row plus or minus another (Gribb-Hartmann)
+  float rows[4][4];
+  for (int row = 0; row < 4; row++)
+  {
+    for (int column = 0; column < 4; column++)
+    {
+      rows[row][column] = viewProjection[column][row];
+    }
+  }
+
+  for (int i = 0; i < PlaneCount; i++)
+  {
+    const int axis = i / 2;
+    const float sign = (i % 2 == 0) ? 1.f : -1.f;
+
+    const float x = rows[3][0] + sign * rows[axis][0];
+    const float y = rows[3][1] + sign * rows[axis][1];
+    const float z = rows[3][2] + sign * rows[axis][2];
+    const float w = rows[3][3] + sign * rows[axis][3];
+
+    const float length = sqrtf(x * x + y * y + z * z);
+    const float scale = length > 0.f ? 1.f / length : 0.f;
+    planes[i].normal = kdr::Space::Vec3(x * scale, y * scale, z * scale);
+    planes[i].distance = w * scale;
+  }
+}
+
+const bool kdr::Space::Frustum::intersects(const kdr::Space::Sphere& sphere) const
+{
+  for (int i = 0; i < PlaneCount; i++)
+  {
+    if (planes[i].getDistance(sphere.center) < -sphere.radius) return false;
+  }
+  return true;
+}
+
+const bool kdr::Space::Frustum::intersects(const kdr::Space::AABB& box) const
+{
+  const kdr::Space::Vec3 center = box.getCenter();
+  const kdr::Space::Vec3 extents = box.getExtents();
+
+  for (int i = 0; i < PlaneCount; i++)
+  {
+    const kdr::Space::Plane& plane = planes[i];
+    const float radius =
+      extents.x * fabsf(plane.normal.x) +
+      extents.y * fabsf(plane.normal.y) +
+      extents.z * fabsf(plane.normal.z);
+    if (plane.getDistance(center) < -radius) return false;
+  }
+  return true;
+}
+
+kdr::Space::AABB kdr::Space::transformBounds(const kdr::Space::AABB& box, const kdr::Space::Mat4& mat)
+{
+  // Arvo's method: each output axis takes the extreme of every matrix term independently
+  kdr::Space::AABB result {
+    kdr::Space::Vec3(mat[3][0], mat[3][1], mat[3][2]),
+    kdr::Space::Vec3(mat[3][0], mat[3][1], mat[3][2])
+  };
+  const float boxMin[3] {box.min.x, box.min.y, box.min.z};
+  const float boxMax[3] {box.max.x, box.max.y, box.max.z};
+  float resultMin[3] {result.min.x, result.min.y, result.min.z};
+  float resultMax[3] {result.max.x, result.max.y, result.max.z};
+
+  for (int row = 0; row < 3; row++)
+  {
+    for (int column = 0; column < 3; column++)
+    {
+      const float a = mat[column][row] * boxMin[column];
+      const float b = mat[column][row] * boxMax[column];
+      resultMin[row] += fminf(a, b);
+      resultMax[row] += fmaxf(a, b);
+    }
+  }
+
+  result.min = kdr::Space::Vec3(resultMin[0], resultMin[1], resultMin[2]);
+  result.max = kdr::Space::Vec3(resultMax[0], resultMax[1], resultMax[2]);
+  return result;
+}
@@ -64,22 +64,32 @@ void kdr::Camera::updateMatrix()
 
   front = kdr::Space::normalize(tempFront);
 
-  kdr::Space::Mat4 view {1.f};
-  kdr::Space::Mat4 proj {1.f};
-
   view = kdr::Space::lookAt(
     position,
     position + front,
     up
   );
-  proj = kdr::Space::perspective(
+  projection = kdr::Space::perspective(
     kdr::Space::radians(fov),
     aspect,
     near,
     far
   );
 
-  matrix = proj * view;
+  matrix = projection * view;
+}
+
+const kdr::CameraBlock kdr::Camera::getBlock() const
+{
+  kdr::CameraBlock block;
+  block.matrix      = matrix;
+  block.view        = view;
+  block.projection  = projection;
+  block.position[0] = position.x;
+  block.position[1] = position.y;
+  block.position[2] = position.z;
+  block.position[3] = 1.f;
+  return block;
 }
 
 void kdr::Camera::applyMatrix(const GLuint shaderID, const char* uniformName)
@@ -88,6 +98,13 @@ void kdr::Camera::applyMatrix(const GLuint shaderID, const char* uniformName)
   glUniformMatrix4fv(matrixLoc, 1, GL_FALSE, &matrix[0][0]);
 }
 
+void kdr::Camera::applyMatrix(const kdr::Graphics::Shader& shader, const std::string& uniformName)
+{
+  GLint matrixLoc = shader.getUniformLocation(uniformName);
+  if (matrixLoc < 0) return;
+  glUniformMatrix4fv(matrixLoc, 1, GL_FALSE, &matrix[0][0]);
+}
+
 void kdr::Camera::_updateCursor(GLFWwindow* window)
 {
   glfwSetInputMode(
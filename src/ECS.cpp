@@ -0,0 +1,124 @@
+#include "Kedarium/ECS.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <string.h>
+
+#include "Kedarium/Profiler.hpp"
+
+uint32_t kdr::ECS::nextComponentID()
+{
+  static std::atomic<uint32_t> nextID {0};
+  return nextID.fetch_add(1, std::memory_order_relaxed);
+}
+
+const bool kdr::ECS::Registry::getIsAlive(const kdr::ECS::Entity entity) const
+{
+  const uint32_t index = kdr::ECS::getEntityIndex(entity);
+  return entity != kdr::ECS::nullEntity && index < versions.size() && versions[index] == (entity >> kdr::ECS::entityIndexBits);
+}
+
+kdr::ECS::Entity kdr::ECS::Registry::create()
+{
+  uint32_t index = (uint32_t)versions.size();
+  if (!freeIndices.empty())
+  {
+    index = freeIndices.back();
+    freeIndices.pop_back();
+  }
+  else if (index > kdr::ECS::entityIndexMask)
+  {
+    std::cerr << "Failed to create an entity: out of entity indices!\n";
+    return kdr::ECS::nullEntity;
+  }
+  else
+  {
+    versions.push_back(0);
+  }
+  return (versions[index] << kdr::ECS::entityIndexBits) | index;
+}
+
+void kdr::ECS::Registry::destroy(const kdr::ECS::Entity entity)
+{
+  if (!getIsAlive(entity)) return;
+
+  for (std::unique_ptr<kdr::ECS::PoolBase>& pool : pools)
+  {
+    if (pool) pool->remove(entity);
+  }
+
+  // Bumping the version invalidates every copy of the handle; the all-ones version is skipped so
+  // no live entity ever equals nullEntity
+  const uint32_t index = kdr::ECS::getEntityIndex(entity);
+  const uint32_t maxVersion = 0xFFFFFFFF >> kdr::ECS::entityIndexBits;
+  versions[index] = (versions[index] + 1) % maxVersion;
+  freeIndices.push_back(index);
+}
+
+void kdr::ECS::SystemScheduler::add(const char* name, const std::function<void(kdr::ECS::Registry&, float)>& function)
+{
+  kdr::ECS::System system;
+  system.name = name;
+  system.function = function;
+  systems.push_back(system);
+}
+
+void kdr::ECS::SystemScheduler::setIsEnabled(const char* name, const bool isEnabled)
+{
+  for (kdr::ECS::System& system : systems)
+  {
+    if (strcmp(system.name, name) == 0)
+    {
+      system.isEnabled = isEnabled;
+    }
+  }
+}
+
+void kdr::ECS::SystemScheduler::run(kdr::ECS::Registry& registry, const float deltaTime)
+{
+  for (kdr::ECS::System& system : systems)
+  {
+    if (!system.isEnabled) continue;
+
+    KDR_PROFILE_SCOPE(system.name);
+    system.function(registry, deltaTime);
+  }
+}
+
+size_t kdr::ECS::submitVisible(
+  kdr::ECS::Registry& registry,
+  const kdr::Space::Frustum& frustum,
+  const kdr::Space::Vec3& cameraPosition,
+  kdr::Graphics::Renderer& renderer
+)
+{
+  KDR_PROFILE_SCOPE("ECS::submitVisible");
+
+  kdr::ECS::Pool<kdr::ECS::MeshRenderer>& meshRenderers = registry.getPool<kdr::ECS::MeshRenderer>();
+  kdr::ECS::Pool<kdr::ECS::WorldBounds>& worldBounds = registry.getPool<kdr::ECS::WorldBounds>();
+
+  const std::vector<kdr::ECS::Entity>& entities = meshRenderers.getEntities();
+  std::vector<kdr::ECS::MeshRenderer>& components = meshRenderers.getComponents();
+
+  size_t submitted {0};
+  for (size_t i = 0; i < components.size(); i++)
+  {
+    const kdr::ECS::MeshRenderer& meshRenderer = components[i];
+    if (meshRenderer.shader == NULL || meshRenderer.pool == NULL) continue;
+
+    // Entities without bounds are never culled
+    float depth {0.f};
+    if (worldBounds.getHas(entities[i]))
+    {
+      const kdr::Space::AABB& bounds = worldBounds.get(entities[i]).bounds;
+      if (!frustum.intersects(bounds)) continue;
+
+      const kdr::Space::Vec3 offset = bounds.getCenter() - cameraPosition;
+      depth = kdr::Space::dot(offset, offset);
+    }
+
+    renderer.submit(*meshRenderer.shader, *meshRenderer.pool, meshRenderer.handle, meshRenderer.material, depth);
+    submitted++;
+  }
+  return submitted;
+}
@@ -1,16 +1,124 @@
 #include "Kedarium/File.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+  #define KDR_FILE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
 const std::string kdr::File::getContents(const char* path)
 {
-  std::ifstream file(path);
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
   if (!file.is_open())
   {
     std::cerr << "Failed to open the file: " << path << "!\n";
     return "";
   }
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
+  // Reading straight into a string of the right size, without a stream buffer copy in between
+  const std::streamsize size = file.tellg();
+  file.seekg(0, std::ios::beg);
+
+  std::string contents((size_t)size, '\0');
+  file.read(&contents[0], size);
+  contents.resize((size_t)file.gcount());
+  return contents;
+}
+
+bool kdr::File::getBinaryContents(const char* path, std::vector<char>& contents)
+{
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+  {
+    return false;
+  }
+
+  const std::streamsize size = file.tellg();
+  file.seekg(0, std::ios::beg);
+
+  contents.resize((size_t)size);
+  return (bool)file.read(contents.data(), size);
+}
+
+bool kdr::File::writeContents(const char* path, const void* data, const size_t size)
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open())
+  {
+    std::cerr << "Failed to open the file for writing: " << path << "!\n";
+    return false;
+  }
+
+  file.write((const char*)data, size);
+  return (bool)file;
+}
+
+void kdr::File::touchPages(const void* data, const size_t size)
+{
+  const unsigned char* bytes = (const unsigned char*)data;
+  volatile unsigned char sink {0};
+  for (size_t i = 0; i < size; i += 4096) sink = sink + bytes[i];
+}
+
+bool kdr::File::MappedFile::open(const char* path)
+{
+  close();
+
+#if defined(KDR_FILE_MMAP)
+  const int descriptor = ::open(path, O_RDONLY);
+  if (descriptor < 0)
+  {
+    std::cerr << "Failed to open the file: " << path << "!\n";
+    return false;
+  }
+
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+  {
+    ::close(descriptor);
+    std::cerr << "Failed to map the file: " << path << "!\n";
+    return false;
+  }
+
+  void* mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  ::close(descriptor);
+  if (mapping == MAP_FAILED)
+  {
+    std::cerr << "Failed to map the file: " << path << "!\n";
+    return false;
+  }
+
+  // The whole file is about to be read, so the kernel may as well start paging it in
+  madvise(mapping, (size_t)status.st_size, MADV_WILLNEED);
+
+  data = (const unsigned char*)mapping;
+  size = (size_t)status.st_size;
+  return true;
+#else
+  if (!kdr::File::getBinaryContents(path, fallback) || fallback.empty())
+  {
+    std::cerr << "Failed to open the file: " << path << "!\n";
+    return false;
+  }
+
+  data = (const unsigned char*)fallback.data();
+  size = fallback.size();
+  return true;
+#endif
+}
+
+void kdr::File::MappedFile::close()
+{
+  if (data == NULL) return;
 
-  return buffer.str();
+#if defined(KDR_FILE_MMAP)
+  munmap((void*)data, size);
+#else
+  fallback.clear();
+  fallback.shrink_to_fit();
+#endif
+  data = NULL;
+  size = 0;
 }
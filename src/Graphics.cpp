@@ -1,94 +1,700 @@
 #include "Kedarium/Graphics.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "Kedarium/ProgramCache.hpp"
+
+// Guards the workers preprocessing shaders against include chains that never end
+static const size_t maxShaderIncludeDepth {32};
+
+// Locations of the legacy cameraMatrix uniform, by program. Only touched on the GL thread
+static std::unordered_map<GLuint, GLint> cameraMatrixLocations;
+
+GLint kdr::Graphics::getCameraMatrixLocation(const GLuint program)
+{
+  std::unordered_map<GLuint, GLint>::const_iterator it = cameraMatrixLocations.find(program);
+  return it != cameraMatrixLocations.end() ? it->second : -1;
+}
+
 void kdr::Graphics::usePointMode()
 {
-  glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+  kdr::Graphics::getStateCache().setPolygonMode(GL_POINT);
 }
 
 void kdr::Graphics::useLineMode()
 {
-  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+  kdr::Graphics::getStateCache().setPolygonMode(GL_LINE);
 }
 
 void kdr::Graphics::useFillmode()
 {
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  kdr::Graphics::getStateCache().setPolygonMode(GL_FILL);
 }
 
-kdr::Graphics::Shader::Shader(const char* vertexPath, const char* fragmentPath)
+// Expands the includes of a shader file, given the chain of files that included it
+static std::string expandShaderFile(const std::string& path, std::vector<std::string>& includeChain)
 {
-  GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-  GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+  if (std::find(includeChain.begin(), includeChain.end(), path) != includeChain.end())
+  {
+    std::cerr << "Failed to include shader file: " << path << " includes itself!\n";
+    return "";
+  }
+  if (includeChain.size() >= maxShaderIncludeDepth)
+  {
+    std::cerr << "Failed to include shader file: " << path << " is nested more than " << maxShaderIncludeDepth << " includes deep!\n";
+    return "";
+  }
 
-  const std::string vertexShaderSource = kdr::File::getContents(vertexPath);
-  const std::string fragmentShaderSource = kdr::File::getContents(fragmentPath);
+  const std::string contents = kdr::File::getContents(path.c_str());
+  if (contents.find("#include") == std::string::npos) return contents;
 
-  const char* vertexShaderSourceC = vertexShaderSource.c_str();
-  const char* fragmentShaderSourceC = fragmentShaderSource.c_str();
+  const size_t slash = path.find_last_of("/\\");
+  const std::string directory = slash != std::string::npos ? path.substr(0, slash + 1) : "";
 
-  glShaderSource(vertexShader, 1, &vertexShaderSourceC, NULL);
-  glShaderSource(fragmentShader, 1, &fragmentShaderSourceC, NULL);
+  std::string source;
+  source.reserve(contents.size());
 
-  glCompileShader(vertexShader);
-  glCompileShader(fragmentShader);
+  size_t lineStart = 0;
+  while (lineStart < contents.size())
+  {
+    size_t lineEnd = contents.find('\n', lineStart);
+    if (lineEnd == std::string::npos) lineEnd = contents.size();
+    const std::string line = contents.substr(lineStart, lineEnd - lineStart);
 
-  // Validating the Shaders
-  int success {0};
-  char infoLog[512];
+    const size_t directive = line.find_first_not_of(" \t");
+    const size_t open = line.find('"');
+    const size_t close = open != std::string::npos ? line.find('"', open + 1) : std::string::npos;
+    if (
+      directive != std::string::npos &&
+      line.compare(directive, 8, "#include") == 0 &&
+      close != std::string::npos
+    )
+    {
+      includeChain.push_back(path);
+      source += expandShaderFile(directory + line.substr(open + 1, close - open - 1), includeChain);
+      includeChain.pop_back();
+    }
+    else
+    {
+      source += line;
+    }
+    source += '\n';
 
-  glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-  if (!success)
-  {
-    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-    std::cerr << "Failed to compile the vertex shader (" << vertexPath << ")!\n";
-    std::cerr << "Error: " << infoLog << '\n';
+    lineStart = lineEnd + 1;
   }
+  return source;
+}
 
-  glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-  if (!success)
+std::string kdr::Graphics::readShaderFile(const std::string& path)
+{
+  std::vector<std::string> includeChain;
+  return expandShaderFile(path, includeChain);
+}
+
+kdr::Graphics::ShaderSource kdr::Graphics::readShaderSource(const std::string& vertexPath, const std::string& fragmentPath)
+{
+  kdr::Graphics::ShaderSource source;
+  source.vertexPath = vertexPath;
+  source.fragmentPath = fragmentPath;
+  source.vertexSource = kdr::Graphics::readShaderFile(vertexPath);
+  source.fragmentSource = kdr::Graphics::readShaderFile(fragmentPath);
+
+  kdr::Graphics::ProgramCache& programCache = kdr::Graphics::getProgramCache();
+  if (programCache.getIsEnabled())
   {
-    glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-    std::cerr << "Failed to compile the fragment shader (" << fragmentPath << ")!\n";
-    std::cerr << "Error: " << infoLog << '\n';
+    source.cacheKey = programCache.makeKey(source.vertexSource, source.fragmentSource);
   }
+  return source;
+}
+
+kdr::Graphics::Shader::Shader(const char* vertexPath, const char* fragmentPath)
+: Shader(kdr::Graphics::readShaderSource(vertexPath, fragmentPath))
+{}
+
+kdr::Graphics::Shader::Shader(const kdr::Graphics::ShaderSource& source, const bool isDeferred)
+{
+  vertexPath = source.vertexPath;
+  fragmentPath = source.fragmentPath;
+  cacheKey = source.cacheKey;
 
-  // Shader Program
   ID = glCreateProgram();
-  glAttachShader(ID, vertexShader);
-  glAttachShader(ID, fragmentShader);
+
+  // Reusing the driver binary from an earlier run skips compilation entirely
+  kdr::Graphics::ProgramCache& programCache = kdr::Graphics::getProgramCache();
+  if (programCache.getIsEnabled() && programCache.load(ID, cacheKey))
+  {
+    _reflect();
+    return;
+  }
+
+  _submit(source);
+  if (!isDeferred)
+  {
+    _finalize();
+  }
+}
+
+const bool kdr::Graphics::Shader::getIsReady() const
+{
+  if (!isPending) return true;
+  if (!GLEW_KHR_parallel_shader_compile) return false;
+
+  GLint completed {GL_FALSE};
+  glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed == GL_TRUE;
+}
+
+kdr::Graphics::Shader::Shader(kdr::Graphics::Shader&& other)
+{
+  *this = std::move(other);
+}
+
+kdr::Graphics::Shader& kdr::Graphics::Shader::operator=(kdr::Graphics::Shader&& other)
+{
+  if (this == &other) return *this;
+
+  ID               = other.ID;
+  vertexPath       = std::move(other.vertexPath);
+  fragmentPath     = std::move(other.fragmentPath);
+  isPending        = other.isPending;
+  vertexShaderID   = other.vertexShaderID;
+  fragmentShaderID = other.fragmentShaderID;
+  cacheKey         = other.cacheKey;
+  submitTime       = other.submitTime;
+  uniformLocations = std::move(other.uniformLocations);
+  uniformBlocks    = std::move(other.uniformBlocks);
+
+  other.ID               = 0;
+  other.isPending        = false;
+  other.vertexShaderID   = 0;
+  other.fragmentShaderID = 0;
+  other.uniformLocations.clear();
+  other.uniformBlocks.clear();
+  return *this;
+}
+
+void kdr::Graphics::Shader::Delete()
+{
+  if (isPending)
+  {
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+    isPending = false;
+  }
+  cameraMatrixLocations.erase(this->ID);
+  kdr::Graphics::getStateCache().onProgramDeleted(this->ID);
+  glDeleteProgram(this->ID);
+}
+
+void kdr::Graphics::Shader::_submit(const kdr::Graphics::ShaderSource& source)
+{
+  submitTime = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+  fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
+  const char* vertexShaderSourceC = source.vertexSource.c_str();
+  const char* fragmentShaderSourceC = source.fragmentSource.c_str();
+
+  glShaderSource(vertexShaderID, 1, &vertexShaderSourceC, NULL);
+  glShaderSource(fragmentShaderID, 1, &fragmentShaderSourceC, NULL);
+
+  glCompileShader(vertexShaderID);
+  glCompileShader(fragmentShaderID);
+
+  // Linking straight away; a failed compile shows up as a failed link in _finalize()
+  glAttachShader(ID, vertexShaderID);
+  glAttachShader(ID, fragmentShaderID);
+  if (kdr::Graphics::getProgramCache().getIsEnabled())
+  {
+    glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
   glLinkProgram(ID);
 
+  isPending = true;
+}
+
+void kdr::Graphics::Shader::_finalize() const
+{
+  isPending = false;
+
+  int success {0};
+  char infoLog[512];
+
   glGetProgramiv(ID, GL_LINK_STATUS, &success);
   if (!success)
   {
+    // Validating the Shaders
+    glGetShaderiv(vertexShaderID, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+      glGetShaderInfoLog(vertexShaderID, 512, NULL, infoLog);
+      std::cerr << "Failed to compile the vertex shader (" << vertexPath << ")!\n";
+      std::cerr << "Error: " << infoLog << '\n';
+    }
+
+    glGetShaderiv(fragmentShaderID, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+      glGetShaderInfoLog(fragmentShaderID, 512, NULL, infoLog);
+      std::cerr << "Failed to compile the fragment shader (" << fragmentPath << ")!\n";
+      std::cerr << "Error: " << infoLog << '\n';
+    }
+
     glGetProgramInfoLog(ID, 512, NULL, infoLog);
     std::cerr << "Failed to compile the link the shader program!\n";
     std::cerr << "Error: " << infoLog << '\n';
   }
+  else
+  {
+    _reflect();
+
+    kdr::Graphics::ProgramCache& programCache = kdr::Graphics::getProgramCache();
+    if (programCache.getIsEnabled())
+    {
+      const double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+      programCache.store(ID, cacheKey, now - submitTime);
+    }
+  }
 
   // Deleting the Shaders
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
+  glDetachShader(ID, vertexShaderID);
+  glDetachShader(ID, fragmentShaderID);
+  glDeleteShader(vertexShaderID);
+  glDeleteShader(fragmentShaderID);
+  vertexShaderID = 0;
+  fragmentShaderID = 0;
+}
+
+void kdr::Graphics::Shader::_reflect() const
+{
+  uniformLocations.clear();
+  uniformBlocks.clear();
+  cameraMatrixLocations.erase(ID);
+
+  GLint uniformCount {0};
+  GLint maxNameLength {0};
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+  std::vector<char> name(maxNameLength > 0 ? maxNameLength : 1);
+  for (GLint i = 0; i < uniformCount; i++)
+  {
+    GLint   arraySize {0};
+    GLenum  type      {0};
+    GLsizei length    {0};
+    glGetActiveUniform(ID, i, maxNameLength, &length, &arraySize, &type, name.data());
+
+    std::string uniformName(name.data(), length);
+    GLint location = glGetUniformLocation(ID, uniformName.c_str());
+    if (location < 0) continue; // Members of uniform blocks have no location
+
+    uniformLocations[uniformName] = location;
+    if (uniformName == "cameraMatrix")
+    {
+      cameraMatrixLocations[ID] = location;
+    }
+
+    // Arrays are reported as "name[0]", but are commonly looked up as "name"
+    const size_t bracket = uniformName.find('[');
+    if (bracket != std::string::npos)
+    {
+      uniformLocations[uniformName.substr(0, bracket)] = location;
+    }
+  }
+
+  GLint blockCount {0};
+  GLint maxBlockNameLength {0};
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+
+  name.resize(maxBlockNameLength > 0 ? maxBlockNameLength : 1);
+  for (GLint i = 0; i < blockCount; i++)
+  {
+    GLsizei length {0};
+    glGetActiveUniformBlockName(ID, i, maxBlockNameLength, &length, name.data());
+
+    std::string blockName(name.data(), length);
+    uniformBlocks[blockName] = i;
+
+    if (blockName == kdr::Graphics::cameraBlockName)
+    {
+      glUniformBlockBinding(ID, i, kdr::Graphics::cameraBlockBinding);
+    }
+  }
 }
 
-kdr::Graphics::VBO::VBO(GLfloat vertices[], GLsizeiptr size)
+kdr::Graphics::UniformBuffer::UniformBuffer(const GLsizeiptr size, const GLuint binding)
+: binding(binding), size(size)
 {
   glGenBuffers(1, &ID);
-  Bind();
-  glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
-  Unbind();
+  kdr::Graphics::getStateCache().bindBuffer(GL_UNIFORM_BUFFER, ID);
+  glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+  kdr::Graphics::getStateCache().bindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
 }
 
-kdr::Graphics::EBO::EBO(GLuint indices[], GLsizeiptr size)
+void kdr::Graphics::UniformBuffer::Update(const void* data, const GLsizeiptr size, const GLintptr offset)
+{
+  KDR_PROFILE_SCOPE("UniformBuffer::Update");
+  if (offset < 0 || size < 0 || offset > this->size || size > this->size - offset)
+  {
+    std::cerr << "Failed to update the uniform buffer: " << size << " bytes at offset " << offset << " exceed its " << this->size << " bytes!\n";
+    return;
+  }
+
+  kdr::Graphics::getStateCache().bindBuffer(GL_UNIFORM_BUFFER, ID);
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+kdr::Graphics::VBO::VBO(const void* vertices, GLsizeiptr size, GLenum usage)
 {
   glGenBuffers(1, &ID);
   Bind();
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
-  Unbind();
+  glBufferData(GL_ARRAY_BUFFER, size, vertices, usage);
 }
 
-void kdr::Graphics::VAO::LinkAtrib(kdr::Graphics::VBO& VBO, GLuint layout, GLuint size, GLenum type, GLsizeiptr stride, const void* offset)
+kdr::Graphics::EBO::EBO(const GLuint* indices, GLsizeiptr size, GLenum usage)
 {
+  // Uploading through the copy target so the element binding of a bound VAO is left alone
+  glGenBuffers(1, &ID);
+  kdr::Graphics::getStateCache().bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, indices, usage);
+}
+
+void kdr::Graphics::VAO::LinkAtrib(kdr::Graphics::VBO& VBO, GLuint layout, GLuint size, GLenum type, GLsizeiptr stride, const void* offset, GLuint divisor)
+{
+  VBO.Bind();
   glVertexAttribPointer(layout, size, type, GL_FALSE, stride, offset);
   glEnableVertexAttribArray(layout);
+  // Set even when 0, so relinking a layout that used to be per-instance resets it
+  glVertexAttribDivisor(layout, divisor);
+}
+
+kdr::Graphics::InstanceBuffer::InstanceBuffer(const GLsizei capacity)
+{
+  glGenBuffers(1, &ID);
+  _allocate(capacity > 0 ? capacity : 1);
+}
+
+void kdr::Graphics::InstanceBuffer::Update(const kdr::Space::Mat4* models, const kdr::Color::RGBA* colors, const GLsizei count)
+{
+  KDR_PROFILE_SCOPE("InstanceBuffer::Update");
+
+  if (count > capacity)
+  {
+    GLsizei newCapacity = capacity * 2;
+    _allocate(newCapacity > count ? newCapacity : count);
+  }
+  else
+  {
+    // Orphaning the storage so the driver doesn't wait for draws still reading it
+    Bind();
+    glBufferData(GL_ARRAY_BUFFER, capacity * (sizeof(kdr::Space::Mat4) + sizeof(kdr::Color::RGBA)), NULL, GL_STREAM_DRAW);
+  }
+
+  if (colors == NULL)
+  {
+    if ((GLsizei)defaultColors.size() < count)
+    {
+      defaultColors.resize(count, kdr::Color::White);
+    }
+    colors = defaultColors.data();
+  }
+
+  Bind();
+  glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(kdr::Space::Mat4), models);
+  glBufferSubData(GL_ARRAY_BUFFER, capacity * sizeof(kdr::Space::Mat4), count * sizeof(kdr::Color::RGBA), colors);
+
+  this->count = count;
+}
+
+void kdr::Graphics::InstanceBuffer::Link(kdr::Graphics::VAO& VAO, const GLuint layout)
+{
+  links.push_back({VAO.getID(), layout});
+  _linkAttributes(VAO.getID(), layout);
+}
+
+void kdr::Graphics::InstanceBuffer::_allocate(const GLsizei capacity)
+{
+  this->capacity = capacity;
+
+  Bind();
+  glBufferData(GL_ARRAY_BUFFER, capacity * (sizeof(kdr::Space::Mat4) + sizeof(kdr::Color::RGBA)), NULL, GL_STREAM_DRAW);
+
+  // The color region moved, so every linked VAO needs its pointers refreshed
+  for (const std::pair<GLuint, GLuint>& link : links)
+  {
+    _linkAttributes(link.first, link.second);
+  }
+}
+
+void kdr::Graphics::InstanceBuffer::_linkAttributes(const GLuint vaoID, const GLuint layout)
+{
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  const GLuint previousVAO = stateCache.getVertexArray();
+
+  stateCache.bindVertexArray(vaoID);
+  Bind();
+  for (GLuint column = 0; column < 4; column++)
+  {
+    glVertexAttribPointer(
+      layout + column,
+      4,
+      GL_FLOAT,
+      GL_FALSE,
+      sizeof(kdr::Space::Mat4),
+      (void*)(column * 4 * sizeof(GLfloat))
+    );
+    glEnableVertexAttribArray(layout + column);
+    glVertexAttribDivisor(layout + column, 1);
+  }
+  glVertexAttribPointer(
+    layout + 4,
+    4,
+    GL_FLOAT,
+    GL_FALSE,
+    sizeof(kdr::Color::RGBA),
+    (void*)(capacity * sizeof(kdr::Space::Mat4))
+  );
+  glEnableVertexAttribArray(layout + 4);
+  glVertexAttribDivisor(layout + 4, 1);
+  stateCache.bindVertexArray(previousVAO);
+}
+
+kdr::Graphics::StreamBuffer::StreamBuffer(const GLenum target, const GLsizeiptr frameSize, const GLuint frameCount)
+: target(target), frameSize(frameSize), frameCount(frameCount > 0 ? frameCount : 1)
+{
+  const GLsizeiptr totalSize = this->frameSize * this->frameCount;
+
+  // Written through the copy target, so the element binding of a bound VAO is left alone
+  glGenBuffers(1, &ID);
+  _bindForWrite();
+
+  if (GLEW_ARB_buffer_storage)
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, NULL, flags);
+    mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags);
+    if (mapped == NULL)
+    {
+      std::cerr << "Failed to persistently map the stream buffer, falling back to glBufferSubData!\n";
+
+      // Immutable storage can't be respecified, so the fallback needs a fresh buffer
+      kdr::Graphics::getStateCache().onBufferDeleted(ID);
+      glDeleteBuffers(1, &ID);
+      glGenBuffers(1, &ID);
+      _bindForWrite();
+    }
+  }
+
+  if (mapped == NULL)
+  {
+    glBufferData(GL_COPY_WRITE_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+  }
+
+  fences.resize(this->frameCount, (GLsync)0);
+}
+
+void kdr::Graphics::StreamBuffer::BeginFrame()
+{
+  frame = (frame + 1) % frameCount;
+  cursor = 0;
+
+  if (mapped == NULL)
+  {
+    // Orphaning once per lap hands the driver fresh storage instead of waiting on old draws
+    if (frame == 0)
+    {
+      _bindForWrite();
+      glBufferData(GL_COPY_WRITE_BUFFER, frameSize * frameCount, NULL, GL_STREAM_DRAW);
+    }
+    return;
+  }
+
+  GLsync fence = fences[frame];
+  if (fence == (GLsync)0) return;
+
+  GLenum result = glClientWaitSync(fence, 0, 0);
+  while (result == GL_TIMEOUT_EXPIRED)
+  {
+    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+  }
+  if (result == GL_WAIT_FAILED)
+  {
+    std::cerr << "Failed to wait for a stream buffer fence!\n";
+  }
+
+  glDeleteSync(fence);
+  fences[frame] = (GLsync)0;
+}
+
+void kdr::Graphics::StreamBuffer::EndFrame()
+{
+  if (mapped == NULL) return;
+
+  if (fences[frame] != (GLsync)0)
+  {
+    glDeleteSync(fences[frame]);
+  }
+  fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* kdr::Graphics::StreamBuffer::Map(const GLsizeiptr size, GLintptr& offset, const GLsizeiptr alignment)
+{
+  offset = _reserve(size, alignment);
+  if (offset < 0)
+  {
+    return NULL;
+  }
+
+  if (mapped != NULL)
+  {
+    return mapped + offset;
+  }
+
+  if ((GLsizeiptr)staging.size() < size)
+  {
+    staging.resize(size);
+  }
+  stagingOffset = offset;
+  stagingSize = size;
+  return staging.data();
+}
+
+void kdr::Graphics::StreamBuffer::Unmap()
+{
+  if (mapped != NULL || stagingSize == 0) return;
+
+  _bindForWrite();
+  glBufferSubData(GL_COPY_WRITE_BUFFER, stagingOffset, stagingSize, staging.data());
+  stagingSize = 0;
+}
+
+GLintptr kdr::Graphics::StreamBuffer::Write(const void* data, const GLsizeiptr size, const GLsizeiptr alignment)
+{
+  KDR_PROFILE_SCOPE("StreamBuffer::Write");
+
+  const GLintptr offset = _reserve(size, alignment);
+  if (offset < 0)
+  {
+    return -1;
+  }
+
+  if (mapped != NULL)
+  {
+    memcpy(mapped + offset, data, size);
+  }
+  else
+  {
+    _bindForWrite();
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+  }
+  return offset;
+}
+
+GLintptr kdr::Graphics::StreamBuffer::_reserve(const GLsizeiptr size, const GLsizeiptr alignment)
+{
+  // The offset from the start of the buffer is what gets bound, so that is what gets aligned
+  const GLintptr frameStart = (GLintptr)frame * frameSize;
+  GLintptr offset = frameStart + cursor;
+  if (alignment > 1 && offset % alignment != 0)
+  {
+    offset += alignment - offset % alignment;
+  }
+  if (offset - frameStart + size > frameSize)
+  {
+    return -1;
+  }
+
+  cursor = offset - frameStart + size;
+  return offset;
+}
+
+void kdr::Graphics::StreamBuffer::Delete()
+{
+  for (GLsync& fence : fences)
+  {
+    if (fence != (GLsync)0)
+    {
+      glDeleteSync(fence);
+      fence = (GLsync)0;
+    }
+  }
+
+  if (mapped != NULL)
+  {
+    _bindForWrite();
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    mapped = NULL;
+  }
+
+  kdr::Graphics::getStateCache().onBufferDeleted(ID);
+  glDeleteBuffers(1, &ID);
+}
+
+kdr::Graphics::Framebuffer::Framebuffer(const GLsizei width, const GLsizei height)
+: width(width), height(height)
+{
+  glGenFramebuffers(1, &ID);
+  glGenRenderbuffers(1, &colorID);
+  glGenRenderbuffers(1, &depthID);
+
+  _allocate();
+
+  glBindFramebuffer(GL_FRAMEBUFFER, ID);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorID);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthID);
+
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    std::cerr << "Failed to complete the framebuffer!\n";
+    std::cerr << "Status: 0x" << std::hex << status << std::dec << '\n';
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void kdr::Graphics::Framebuffer::Bind()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, ID);
+  glViewport(0, 0, width, height);
+}
+
+void kdr::Graphics::Framebuffer::Resize(const GLsizei width, const GLsizei height)
+{
+  if (width == this->width && height == this->height) return;
+
+  this->width = width;
+  this->height = height;
+  _allocate();
+}
+
+void kdr::Graphics::Framebuffer::ReadPixels(std::vector<unsigned char>& pixels)
+{
+  pixels.resize((size_t)width * height * 4);
+
+  kdr::Graphics::getStateCache().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, ID);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+void kdr::Graphics::Framebuffer::Delete()
+{
+  glDeleteFramebuffers(1, &ID);
+  glDeleteRenderbuffers(1, &colorID);
+  glDeleteRenderbuffers(1, &depthID);
+}
+
+void kdr::Graphics::Framebuffer::_allocate()
+{
+  glBindRenderbuffer(GL_RENDERBUFFER, colorID);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthID);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
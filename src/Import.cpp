@@ -0,0 +1,1340 @@
+#include "Kedarium/Import.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <iostream>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Kedarium/File.hpp"
+#include "Kedarium/Jobs.hpp"
+#include "Kedarium/Profiler.hpp"
+#include "Kedarium/Space.hpp"
+
+// Import Settings
+constexpr size_t   OBJ_MIN_CHUNK_SIZE {1 << 20};
+constexpr uint32_t ABSENT_INDEX       {0xFFFFFFFF};
+constexpr int      JSON_MAX_DEPTH     {64};
+
+// Identifies one OBJ face corner by its position, texture coordinate and normal indices
+struct VertexKey
+{
+  uint32_t position;
+  uint32_t uv;
+  uint32_t normal;
+
+  bool operator==(const VertexKey& other) const
+  { return position == other.position && uv == other.uv && normal == other.normal; }
+};
+
+// Open addressing hash table from vertex keys to vertex indices, much lighter than std::unordered_map
+class VertexTable
+{
+  public:
+    void reserve(const size_t count)
+    {
+      size_t capacity = 64;
+      while (capacity < count * 2) capacity *= 2;
+      if (capacity > values.size()) _rehash(capacity);
+    }
+
+    // Returns the index already stored for the key, or stores and returns the given one
+    uint32_t insert(const VertexKey& key, const uint32_t index)
+    {
+      if ((count + 1) * 2 > values.size()) _rehash(std::max<size_t>(values.size() * 2, 64));
+
+      const size_t mask = values.size() - 1;
+      for (size_t slot = _hash(key) & mask;; slot = (slot + 1) & mask)
+      {
+        if (values[slot] == ABSENT_INDEX)
+        {
+          keys[slot] = key;
+          values[slot] = index;
+          count++;
+          return index;
+        }
+        if (keys[slot] == key) return values[slot];
+      }
+    }
+
+  private:
+    std::vector<VertexKey> keys;
+    std::vector<uint32_t>  values;
+    size_t                 count {0};
+
+    static size_t _hash(const VertexKey& key)
+    {
+      uint64_t hash = key.position * 0x9E3779B97F4A7C15ull;
+      hash ^= (key.uv + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+      hash ^= (key.normal + 0x85EBCA77C2B2AE63ull) * 0x165667B19E3779F9ull;
+      return (size_t)(hash ^ (hash >> 29));
+    }
+
+    void _rehash(const size_t capacity)
+    {
+      std::vector<VertexKey> oldKeys(capacity);
+      std::vector<uint32_t> oldValues(capacity, ABSENT_INDEX);
+      oldKeys.swap(keys);
+      oldValues.swap(values);
+
+      const size_t mask = capacity - 1;
+      for (size_t i = 0; i < oldValues.size(); i++)
+      {
+        if (oldValues[i] == ABSENT_INDEX) continue;
+
+        size_t slot = _hash(oldKeys[i]) & mask;
+        while (values[slot] != ABSENT_INDEX) slot = (slot + 1) & mask;
+        keys[slot] = oldKeys[i];
+        values[slot] = oldValues[i];
+      }
+    }
+};
+
+static bool isBlank(const char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* skipBlanks(const char* cursor, const char* end)
+{
+  while (cursor < end && isBlank(*cursor)) cursor++;
+  return cursor;
+}
+
+static const char* skipLine(const char* cursor, const char* end)
+{
+  const char* newline = (const char*)memchr(cursor, '\n', end - cursor);
+  return newline != NULL ? newline + 1 : end;
+}
+
+static bool isKeyword(const char* cursor, const char* end, const char* keyword)
+{
+  const size_t length = strlen(keyword);
+  return (size_t)(end - cursor) > length && memcmp(cursor, keyword, length) == 0 && isBlank(cursor[length]);
+}
+
+static bool isDigit(const char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// Parses a decimal float without the locale handling and null terminator strtof needs
+static float parseFloat(const char*& cursor, const char* end)
+{
+  static const double powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  cursor = skipBlanks(cursor, end);
+  bool isNegative {false};
+  if (cursor < end && (*cursor == '-' || *cursor == '+')) isNegative = *cursor++ == '-';
+
+  uint64_t mantissa {0};
+  int exponent {0};
+  for (; cursor < end && isDigit(*cursor); cursor++)
+  {
+    if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + (*cursor - '0');
+    else exponent++;
+  }
+  if (cursor < end && *cursor == '.')
+  {
+    for (cursor++; cursor < end && isDigit(*cursor); cursor++)
+    {
+      if (mantissa < 100000000000000000ull)
+      {
+        mantissa = mantissa * 10 + (*cursor - '0');
+        exponent--;
+      }
+    }
+  }
+  if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+  {
+    cursor++;
+    bool isExponentNegative {false};
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) isExponentNegative = *cursor++ == '-';
+    int value {0};
+    for (; cursor < end && isDigit(*cursor); cursor++) value = std::min(value * 10 + (*cursor - '0'), 1000);
+    exponent += isExponentNegative ? -value : value;
+  }
+
+  double result = (double)mantissa;
+  if (exponent < 0) result = -exponent <= 22 ? result / powers[-exponent] : result * pow(10., exponent);
+  else if (exponent > 0) result = exponent <= 22 ? result * powers[exponent] : result * pow(10., exponent);
+  return (float)(isNegative ? -result : result);
+}
+
+static long parseInt(const char*& cursor, const char* end)
+{
+  bool isNegative {false};
+  if (cursor < end && (*cursor == '-' || *cursor == '+')) isNegative = *cursor++ == '-';
+
+  long value {0};
+  for (; cursor < end && isDigit(*cursor); cursor++) value = value * 10 + (*cursor - '0');
+  return isNegative ? -value : value;
+}
+
+// Resolves a one-based or negative relative OBJ index against the elements read so far
+static uint32_t resolveObjIndex(const long index, const size_t readCount, const size_t totalCount)
+{
+  const long resolved = index < 0 ? (long)readCount + index : index - 1;
+  return resolved >= 0 && resolved < (long)totalCount ? (uint32_t)resolved : ABSENT_INDEX;
+}
+
+static kdr::Space::AABB computeBounds(const std::vector<kdr::Import::Vertex>& vertices)
+{
+  kdr::Space::AABB bounds;
+  std::mutex mutex;
+  kdr::Jobs::parallelFor(0, vertices.size(), 16384, [&](size_t begin, size_t end)
+  {
+    kdr::Space::AABB local;
+    for (size_t i = begin; i < end; i++)
+    {
+      local.expand(kdr::Space::Vec3(vertices[i].position[0], vertices[i].position[1], vertices[i].position[2]));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bounds.expand(local.min);
+    bounds.expand(local.max);
+  });
+  return bounds;
+}
+
+// Gives vertices that came without a normal the area weighted normal of their triangles
+static void generateNormals(kdr::Import::Vertex* vertices, const size_t vertexCount, const GLuint* indices, const size_t indexCount)
+{
+  std::vector<kdr::Space::Vec3> normals(vertexCount);
+  for (size_t i = 0; i + 2 < indexCount; i += 3)
+  {
+    const GLfloat* a = vertices[indices[i]].position;
+    const GLfloat* b = vertices[indices[i + 1]].position;
+    const GLfloat* c = vertices[indices[i + 2]].position;
+    const kdr::Space::Vec3 ab {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const kdr::Space::Vec3 ac {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    const kdr::Space::Vec3 normal = kdr::Space::cross(ab, ac);
+    normals[indices[i]] += normal;
+    normals[indices[i + 1]] += normal;
+    normals[indices[i + 2]] += normal;
+  }
+
+  for (size_t i = 0; i < vertexCount; i++)
+  {
+    GLfloat* normal = vertices[i].normal;
+    if (normal[0] != 0.f || normal[1] != 0.f || normal[2] != 0.f) continue;
+
+    const kdr::Space::Vec3 generated = kdr::Space::normalize(normals[i]);
+    normal[0] = generated.x;
+    normal[1] = generated.y;
+    normal[2] = generated.z;
+  }
+}
+
+const std::vector<kdr::Graphics::VertexAttribute> kdr::Import::getVertexAttributes()
+{
+  return {
+    kdr::Graphics::VertexAttribute(0, 3, GL_FLOAT, offsetof(kdr::Import::Vertex, position)),
+    kdr::Graphics::VertexAttribute(1, 3, GL_FLOAT, offsetof(kdr::Import::Vertex, normal)),
+    kdr::Graphics::VertexAttribute(2, 2, GL_FLOAT, offsetof(kdr::Import::Vertex, uv)),
+  };
+}
+
+void kdr::Import::linkAttributes(kdr::Graphics::VAO& VAO, kdr::Graphics::VBO& VBO)
+{
+  for (const kdr::Graphics::VertexAttribute& attribute : kdr::Import::getVertexAttributes())
+  {
+    VAO.LinkAtrib(VBO, attribute.layout, attribute.size, attribute.type, sizeof(kdr::Import::Vertex), (void*)attribute.offset);
+  }
+}
+
+// One newline aligned slice of an OBJ file, parsed by one job
+struct ObjChunk
+{
+  const char* begin;
+  const char* end;
+
+  size_t positionCount {0};
+  size_t uvCount       {0};
+  size_t normalCount   {0};
+  size_t positionBase  {0};
+  size_t uvBase        {0};
+  size_t normalBase    {0};
+
+  // Corners are deduplicated inside the chunk first, then merged across chunks
+  std::vector<VertexKey>            keys;
+  std::vector<uint32_t>             indices;
+  std::vector<uint32_t>             remap;
+  std::vector<kdr::Import::Submesh> groups;
+  size_t                            indexBase {0};
+  bool                              isValid   {true};
+};
+
+static void countObjChunk(ObjChunk& chunk)
+{
+  for (const char* line = chunk.begin; line < chunk.end; line = skipLine(line, chunk.end))
+  {
+    const char* cursor = skipBlanks(line, chunk.end);
+    if (chunk.end - cursor < 2 || cursor[0] != 'v') continue;
+
+    if (isBlank(cursor[1])) chunk.positionCount++;
+    else if (isKeyword(cursor, chunk.end, "vt")) chunk.uvCount++;
+    else if (isKeyword(cursor, chunk.end, "vn")) chunk.normalCount++;
+  }
+}
+
+static void parseObjChunk(
+  ObjChunk& chunk,
+  GLfloat* positions,
+  GLfloat* uvs,
+  GLfloat* normals,
+  const size_t positionTotal,
+  const size_t uvTotal,
+  const size_t normalTotal
+)
+{
+  const char* end = chunk.end;
+  size_t positionIndex = chunk.positionBase;
+  size_t uvIndex = chunk.uvBase;
+  size_t normalIndex = chunk.normalBase;
+
+  VertexTable table;
+  table.reserve((size_t)(end - chunk.begin) / 32);
+  std::vector<uint32_t> face;
+
+  for (const char* line = chunk.begin; line < end; line = skipLine(line, end))
+  {
+    const char* cursor = skipBlanks(line, end);
+    if (cursor >= end) break;
+
+    if (isKeyword(cursor, end, "v"))
+    {
+      cursor++;
+      GLfloat* position = positions + positionIndex++ * 3;
+      position[0] = parseFloat(cursor, end);
+      position[1] = parseFloat(cursor, end);
+      position[2] = parseFloat(cursor, end);
+    }
+    else if (isKeyword(cursor, end, "vt"))
+    {
+      cursor += 2;
+      GLfloat* uv = uvs + uvIndex++ * 2;
+      uv[0] = parseFloat(cursor, end);
+      uv[1] = parseFloat(cursor, end);
+    }
+    else if (isKeyword(cursor, end, "vn"))
+    {
+      cursor += 2;
+      GLfloat* normal = normals + normalIndex++ * 3;
+      normal[0] = parseFloat(cursor, end);
+      normal[1] = parseFloat(cursor, end);
+      normal[2] = parseFloat(cursor, end);
+    }
+    else if (isKeyword(cursor, end, "f"))
+    {
+      face.clear();
+      for (cursor = skipBlanks(cursor + 1, end); cursor < end && *cursor != '\n' && *cursor != '#'; cursor = skipBlanks(cursor, end))
+      {
+        // Corners are "v", "v/vt", "v//vn" or "v/vt/vn"
+        long references[3] {parseInt(cursor, end), 0, 0};
+        if (cursor < end && *cursor == '/')
+        {
+          cursor++;
+          references[1] = parseInt(cursor, end);
+          if (cursor < end && *cursor == '/')
+          {
+            cursor++;
+            references[2] = parseInt(cursor, end);
+          }
+        }
+
+        VertexKey key;
+        key.position = resolveObjIndex(references[0], positionIndex, positionTotal);
+        key.uv = references[1] != 0 ? resolveObjIndex(references[1], uvIndex, uvTotal) : ABSENT_INDEX;
+        key.normal = references[2] != 0 ? resolveObjIndex(references[2], normalIndex, normalTotal) : ABSENT_INDEX;
+        if (key.position == ABSENT_INDEX || (references[1] != 0 && key.uv == ABSENT_INDEX) || (references[2] != 0 && key.normal == ABSENT_INDEX))
+        {
+          chunk.isValid = false;
+          return;
+        }
+
+        const uint32_t index = table.insert(key, (uint32_t)chunk.keys.size());
+        if (index == chunk.keys.size()) chunk.keys.push_back(key);
+        face.push_back(index);
+
+        while (cursor < end && !isBlank(*cursor) && *cursor != '\n') cursor++;
+      }
+
+      for (size_t i = 2; i < face.size(); i++)
+      {
+        chunk.indices.push_back(face[0]);
+        chunk.indices.push_back(face[i - 1]);
+        chunk.indices.push_back(face[i]);
+      }
+    }
+    else if (isKeyword(cursor, end, "o") || isKeyword(cursor, end, "g") || isKeyword(cursor, end, "usemtl"))
+    {
+      while (cursor < end && !isBlank(*cursor)) cursor++;
+      cursor = skipBlanks(cursor, end);
+      const char* nameEnd = skipLine(cursor, end);
+      while (nameEnd > cursor && (nameEnd[-1] == '\n' || isBlank(nameEnd[-1]))) nameEnd--;
+
+      kdr::Import::Submesh group;
+      group.name.assign(cursor, nameEnd);
+      group.firstIndex = (GLuint)chunk.indices.size();
+      chunk.groups.push_back(group);
+    }
+  }
+}
+
+bool kdr::Import::loadObj(const char* path, kdr::Import::Model& model)
+{
+  KDR_PROFILE_SCOPE("Import::loadObj");
+
+  model = kdr::Import::Model();
+  kdr::File::MappedFile file;
+  if (!file.open(path))
+  {
+    std::cerr << "Failed to import the OBJ file: " << path << "!\n";
+    return false;
+  }
+
+  // Chunks end on line breaks, so every line is parsed by exactly one job
+  const char* data = (const char*)file.getData();
+  const char* dataEnd = data + file.getSize();
+  const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(file.getSize() / OBJ_MIN_CHUNK_SIZE, kdr::Jobs::getScheduler().getThreadCount() * 4 + 4));
+  std::vector<ObjChunk> chunks(chunkCount);
+  const char* chunkBegin = data;
+  for (size_t i = 0; i < chunkCount; i++)
+  {
+    const char* chunkEnd = i + 1 < chunkCount ? data + file.getSize() * (i + 1) / chunkCount : dataEnd;
+    chunks[i].begin = chunkBegin;
+    chunks[i].end = chunkEnd > chunkBegin ? skipLine(chunkEnd - 1, dataEnd) : chunkBegin;
+    chunkBegin = chunks[i].end;
+  }
+
+  // Counting the elements of every chunk first lets all chunks write straight into shared arrays
+  // and resolve relative indices without waiting for the chunks before them
+  kdr::Jobs::parallelFor(0, chunkCount, 1, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++) countObjChunk(chunks[i]);
+  });
+
+  size_t positionTotal {0}, uvTotal {0}, normalTotal {0};
+  for (ObjChunk& chunk : chunks)
+  {
+    chunk.positionBase = positionTotal;
+    chunk.uvBase = uvTotal;
+    chunk.normalBase = normalTotal;
+    positionTotal += chunk.positionCount;
+    uvTotal += chunk.uvCount;
+    normalTotal += chunk.normalCount;
+  }
+  std::vector<GLfloat> positions(positionTotal * 3);
+  std::vector<GLfloat> uvs(uvTotal * 2);
+  std::vector<GLfloat> normals(normalTotal * 3);
+
+  kdr::Jobs::parallelFor(0, chunkCount, 1, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      parseObjChunk(chunks[i], positions.data(), uvs.data(), normals.data(), positionTotal, uvTotal, normalTotal);
+    }
+  });
+
+  // Merging the per-chunk vertices only touches unique corners, a fraction of all corners
+  size_t keyTotal {0}, indexTotal {0};
+  for (ObjChunk& chunk : chunks)
+  {
+    if (!chunk.isValid)
+    {
+      std::cerr << "Failed to import the OBJ file: " << path << " has a face with an invalid index!\n";
+      return false;
+    }
+    chunk.indexBase = indexTotal;
+    keyTotal += chunk.keys.size();
+    indexTotal += chunk.indices.size();
+  }
+  if (indexTotal == 0 || indexTotal > 0xFFFFFFFFull)
+  {
+    std::cerr << "Failed to import the OBJ file: " << path << " has no faces or too many!\n";
+    return false;
+  }
+
+  VertexTable table;
+  table.reserve(keyTotal);
+  std::vector<VertexKey> keys;
+  keys.reserve(keyTotal);
+  for (ObjChunk& chunk : chunks)
+  {
+    chunk.remap.resize(chunk.keys.size());
+    for (size_t i = 0; i < chunk.keys.size(); i++)
+    {
+      chunk.remap[i] = table.insert(chunk.keys[i], (uint32_t)keys.size());
+      if (chunk.remap[i] == keys.size()) keys.push_back(chunk.keys[i]);
+    }
+  }
+
+  model.vertices.resize(keys.size());
+  model.indices.resize(indexTotal);
+  std::atomic<bool> isNormalMissing {false};
+  kdr::Jobs::parallelFor(0, keys.size(), 16384, [&](size_t begin, size_t end)
+  {
+    bool isMissing {false};
+    for (size_t i = begin; i < end; i++)
+    {
+      const VertexKey& key = keys[i];
+      kdr::Import::Vertex& vertex = model.vertices[i];
+      memcpy(vertex.position, &positions[key.position * 3], sizeof(vertex.position));
+      if (key.normal != ABSENT_INDEX) memcpy(vertex.normal, &normals[key.normal * 3], sizeof(vertex.normal));
+      else memset(vertex.normal, 0, sizeof(vertex.normal));
+      if (key.uv != ABSENT_INDEX) memcpy(vertex.uv, &uvs[key.uv * 2], sizeof(vertex.uv));
+      else memset(vertex.uv, 0, sizeof(vertex.uv));
+      isMissing = isMissing || key.normal == ABSENT_INDEX;
+    }
+    if (isMissing) isNormalMissing.store(true, std::memory_order_relaxed);
+  });
+  kdr::Jobs::parallelFor(0, chunkCount, 1, [&](size_t begin, size_t end)
+  {
+    for (size_t c = begin; c < end; c++)
+    {
+      const ObjChunk& chunk = chunks[c];
+      GLuint* indices = model.indices.data() + chunk.indexBase;
+      for (size_t i = 0; i < chunk.indices.size(); i++) indices[i] = chunk.remap[chunk.indices[i]];
+    }
+  });
+  if (isNormalMissing.load())
+  {
+    generateNormals(model.vertices.data(), model.vertices.size(), model.indices.data(), model.indices.size());
+  }
+
+  // Every group statement closes the submesh before it; empty ones are dropped
+  kdr::Import::Submesh submesh;
+  for (const ObjChunk& chunk : chunks)
+  {
+    for (const kdr::Import::Submesh& group : chunk.groups)
+    {
+      const GLuint firstIndex = (GLuint)chunk.indexBase + group.firstIndex;
+      submesh.indexCount = firstIndex - submesh.firstIndex;
+      if (submesh.indexCount > 0) model.submeshes.push_back(submesh);
+
+      submesh.name = group.name;
+      submesh.firstIndex = firstIndex;
+    }
+  }
+  submesh.indexCount = (GLuint)indexTotal - submesh.firstIndex;
+  if (submesh.indexCount > 0) model.submeshes.push_back(submesh);
+
+  model.bounds = computeBounds(model.vertices);
+  return true;
+}
+
+// Minimal JSON document tree, enough for glTF
+struct JsonValue
+{
+  enum Type { Null, Boolean, Number, String, Array, Object };
+
+  Type                     type   {Null};
+  double                   number {0.};
+  std::string              string;
+  std::vector<JsonValue>   items;
+  std::vector<std::string> keys;
+
+  const JsonValue* find(const char* key) const
+  {
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      if (keys[i] == key) return &items[i];
+    }
+    return NULL;
+  }
+
+  const JsonValue* at(const size_t index) const
+  { return type == Array && index < items.size() ? &items[index] : NULL; }
+
+  double getNumber(const char* key, const double fallback) const
+  {
+    const JsonValue* value = find(key);
+    return value != NULL && (value->type == Number || value->type == Boolean) ? value->number : fallback;
+  }
+
+  // Negative, fractional and huge numbers have no meaning as an index or a size, and casting
+  // them to size_t would be undefined or wrap around
+  bool getIndex(size_t& index) const
+  {
+    if (type != Number || !(number >= 0.) || number != floor(number) || number >= 9007199254740992.) return false;
+    index = (size_t)number;
+    return true;
+  }
+
+  bool getIndex(const char* key, const size_t fallback, size_t& index) const
+  {
+    const JsonValue* value = find(key);
+    if (value == NULL)
+    {
+      index = fallback;
+      return true;
+    }
+    return value->getIndex(index);
+  }
+};
+
+class JsonParser
+{
+  public:
+    JsonParser(const char* begin, const char* end)
+    : cursor(begin), end(end)
+    {}
+
+    bool parse(JsonValue& value)
+    {
+      return _parseValue(value, 0) && _skipSpaces() == end;
+    }
+
+  private:
+    const char* cursor;
+    const char* end;
+
+    const char* _skipSpaces()
+    {
+      while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) cursor++;
+      return cursor;
+    }
+
+    bool _parseLiteral(const char* literal)
+    {
+      const size_t length = strlen(literal);
+      if ((size_t)(end - cursor) < length || memcmp(cursor, literal, length) != 0) return false;
+      cursor += length;
+      return true;
+    }
+
+    static void _appendUtf8(std::string& string, const uint32_t codePoint)
+    {
+      if (codePoint < 0x80)
+      {
+        string += (char)codePoint;
+      }
+      else if (codePoint < 0x800)
+      {
+        string += (char)(0xC0 | (codePoint >> 6));
+        string += (char)(0x80 | (codePoint & 0x3F));
+      }
+      else if (codePoint < 0x10000)
+      {
+        string += (char)(0xE0 | (codePoint >> 12));
+        string += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        string += (char)(0x80 | (codePoint & 0x3F));
+      }
+      else
+      {
+        string += (char)(0xF0 | (codePoint >> 18));
+        string += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        string += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        string += (char)(0x80 | (codePoint & 0x3F));
+      }
+    }
+
+    bool _parseHex(uint32_t& value)
+    {
+      if (end - cursor < 4) return false;
+      value = 0;
+      for (int i = 0; i < 4; i++)
+      {
+        const char c = *cursor++;
+        value <<= 4;
+        if (isDigit(c)) value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return false;
+      }
+      return true;
+    }
+
+    bool _parseString(std::string& string)
+    {
+      cursor++;
+      while (cursor < end && *cursor != '"')
+      {
+        const char* run = cursor;
+        while (cursor < end && *cursor != '"' && *cursor != '\\') cursor++;
+        string.append(run, cursor);
+        if (cursor >= end || *cursor == '"') break;
+
+        cursor++;
+        if (cursor >= end) return false;
+        const char escape = *cursor++;
+        switch (escape)
+        {
+          case '"':  string += '"';  break;
+          case '\\': string += '\\'; break;
+          case '/':  string += '/';  break;
+          case 'b':  string += '\b'; break;
+          case 'f':  string += '\f'; break;
+          case 'n':  string += '\n'; break;
+          case 'r':  string += '\r'; break;
+          case 't':  string += '\t'; break;
+          case 'u':
+          {
+            uint32_t codePoint {0};
+            if (!_parseHex(codePoint)) return false;
+            uint32_t low {0};
+            if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u')
+            {
+              cursor += 2;
+              if (!_parseHex(low)) return false;
+              codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+            _appendUtf8(string, codePoint);
+            break;
+          }
+          default:
+            return false;
+        }
+      }
+      if (cursor >= end) return false;
+      cursor++;
+      return true;
+    }
+
+    bool _parseNumber(double& number)
+    {
+      // strtod needs a terminated string, and JSON numbers are short
+      char buffer[64];
+      size_t length {0};
+      while (cursor < end && length + 1 < sizeof(buffer) && (isDigit(*cursor) || strchr("+-.eE", *cursor) != NULL))
+      {
+        buffer[length++] = *cursor++;
+      }
+      buffer[length] = '\0';
+
+      char* parsedEnd = NULL;
+      number = strtod(buffer, &parsedEnd);
+      return length > 0 && parsedEnd == buffer + length;
+    }
+
+    bool _parseValue(JsonValue& value, const int depth)
+    {
+      if (depth > JSON_MAX_DEPTH || _skipSpaces() >= end) return false;
+
+      switch (*cursor)
+      {
+        case '{':
+        {
+          value.type = JsonValue::Object;
+          cursor++;
+          if (_skipSpaces() < end && *cursor == '}')
+          {
+            cursor++;
+            return true;
+          }
+          while (true)
+          {
+            if (_skipSpaces() >= end || *cursor != '"') return false;
+            value.keys.emplace_back();
+            if (!_parseString(value.keys.back())) return false;
+            if (_skipSpaces() >= end || *cursor++ != ':') return false;
+            value.items.emplace_back();
+            if (!_parseValue(value.items.back(), depth + 1)) return false;
+            if (_skipSpaces() >= end) return false;
+            if (*cursor == '}') break;
+            if (*cursor++ != ',') return false;
+          }
+          cursor++;
+          return true;
+        }
+        case '[':
+        {
+          value.type = JsonValue::Array;
+          cursor++;
+          if (_skipSpaces() < end && *cursor == ']')
+          {
+            cursor++;
+            return true;
+          }
+          while (true)
+          {
+            value.items.emplace_back();
+            if (!_parseValue(value.items.back(), depth + 1)) return false;
+            if (_skipSpaces() >= end) return false;
+            if (*cursor == ']') break;
+            if (*cursor++ != ',') return false;
+          }
+          cursor++;
+          return true;
+        }
+        case '"':
+          value.type = JsonValue::String;
+          return _parseString(value.string);
+        case 't':
+          value.type = JsonValue::Boolean;
+          value.number = 1.;
+          return _parseLiteral("true");
+        case 'f':
+          value.type = JsonValue::Boolean;
+          return _parseLiteral("false");
+        case 'n':
+          return _parseLiteral("null");
+        default:
+          value.type = JsonValue::Number;
+          return _parseNumber(value.number);
+      }
+    }
+};
+
+// Bytes of one glTF buffer, either inside the mapped file or decoded into owned memory
+struct GltfBuffer
+{
+  const unsigned char* data {NULL};
+  size_t               size {0};
+};
+
+// Typed view of one glTF accessor. A view without data, such as missing texture coordinates, reads as zeros
+struct GltfAccessor
+{
+  const unsigned char* data           {NULL};
+  size_t               count          {0};
+  size_t               stride         {0};
+  uint32_t             componentType  {GL_FLOAT};
+  bool                 isNormalized   {false};
+
+  float readFloat(const size_t index, const int component) const
+  {
+    if (data == NULL) return 0.f;
+
+    const unsigned char* element = data + index * stride;
+    switch (componentType)
+    {
+      case GL_BYTE:
+      {
+        const float value = (float)((const int8_t*)element)[component];
+        return isNormalized ? std::max(value / 127.f, -1.f) : value;
+      }
+      case GL_UNSIGNED_BYTE:
+      {
+        const float value = (float)element[component];
+        return isNormalized ? value / 255.f : value;
+      }
+      case GL_SHORT:
+      {
+        int16_t value;
+        memcpy(&value, element + component * sizeof(value), sizeof(value));
+        return isNormalized ? std::max(value / 32767.f, -1.f) : (float)value;
+      }
+      case GL_UNSIGNED_SHORT:
+      {
+        uint16_t value;
+        memcpy(&value, element + component * sizeof(value), sizeof(value));
+        return isNormalized ? value / 65535.f : (float)value;
+      }
+      case GL_UNSIGNED_INT:
+      {
+        uint32_t value;
+        memcpy(&value, element + component * sizeof(value), sizeof(value));
+        return (float)value;
+      }
+      default:
+      {
+        float value;
+        memcpy(&value, element + component * sizeof(value), sizeof(value));
+        return value;
+      }
+    }
+  }
+
+  uint32_t readIndex(const size_t index) const
+  {
+    if (data == NULL) return 0;
+
+    const unsigned char* element = data + index * stride;
+    if (componentType == GL_UNSIGNED_BYTE) return *element;
+    if (componentType == GL_UNSIGNED_SHORT)
+    {
+      uint16_t value;
+      memcpy(&value, element, sizeof(value));
+      return value;
+    }
+    uint32_t value;
+    memcpy(&value, element, sizeof(value));
+    return value;
+  }
+};
+
+// One primitive of one node, converted by one job
+struct GltfPrimitive
+{
+  std::string      name;
+  kdr::Space::Mat4 matrix      {1.f};
+  GltfAccessor     positions;
+  GltfAccessor     normals;
+  GltfAccessor     uvs;
+  GltfAccessor     indices;
+  bool             hasNormals  {false};
+  bool             hasIndices  {false};
+  size_t           firstVertex {0};
+  size_t           firstIndex  {0};
+  size_t           indexCount  {0};
+};
+
+static size_t getComponentSize(const uint32_t componentType)
+{
+  switch (componentType)
+  {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:  return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT: return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:          return 4;
+    default:                return 0;
+  }
+}
+
+// Index accessors may only use unsigned integer types, which readIndex() knows the size of
+static bool isGltfIndexType(const uint32_t componentType)
+{
+  return componentType == GL_UNSIGNED_BYTE || componentType == GL_UNSIGNED_SHORT || componentType == GL_UNSIGNED_INT;
+}
+
+static int getComponentCount(const std::string& type)
+{
+  if (type == "SCALAR") return 1;
+  if (type == "VEC2") return 2;
+  if (type == "VEC3") return 3;
+  if (type == "VEC4") return 4;
+  return 0;
+}
+
+static bool decodeBase64(const char* begin, const char* end, std::vector<unsigned char>& bytes)
+{
+  uint32_t bits {0};
+  int bitCount {0};
+  for (const char* cursor = begin; cursor < end && *cursor != '='; cursor++)
+  {
+    const char c = *cursor;
+    uint32_t value;
+    if (c >= 'A' && c <= 'Z') value = c - 'A';
+    else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+    else if (isDigit(c)) value = c - '0' + 52;
+    else if (c == '+' || c == '-') value = 62;
+    else if (c == '/' || c == '_') value = 63;
+    else return false;
+
+    bits = (bits << 6) | value;
+    bitCount += 6;
+    if (bitCount >= 8)
+    {
+      bitCount -= 8;
+      bytes.push_back((unsigned char)(bits >> bitCount));
+    }
+  }
+  return true;
+}
+
+static bool getGltfAccessor(
+  const JsonValue& root,
+  const std::vector<GltfBuffer>& buffers,
+  const JsonValue* indexValue,
+  const int expectedComponentCount,
+  GltfAccessor& accessor
+)
+{
+  size_t accessorIndex {0};
+  const JsonValue* accessors = root.find("accessors");
+  const JsonValue* description = indexValue != NULL && accessors != NULL && indexValue->getIndex(accessorIndex) ? accessors->at(accessorIndex) : NULL;
+  if (description == NULL || !description->getIndex("count", 0, accessor.count)) return false;
+
+  const JsonValue* type = description->find("type");
+  const int componentCount = type != NULL ? getComponentCount(type->string) : 0;
+  accessor.componentType = (uint32_t)description->getNumber("componentType", 0.);
+  accessor.isNormalized = description->getNumber("normalized", 0.) != 0.;
+  const size_t componentSize = getComponentSize(accessor.componentType);
+  if (componentCount != expectedComponentCount || componentSize == 0) return false;
+
+  // Sparse accessors would need their substitutions applied on top; not supported yet. Without
+  // them, an accessor with no buffer view is all zeros of any declared count, so it is refused too
+  const JsonValue* viewIndex = description->find("bufferView");
+  const JsonValue* views = root.find("bufferViews");
+  if (description->find("sparse") != NULL || viewIndex == NULL) return false;
+
+  size_t viewIndexValue {0};
+  const JsonValue* view = views != NULL && viewIndex->getIndex(viewIndexValue) ? views->at(viewIndexValue) : NULL;
+  if (view == NULL) return false;
+
+  const size_t elementSize = componentSize * componentCount;
+  size_t bufferIndex {0}, viewOffset {0}, viewLength {0}, offset {0};
+  const bool isValid =
+    view->getIndex("buffer", 0, bufferIndex) &&
+    view->getIndex("byteOffset", 0, viewOffset) &&
+    view->getIndex("byteLength", 0, viewLength) &&
+    view->getIndex("byteStride", elementSize, accessor.stride) &&
+    description->getIndex("byteOffset", 0, offset);
+  if (!isValid) return false;
+  if (bufferIndex >= buffers.size() || buffers[bufferIndex].data == NULL) return false;
+  if (viewOffset > buffers[bufferIndex].size || viewLength > buffers[bufferIndex].size - viewOffset) return false;
+
+  // Checked by division, since a huge declared count would overflow the end of the last element
+  if (accessor.count > 0)
+  {
+    if (accessor.stride < elementSize || offset > viewLength || elementSize > viewLength - offset) return false;
+    if (accessor.count - 1 > (viewLength - offset - elementSize) / accessor.stride) return false;
+  }
+
+  accessor.data = buffers[bufferIndex].data + viewOffset + offset;
+  return true;
+}
+
+static kdr::Space::Mat4 getGltfNodeMatrix(const JsonValue& node)
+{
+  kdr::Space::Mat4 matrix {1.f};
+  const JsonValue* elements = node.find("matrix");
+  if (elements != NULL && elements->items.size() == 16)
+  {
+    for (int i = 0; i < 16; i++) matrix[i / 4][i % 4] = (float)elements->items[i].number;
+    return matrix;
+  }
+
+  const JsonValue* translation = node.find("translation");
+  const JsonValue* rotation = node.find("rotation");
+  const JsonValue* scale = node.find("scale");
+  float t[3] {0.f, 0.f, 0.f};
+  float r[4] {0.f, 0.f, 0.f, 1.f};
+  float s[3] {1.f, 1.f, 1.f};
+  if (translation != NULL && translation->items.size() == 3) for (int i = 0; i < 3; i++) t[i] = (float)translation->items[i].number;
+  if (rotation != NULL && rotation->items.size() == 4) for (int i = 0; i < 4; i++) r[i] = (float)rotation->items[i].number;
+  if (scale != NULL && scale->items.size() == 3) for (int i = 0; i < 3; i++) s[i] = (float)scale->items[i].number;
+
+  // Translation * rotation * scale, with the rotation given as a unit quaternion (x, y, z, w)
+  const float x = r[0], y = r[1], z = r[2], w = r[3];
+  matrix[0][0] = (1.f - 2.f * (y * y + z * z)) * s[0];
+  matrix[0][1] = (2.f * (x * y + z * w)) * s[0];
+  matrix[0][2] = (2.f * (x * z - y * w)) * s[0];
+  matrix[1][0] = (2.f * (x * y - z * w)) * s[1];
+  matrix[1][1] = (1.f - 2.f * (x * x + z * z)) * s[1];
+  matrix[1][2] = (2.f * (y * z + x * w)) * s[1];
+  matrix[2][0] = (2.f * (x * z + y * w)) * s[2];
+  matrix[2][1] = (2.f * (y * z - x * w)) * s[2];
+  matrix[2][2] = (1.f - 2.f * (x * x + y * y)) * s[2];
+  matrix[3][0] = t[0];
+  matrix[3][1] = t[1];
+  matrix[3][2] = t[2];
+  return matrix;
+}
+
+// Nodes form trees, so a node reached twice means a cycle or a shared child and fails the walk
+static bool collectGltfNodes(
+  const JsonValue& root,
+  const size_t nodeIndex,
+  const kdr::Space::Mat4& parent,
+  const int depth,
+  std::vector<bool>& isVisited,
+  std::vector<std::pair<size_t, kdr::Space::Mat4>>& instances
+)
+{
+  const JsonValue* nodes = root.find("nodes");
+  const JsonValue* node = nodes != NULL ? nodes->at(nodeIndex) : NULL;
+  if (node == NULL || depth > JSON_MAX_DEPTH) return true;
+  if (isVisited[nodeIndex]) return false;
+  isVisited[nodeIndex] = true;
+
+  const kdr::Space::Mat4 matrix = parent * getGltfNodeMatrix(*node);
+  const JsonValue* mesh = node->find("mesh");
+  size_t meshIndex {0};
+  if (mesh != NULL && mesh->getIndex(meshIndex)) instances.push_back(std::make_pair(meshIndex, matrix));
+
+  const JsonValue* children = node->find("children");
+  if (children == NULL) return true;
+  for (const JsonValue& child : children->items)
+  {
+    size_t childIndex {0};
+    if (child.getIndex(childIndex) && !collectGltfNodes(root, childIndex, matrix, depth + 1, isVisited, instances)) return false;
+  }
+  return true;
+}
+
+static void convertGltfPrimitive(const GltfPrimitive& primitive, kdr::Import::Model& model, std::atomic<bool>& isValid)
+{
+  const kdr::Space::Mat4& m = primitive.matrix;
+  const size_t vertexCount = primitive.positions.count;
+  kdr::Import::Vertex* vertices = model.vertices.data() + primitive.firstVertex;
+  GLuint* indices = model.indices.data() + primitive.firstIndex;
+
+  // Normals go through the inverse transpose, built from cross products of the basis vectors
+  const kdr::Space::Vec3 a {m[0][0], m[0][1], m[0][2]};
+  const kdr::Space::Vec3 b {m[1][0], m[1][1], m[1][2]};
+  const kdr::Space::Vec3 c {m[2][0], m[2][1], m[2][2]};
+  const float determinant = kdr::Space::dot(a, kdr::Space::cross(b, c));
+  const float sign = determinant < 0.f ? -1.f : 1.f;
+  const kdr::Space::Vec3 nx = kdr::Space::cross(b, c) * sign;
+  const kdr::Space::Vec3 ny = kdr::Space::cross(c, a) * sign;
+  const kdr::Space::Vec3 nz = kdr::Space::cross(a, b) * sign;
+
+  for (size_t i = 0; i < vertexCount; i++)
+  {
+    kdr::Import::Vertex& vertex = vertices[i];
+    const float px = primitive.positions.readFloat(i, 0);
+    const float py = primitive.positions.readFloat(i, 1);
+    const float pz = primitive.positions.readFloat(i, 2);
+    vertex.position[0] = m[0][0] * px + m[1][0] * py + m[2][0] * pz + m[3][0];
+    vertex.position[1] = m[0][1] * px + m[1][1] * py + m[2][1] * pz + m[3][1];
+    vertex.position[2] = m[0][2] * px + m[1][2] * py + m[2][2] * pz + m[3][2];
+
+    kdr::Space::Vec3 normal;
+    if (primitive.hasNormals)
+    {
+      normal = kdr::Space::normalize(
+        nx * primitive.normals.readFloat(i, 0) +
+        ny * primitive.normals.readFloat(i, 1) +
+        nz * primitive.normals.readFloat(i, 2)
+      );
+    }
+    vertex.normal[0] = normal.x;
+    vertex.normal[1] = normal.y;
+    vertex.normal[2] = normal.z;
+    vertex.uv[0] = primitive.uvs.readFloat(i, 0);
+    vertex.uv[1] = primitive.uvs.readFloat(i, 1);
+  }
+
+  // Mirroring transforms turn triangles inside out, so their winding is flipped back
+  for (size_t i = 0; i < primitive.indexCount; i += 3)
+  {
+    for (size_t k = 0; k < 3; k++)
+    {
+      const size_t corner = determinant < 0.f && k > 0 ? 3 - k : k;
+      const uint32_t index = primitive.hasIndices ? primitive.indices.readIndex(i + corner) : (uint32_t)(i + corner);
+      if (index >= vertexCount)
+      {
+        isValid.store(false, std::memory_order_relaxed);
+        indices[i + k] = 0;
+      }
+      else
+      {
+        indices[i + k] = index;
+      }
+    }
+  }
+
+  if (!primitive.hasNormals) generateNormals(vertices, vertexCount, indices, primitive.indexCount);
+  for (size_t i = 0; i < primitive.indexCount; i++) indices[i] += (GLuint)primitive.firstVertex;
+}
+
+bool kdr::Import::loadGltf(const char* path, kdr::Import::Model& model)
+{
+  KDR_PROFILE_SCOPE("Import::loadGltf");
+
+  model = kdr::Import::Model();
+  kdr::File::MappedFile file;
+  if (!file.open(path))
+  {
+    std::cerr << "Failed to import the glTF file: " << path << "!\n";
+    return false;
+  }
+
+  // Binary glTF is a 12 byte header followed by a JSON chunk and an optional binary chunk
+  const unsigned char* data = file.getData();
+  const char* json = (const char*)data;
+  size_t jsonSize = file.getSize();
+  GltfBuffer binaryChunk;
+  if (file.getSize() >= 12 && memcmp(data, "glTF", 4) == 0)
+  {
+    uint32_t header[3];
+    memcpy(header, data, sizeof(header));
+    size_t offset {12};
+    json = NULL;
+    while (header[1] == 2 && offset + 8 <= file.getSize())
+    {
+      uint32_t chunk[2];
+      memcpy(chunk, data + offset, sizeof(chunk));
+      if (chunk[0] > file.getSize() - offset - 8) break;
+
+      if (chunk[1] == 0x4E4F534A && json == NULL)
+      {
+        json = (const char*)data + offset + 8;
+        jsonSize = chunk[0];
+      }
+      else if (chunk[1] == 0x004E4942 && binaryChunk.data == NULL)
+      {
+        binaryChunk.data = data + offset + 8;
+        binaryChunk.size = chunk[0];
+      }
+      offset += 8 + ((chunk[0] + 3) & ~3u);
+    }
+    if (json == NULL)
+    {
+      std::cerr << "Failed to import the glTF file: " << path << " is not a valid version 2 .glb!\n";
+      return false;
+    }
+  }
+
+  JsonValue root;
+  JsonParser parser(json, json + jsonSize);
+  if (!parser.parse(root) || root.type != JsonValue::Object)
+  {
+    std::cerr << "Failed to import the glTF file: " << path << " has malformed JSON!\n";
+    return false;
+  }
+
+  // Buffers are used in place where possible: the .glb binary chunk and external files are mapped
+  const std::string pathString = path;
+  const size_t slash = pathString.find_last_of("/\\");
+  const std::string directory = slash != std::string::npos ? pathString.substr(0, slash + 1) : "";
+  std::vector<GltfBuffer> buffers;
+  std::vector<std::unique_ptr<kdr::File::MappedFile>> bufferFiles;
+  std::vector<std::vector<unsigned char>> decodedBuffers;
+  const JsonValue* bufferList = root.find("buffers");
+  for (size_t i = 0; bufferList != NULL && i < bufferList->items.size(); i++)
+  {
+    const JsonValue& description = bufferList->items[i];
+    const JsonValue* uri = description.find("uri");
+    GltfBuffer buffer;
+    if (uri == NULL)
+    {
+      if (i == 0) buffer = binaryChunk;
+    }
+    else if (uri->string.compare(0, 5, "data:") == 0)
+    {
+      const size_t comma = uri->string.find(',');
+      decodedBuffers.emplace_back();
+      if (comma != std::string::npos && decodeBase64(uri->string.c_str() + comma + 1, uri->string.c_str() + uri->string.size(), decodedBuffers.back()))
+      {
+        buffer.data = decodedBuffers.back().data();
+        buffer.size = decodedBuffers.back().size();
+      }
+    }
+    else
+    {
+      bufferFiles.emplace_back(new kdr::File::MappedFile((directory + uri->string).c_str()));
+      buffer.data = bufferFiles.back()->getData();
+      buffer.size = bufferFiles.back()->getSize();
+    }
+
+    size_t byteLength {0};
+    if (buffer.data == NULL || !description.getIndex("byteLength", 0, byteLength) || buffer.size < byteLength)
+    {
+      std::cerr << "Failed to import the glTF file: buffer " << i << " of " << path << " is missing or too short!\n";
+      return false;
+    }
+    buffer.size = byteLength;
+    buffers.push_back(buffer);
+  }
+
+  // Files without a scene still get every mesh imported once, untransformed
+  std::vector<std::pair<size_t, kdr::Space::Mat4>> instances;
+  const JsonValue* scenes = root.find("scenes");
+  size_t sceneIndex {0};
+  const JsonValue* scene = scenes != NULL && root.getIndex("scene", 0, sceneIndex) ? scenes->at(sceneIndex) : NULL;
+  const JsonValue* sceneNodes = scene != NULL ? scene->find("nodes") : NULL;
+  const JsonValue* meshes = root.find("meshes");
+  if (sceneNodes != NULL)
+  {
+    const JsonValue* nodes = root.find("nodes");
+    std::vector<bool> isVisited(nodes != NULL ? nodes->items.size() : 0, false);
+    for (const JsonValue& node : sceneNodes->items)
+    {
+      size_t nodeIndex {0};
+      if (node.getIndex(nodeIndex) && !collectGltfNodes(root, nodeIndex, kdr::Space::Mat4(1.f), 0, isVisited, instances))
+      {
+        std::cerr << "Failed to import the glTF file: " << path << " has a node reached more than once!\n";
+        return false;
+      }
+    }
+  }
+  else if (meshes != NULL)
+  {
+    for (size_t i = 0; i < meshes->items.size(); i++) instances.push_back(std::make_pair(i, kdr::Space::Mat4(1.f)));
+  }
+
+  std::vector<GltfPrimitive> primitives;
+  size_t vertexTotal {0}, indexTotal {0};
+  for (const std::pair<size_t, kdr::Space::Mat4>& instance : instances)
+  {
+    const JsonValue* mesh = meshes != NULL ? meshes->at(instance.first) : NULL;
+    const JsonValue* meshPrimitives = mesh != NULL ? mesh->find("primitives") : NULL;
+    if (meshPrimitives == NULL) continue;
+
+    const JsonValue* meshName = mesh->find("name");
+    for (const JsonValue& description : meshPrimitives->items)
+    {
+      // Points and lines have no place in a triangle mesh; strips and fans are rare enough to skip
+      if ((int)description.getNumber("mode", 4.) != 4) continue;
+
+      const JsonValue* attributes = description.find("attributes");
+      if (attributes == NULL) continue;
+
+      GltfPrimitive primitive;
+      primitive.name = meshName != NULL ? meshName->string : "";
+      primitive.matrix = instance.second;
+      primitive.hasNormals = attributes->find("NORMAL") != NULL;
+      primitive.hasIndices = description.find("indices") != NULL;
+      const bool isValid =
+        getGltfAccessor(root, buffers, attributes->find("POSITION"), 3, primitive.positions) &&
+        (!primitive.hasNormals || getGltfAccessor(root, buffers, attributes->find("NORMAL"), 3, primitive.normals)) &&
+        (attributes->find("TEXCOORD_0") == NULL || getGltfAccessor(root, buffers, attributes->find("TEXCOORD_0"), 2, primitive.uvs)) &&
+        (!primitive.hasIndices || getGltfAccessor(root, buffers, description.find("indices"), 1, primitive.indices));
+      if (!isValid || (primitive.hasIndices && !isGltfIndexType(primitive.indices.componentType)))
+      {
+        std::cerr << "Failed to import the glTF file: " << path << " has an invalid or unsupported accessor!\n";
+        return false;
+      }
+      if (primitive.hasNormals && primitive.normals.count < primitive.positions.count) primitive.hasNormals = false;
+      if (primitive.uvs.count < primitive.positions.count) primitive.uvs.data = NULL;
+
+      primitive.indexCount = (primitive.hasIndices ? primitive.indices.count : primitive.positions.count) / 3 * 3;
+      if (primitive.indexCount == 0) continue;
+
+      primitive.firstVertex = vertexTotal;
+      primitive.firstIndex = indexTotal;
+      vertexTotal += primitive.positions.count;
+      indexTotal += primitive.indexCount;
+      primitives.push_back(primitive);
+    }
+  }
+  if (indexTotal == 0 || vertexTotal > 0xFFFFFFFFull || indexTotal > 0xFFFFFFFFull)
+  {
+    std::cerr << "Failed to import the glTF file: " << path << " has no triangles or too many!\n";
+    return false;
+  }
+
+  model.vertices.resize(vertexTotal);
+  model.indices.resize(indexTotal);
+  std::atomic<bool> isValid {true};
+  kdr::Jobs::parallelFor(0, primitives.size(), 1, [&](size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++) convertGltfPrimitive(primitives[i], model, isValid);
+  });
+  if (!isValid.load())
+  {
+    std::cerr << "Failed to import the glTF file: " << path << " has an out of range index!\n";
+    model = kdr::Import::Model();
+    return false;
+  }
+
+  for (const GltfPrimitive& primitive : primitives)
+  {
+    kdr::Import::Submesh submesh;
+    submesh.name = primitive.name;
+    submesh.firstIndex = (GLuint)primitive.firstIndex;
+    submesh.indexCount = (GLuint)primitive.indexCount;
+    model.submeshes.push_back(submesh);
+  }
+  model.bounds = computeBounds(model.vertices);
+  return true;
+}
+
+bool kdr::Import::loadModel(const char* path, kdr::Import::Model& model)
+{
+  std::string extension = path;
+  const size_t dot = extension.find_last_of('.');
+  extension = dot != std::string::npos ? extension.substr(dot + 1) : "";
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+
+  if (extension == "obj") return kdr::Import::loadObj(path, model);
+  if (extension == "gltf" || extension == "glb") return kdr::Import::loadGltf(path, model);
+
+  std::cerr << "Failed to import the model: " << path << " is not an .obj, .gltf or .glb file!\n";
+  return false;
+}
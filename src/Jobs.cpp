@@ -0,0 +1,331 @@
+#include "Kedarium/Jobs.hpp"
+
+// Identifies the pool a worker thread belongs to and its index in it
+static thread_local const kdr::Jobs::Scheduler* currentScheduler {NULL};
+static thread_local int                         currentWorkerIndex {-1};
+
+kdr::Jobs::Scheduler& kdr::Jobs::getScheduler()
+{
+  static kdr::Jobs::Scheduler scheduler;
+  return scheduler;
+}
+
+kdr::Jobs::Scheduler::Scheduler(const unsigned int threadCount)
+: statsEpoch(std::chrono::steady_clock::now())
+{
+  setThreadCount(threadCount);
+}
+
+kdr::Jobs::Scheduler::~Scheduler()
+{
+  _stop();
+}
+
+void kdr::Jobs::Scheduler::setThreadCount(const unsigned int threadCount)
+{
+  _stop();
+
+  this->threadCount = threadCount;
+  if (this->threadCount == 0)
+  {
+    const unsigned int hardwareCount = std::thread::hardware_concurrency();
+    this->threadCount = hardwareCount > 1 ? hardwareCount - 1 : 1;
+  }
+  resetStats();
+}
+
+void kdr::Jobs::Scheduler::run(
+  const std::function<void()>& function,
+  kdr::Jobs::Counter* counter,
+  kdr::Jobs::Counter* dependency
+)
+{
+  _start();
+
+  kdr::Jobs::Job job;
+  job.function = function;
+  job.counter = counter;
+  if (counter != NULL)
+  {
+    counter->value.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  if (dependency != NULL && !dependency->getIsDone())
+  {
+    // Checked again under the lock, since the dependency may have finished in between
+    std::lock_guard<std::mutex> lock(dependency->mutex);
+    if (!dependency->getIsDone())
+    {
+      dependency->waiting.push_back(std::move(job));
+      return;
+    }
+  }
+  _push(std::move(job));
+}
+
+void kdr::Jobs::Scheduler::wait(kdr::Jobs::Counter& counter)
+{
+  const int workerIndex = _getWorkerIndex();
+  while (!counter.getIsDone())
+  {
+    kdr::Jobs::Job job;
+    if (_tryPop(job, workerIndex))
+    {
+      _execute(job, workerIndex);
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  // The last job may still hold the lock it decremented the counter under
+  std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void kdr::Jobs::Scheduler::parallelFor(
+  const size_t begin,
+  const size_t end,
+  const size_t grainSize,
+  const std::function<void(size_t, size_t)>& function
+)
+{
+  if (end <= begin) return;
+
+  const size_t grain = grainSize > 0 ? grainSize : 1;
+  const size_t count = end - begin;
+
+  // More chunks than threads lets stealing even out uneven chunks
+  size_t chunkCount = (count + grain - 1) / grain;
+  const size_t maxChunkCount = (size_t)(threadCount + 1) * 4;
+  if (chunkCount > maxChunkCount) chunkCount = maxChunkCount;
+
+  if (chunkCount <= 1)
+  {
+    function(begin, end);
+    return;
+  }
+
+  const size_t chunk = (count + chunkCount - 1) / chunkCount;
+  kdr::Jobs::Counter counter;
+  for (size_t chunkBegin = begin + chunk; chunkBegin < end; chunkBegin += chunk)
+  {
+    const size_t chunkEnd = chunkBegin + chunk < end ? chunkBegin + chunk : end;
+    run([&function, chunkBegin, chunkEnd]() { function(chunkBegin, chunkEnd); }, &counter);
+  }
+  function(begin, begin + chunk);
+  wait(counter);
+}
+
+std::vector<kdr::Jobs::WorkerStats> kdr::Jobs::Scheduler::getWorkerStats() const
+{
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsEpoch).count();
+
+  std::vector<kdr::Jobs::WorkerStats> stats;
+  stats.reserve(workers.size() + 1);
+
+  const auto collect = [&stats, elapsed](const Worker& worker)
+  {
+    kdr::Jobs::WorkerStats entry;
+    entry.executedCount = worker.executedCount.load();
+    entry.stolenCount   = worker.stolenCount.load();
+    entry.busySeconds   = worker.busyNanoseconds.load() * 1e-9;
+    entry.utilization   = elapsed > 0. ? entry.busySeconds / elapsed : 0.;
+    stats.push_back(entry);
+  };
+  for (const std::unique_ptr<Worker>& worker : workers)
+  {
+    collect(*worker);
+  }
+  collect(external);
+  return stats;
+}
+
+void kdr::Jobs::Scheduler::resetStats()
+{
+  for (std::unique_ptr<Worker>& worker : workers)
+  {
+    worker->executedCount = 0;
+    worker->stolenCount = 0;
+    worker->busyNanoseconds = 0;
+  }
+  external.executedCount = 0;
+  external.stolenCount = 0;
+  external.busyNanoseconds = 0;
+  statsEpoch = std::chrono::steady_clock::now();
+}
+
+void kdr::Jobs::Scheduler::_start()
+{
+  if (isStarted.load(std::memory_order_acquire)) return;
+
+  std::lock_guard<std::mutex> lock(startMutex);
+  if (isStarted.load(std::memory_order_relaxed)) return;
+
+  isStopping = false;
+  std::vector<std::unique_ptr<Worker>> pool;
+  for (unsigned int i = 0; i < threadCount; i++)
+  {
+    pool.emplace_back(new Worker());
+  }
+  workers.swap(pool);
+  for (unsigned int i = 0; i < threadCount; i++)
+  {
+    workers[i]->thread = std::thread(&kdr::Jobs::Scheduler::_workerLoop, this, (int)i);
+  }
+  isStarted.store(true, std::memory_order_release);
+}
+
+void kdr::Jobs::Scheduler::_stop()
+{
+  if (!isStarted.load(std::memory_order_acquire)) return;
+
+  // Draining the queues first, so no counter is left waiting forever
+  while (queuedCount.load() > 0)
+  {
+    kdr::Jobs::Job job;
+    if (_tryPop(job, -1)) _execute(job, -1);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    isStopping = true;
+  }
+  sleepCondition.notify_all();
+
+  for (std::unique_ptr<Worker>& worker : workers)
+  {
+    worker->thread.join();
+  }
+  workers.clear();
+  isStarted = false;
+}
+
+void kdr::Jobs::Scheduler::_push(kdr::Jobs::Job&& job)
+{
+  const int workerIndex = _getWorkerIndex();
+  if (workerIndex >= 0)
+  {
+    Worker& worker = *workers[workerIndex];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(std::move(job));
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(injectedMutex);
+    injected.push_back(std::move(job));
+  }
+  queuedCount.fetch_add(1);
+
+  // Taking the lock orders this wake-up after a worker's emptiness check
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+  }
+  sleepCondition.notify_one();
+}
+
+bool kdr::Jobs::Scheduler::_tryPop(kdr::Jobs::Job& job, const int workerIndex)
+{
+  if (workerIndex >= 0)
+  {
+    Worker& worker = *workers[workerIndex];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.jobs.empty())
+    {
+      job = std::move(worker.jobs.back());
+      worker.jobs.pop_back();
+      queuedCount.fetch_sub(1);
+      return true;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(injectedMutex);
+    if (!injected.empty())
+    {
+      job = std::move(injected.front());
+      injected.pop_front();
+      queuedCount.fetch_sub(1);
+      return true;
+    }
+  }
+
+  const size_t workerCount = workers.size();
+  for (size_t offset = 1; offset <= workerCount; offset++)
+  {
+    const size_t victimIndex = (workerIndex + offset) % workerCount;
+    if ((int)victimIndex == workerIndex) continue;
+
+    Worker& victim = *workers[victimIndex];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty())
+    {
+      job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      queuedCount.fetch_sub(1);
+
+      Worker& thief = workerIndex >= 0 ? *workers[workerIndex] : external;
+      thief.stolenCount++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void kdr::Jobs::Scheduler::_execute(kdr::Jobs::Job& job, const int workerIndex)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  job.function();
+  const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  Worker& worker = workerIndex >= 0 ? *workers[workerIndex] : external;
+  worker.executedCount++;
+  worker.busyNanoseconds += elapsed;
+
+  kdr::Jobs::Counter* counter = job.counter;
+  if (counter == NULL) return;
+
+  // Decrementing under the lock, so a waiter can't destroy the counter while it is still in use
+  std::vector<kdr::Jobs::Job> released;
+  {
+    std::lock_guard<std::mutex> lock(counter->mutex);
+    if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      released.swap(counter->waiting);
+    }
+  }
+
+  // Releasing the jobs that depended on this group
+  for (kdr::Jobs::Job& waiting : released)
+  {
+    _push(std::move(waiting));
+  }
+}
+
+void kdr::Jobs::Scheduler::_workerLoop(const int workerIndex)
+{
+  currentScheduler = this;
+  currentWorkerIndex = workerIndex;
+
+  while (true)
+  {
+    kdr::Jobs::Job job;
+    if (_tryPop(job, workerIndex))
+    {
+      _execute(job, workerIndex);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    if (isStopping) break;
+    sleepCondition.wait(lock, [this]() { return queuedCount.load() > 0 || isStopping; });
+  }
+
+  currentScheduler = NULL;
+  currentWorkerIndex = -1;
+}
+
+int kdr::Jobs::Scheduler::_getWorkerIndex() const
+{
+  return currentScheduler == this ? currentWorkerIndex : -1;
+}
@@ -0,0 +1,103 @@
+#include "Kedarium/LOD.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+#include "Kedarium/Mesh.hpp"
+
+kdr::Mesh::LODMesh::LODMesh(
+  kdr::Graphics::MeshPool& pool,
+  const void* vertices,
+  const GLuint vertexCount,
+  const GLuint* indices,
+  const GLuint indexCount,
+  const unsigned int maxLevels,
+  const float reduction
+) : pool(&pool)
+{
+  kdr::Mesh::LODLevel full;
+  full.handle = pool.Add(vertices, vertexCount, indices, indexCount);
+  full.indexCount = (GLsizei)indexCount;
+  levels.push_back(full);
+
+  if (maxLevels <= 1) return;
+
+  const std::vector<kdr::Mesh::MeshLevel> meshLevels = kdr::Mesh::buildLevels(
+    vertices,
+    vertexCount,
+    (size_t)pool.getVertexStride(),
+    indices,
+    indexCount,
+    maxLevels - 1,
+    reduction
+  );
+  for (const kdr::Mesh::MeshLevel& meshLevel : meshLevels)
+  {
+    kdr::Mesh::LODLevel level;
+    level.handle = pool.Add(meshLevel.vertices.data(), meshLevel.vertexCount, meshLevel.indices.data(), (GLuint)meshLevel.indices.size());
+    level.indexCount = (GLsizei)meshLevel.indices.size();
+    level.error = meshLevel.error;
+    levels.push_back(level);
+  }
+}
+
+kdr::Mesh::LODMesh::LODMesh(kdr::Graphics::MeshPool& pool, const kdr::Mesh::CookedMesh& mesh)
+: pool(&pool)
+{
+  for (unsigned int i = 0; i < mesh.getLevelCount(); i++)
+  {
+    kdr::Mesh::LODLevel level;
+    level.handle = mesh.Upload(pool, i);
+    level.indexCount = (GLsizei)mesh.getLevel(i).indexCount;
+    level.error = mesh.getLevel(i).error;
+    if (level.handle == kdr::Graphics::invalidMesh) break;
+
+    levels.push_back(level);
+  }
+}
+
+void kdr::Mesh::LODMesh::Remove()
+{
+  for (const kdr::Mesh::LODLevel& level : levels)
+  {
+    pool->Remove(level.handle);
+  }
+  levels.clear();
+}
+
+void kdr::Mesh::LODSelector::update(const kdr::Camera& camera, const unsigned int viewportHeight)
+{
+  cameraPosition = camera.getPosition();
+  projectionScale = viewportHeight / (2.f * tanf(kdr::Space::radians(camera.getFov()) * 0.5f));
+}
+
+const float kdr::Mesh::LODSelector::getScreenError(const float error, const kdr::Space::Vec3& center) const
+{
+  const kdr::Space::Vec3 offset = center - cameraPosition;
+  const float distance = sqrtf(kdr::Space::dot(offset, offset));
+
+  // Anything at the camera needs the full mesh
+  if (distance <= 1e-4f) return INFINITY;
+  return error * projectionScale / distance;
+}
+
+unsigned int kdr::Mesh::LODSelector::select(const kdr::Mesh::LODMesh& mesh, const kdr::Space::Vec3& center, const float scale, unsigned int& level) const
+{
+  const unsigned int levelCount = mesh.getLevelCount();
+  if (levelCount == 0) return level = 0;
+
+  unsigned int next = level < levelCount ? level : levelCount - 1;
+
+  // Refining as soon as the current level shows, coarsening only once the next level is well hidden
+  while (next > 0 && getScreenError(mesh.getLevel(next).error * scale, center) > errorThreshold)
+  {
+    next--;
+  }
+  while (next + 1 < levelCount && getScreenError(mesh.getLevel(next + 1).error * scale, center) <= errorThreshold * (1.f - hysteresis))
+  {
+    next++;
+  }
+
+  level = next;
+  return next;
+}
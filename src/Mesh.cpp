@@ -0,0 +1,356 @@
+#include "Kedarium/Mesh.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+
+// Symmetric 4x4 error quadric of a set of weighted planes, stored as its upper triangle
+struct Quadric
+{
+  double a00 {0.}, a01 {0.}, a02 {0.}, a03 {0.};
+  double a11 {0.}, a12 {0.}, a13 {0.};
+  double a22 {0.}, a23 {0.};
+  double a33 {0.};
+  double w   {0.};
+
+  void addPlane(const double x, const double y, const double z, const double d, const double weight)
+  {
+    a00 += weight * x * x; a01 += weight * x * y; a02 += weight * x * z; a03 += weight * x * d;
+    a11 += weight * y * y; a12 += weight * y * z; a13 += weight * y * d;
+    a22 += weight * z * z; a23 += weight * z * d;
+    a33 += weight * d * d;
+    w   += weight;
+  }
+
+  void add(const Quadric& other)
+  {
+    a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+    a11 += other.a11; a12 += other.a12; a13 += other.a13;
+    a22 += other.a22; a23 += other.a23;
+    a33 += other.a33;
+    w   += other.w;
+  }
+
+  // Weighted mean of the squared distances of a point to the planes
+  double evaluate(const float* p) const
+  {
+    if (w <= 0.) return 0.;
+
+    const double x = p[0];
+    const double y = p[1];
+    const double z = p[2];
+    const double sum =
+      a00 * x * x + 2. * a01 * x * y + 2. * a02 * x * z + 2. * a03 * x +
+      a11 * y * y + 2. * a12 * y * z + 2. * a13 * y +
+      a22 * z * z + 2. * a23 * z +
+      a33;
+    return fabs(sum) / w;
+  }
+};
+
+struct Collapse
+{
+  GLuint from;
+  GLuint to;
+  double cost;
+};
+
+static const float* getPosition(const unsigned char* vertices, const size_t vertexStride, const GLuint vertex)
+{
+  return (const float*)(vertices + vertex * vertexStride);
+}
+
+static void getNormal(const float* a, const float* b, const float* c, double* normal)
+{
+  const double ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+  const double vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+  normal[0] = uy * vz - uz * vy;
+  normal[1] = uz * vx - ux * vz;
+  normal[2] = ux * vy - uy * vx;
+}
+
+std::vector<GLuint> kdr::Mesh::simplify(
+  const void* vertices,
+  const size_t vertexCount,
+  const size_t vertexStride,
+  const GLuint* indices,
+  const size_t indexCount,
+  const size_t targetIndexCount,
+  float* error
+)
+{
+  const unsigned char* data = (const unsigned char*)vertices;
+  std::vector<GLuint> result(indices, indices + indexCount - indexCount % 3);
+  double maxCost {0.};
+
+  // Welding by position, so seams and borders are judged on the surface rather than the index topology
+  std::vector<GLuint> positionIDs(vertexCount);
+  std::vector<GLuint> positionUses;
+  {
+    std::unordered_map<uint64_t, std::vector<GLuint>> buckets;
+    for (GLuint vertex = 0; vertex < vertexCount; vertex++)
+    {
+      const float* p = getPosition(data, vertexStride, vertex);
+      uint32_t bits[3];
+      memcpy(bits, p, sizeof(bits));
+      const uint64_t hash = ((uint64_t)bits[0] * 73856093u) ^ ((uint64_t)bits[1] * 19349663u) ^ ((uint64_t)bits[2] * 83492791u);
+
+      std::vector<GLuint>& bucket = buckets[hash];
+      GLuint positionID = (GLuint)positionUses.size();
+      for (const GLuint other : bucket)
+      {
+        if (memcmp(getPosition(data, vertexStride, other), p, sizeof(float) * 3) == 0)
+        {
+          positionID = positionIDs[other];
+          break;
+        }
+      }
+      if (positionID == positionUses.size())
+      {
+        positionUses.push_back(0);
+        bucket.push_back(vertex);
+      }
+      positionIDs[vertex] = positionID;
+      positionUses[positionID]++;
+    }
+  }
+
+  std::vector<bool> isLocked(vertexCount, false);
+  for (GLuint vertex = 0; vertex < vertexCount; vertex++)
+  {
+    isLocked[vertex] = positionUses[positionIDs[vertex]] > 1;
+  }
+
+  // Border edges belong to a single triangle
+  {
+    std::unordered_map<uint64_t, int> edgeUses;
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      for (int e = 0; e < 3; e++)
+      {
+        const GLuint a = positionIDs[result[i + e]];
+        const GLuint b = positionIDs[result[i + (e + 1) % 3]];
+        edgeUses[((uint64_t)std::min(a, b) << 32) | std::max(a, b)]++;
+      }
+    }
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      for (int e = 0; e < 3; e++)
+      {
+        const GLuint a = positionIDs[result[i + e]];
+        const GLuint b = positionIDs[result[i + (e + 1) % 3]];
+        if (edgeUses[((uint64_t)std::min(a, b) << 32) | std::max(a, b)] == 1)
+        {
+          isLocked[result[i + e]] = true;
+          isLocked[result[i + (e + 1) % 3]] = true;
+        }
+      }
+    }
+  }
+
+  // Every vertex starts with the planes of the triangles around it, weighted by their area
+  std::vector<Quadric> quadrics(vertexCount);
+  for (size_t i = 0; i < result.size(); i += 3)
+  {
+    const float* a = getPosition(data, vertexStride, result[i]);
+    const float* b = getPosition(data, vertexStride, result[i + 1]);
+    const float* c = getPosition(data, vertexStride, result[i + 2]);
+
+    double normal[3];
+    getNormal(a, b, c, normal);
+    const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (length <= 0.) continue;
+
+    normal[0] /= length;
+    normal[1] /= length;
+    normal[2] /= length;
+    const double d = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+    for (int k = 0; k < 3; k++)
+    {
+      quadrics[result[i + k]].addPlane(normal[0], normal[1], normal[2], d, length * 0.5);
+    }
+  }
+
+  std::vector<GLuint> remap(vertexCount);
+  std::vector<bool> isTouched(vertexCount);
+  std::vector<size_t> triangleOffsets(vertexCount + 1);
+  std::vector<GLuint> triangleList;
+  std::vector<Collapse> collapses;
+
+  // Each pass collapses the cheapest edges it can without two collapses touching the same vertex
+  while (result.size() > targetIndexCount)
+  {
+    std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+    for (const GLuint vertex : result) triangleOffsets[vertex + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) triangleOffsets[v + 1] += triangleOffsets[v];
+    triangleList.resize(result.size());
+    {
+      std::vector<size_t> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+      for (size_t i = 0; i < result.size(); i++)
+      {
+        triangleList[cursor[result[i]]++] = (GLuint)(i / 3);
+      }
+    }
+
+    collapses.clear();
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      for (int e = 0; e < 3; e++)
+      {
+        const GLuint from = result[i + e];
+        const GLuint to = result[i + (e + 1) % 3];
+        if (isLocked[from]) continue;
+
+        Quadric quadric = quadrics[from];
+        quadric.add(quadrics[to]);
+        collapses.push_back({from, to, quadric.evaluate(getPosition(data, vertexStride, to))});
+      }
+    }
+    if (collapses.empty()) break;
+
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+    {
+      return a.cost < b.cost;
+    });
+
+    for (GLuint v = 0; v < vertexCount; v++) remap[v] = v;
+    std::fill(isTouched.begin(), isTouched.end(), false);
+
+    // A collapse removes the triangles sharing its edge, usually two
+    const size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+    size_t removed {0};
+    for (const Collapse& collapse : collapses)
+    {
+      if (removed >= trianglesToRemove) break;
+      if (isTouched[collapse.from] || isTouched[collapse.to]) continue;
+
+      // Rejecting collapses that would fold a triangle over
+      const float* target = getPosition(data, vertexStride, collapse.to);
+      bool isFlipped = false;
+      size_t sharedCount = 0;
+      for (size_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !isFlipped; t++)
+      {
+        const GLuint* triangle = &result[triangleList[t] * 3];
+        if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+        {
+          sharedCount++;
+          continue;
+        }
+
+        const float* before[3];
+        const float* after[3];
+        for (int k = 0; k < 3; k++)
+        {
+          before[k] = getPosition(data, vertexStride, triangle[k]);
+          after[k] = triangle[k] == collapse.from ? target : before[k];
+        }
+
+        double n0[3];
+        double n1[3];
+        getNormal(before[0], before[1], before[2], n0);
+        getNormal(after[0], after[1], after[2], n1);
+        const double dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+        const double lengths = sqrt((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+        isFlipped = dot <= 0.25 * lengths;
+      }
+      if (isFlipped) continue;
+
+      // Keeping the neighbours fixed for the rest of the pass, since their fans change
+      for (size_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++)
+      {
+        const GLuint* triangle = &result[triangleList[t] * 3];
+        isTouched[triangle[0]] = true;
+        isTouched[triangle[1]] = true;
+        isTouched[triangle[2]] = true;
+      }
+
+      remap[collapse.from] = collapse.to;
+      quadrics[collapse.to].add(quadrics[collapse.from]);
+      maxCost = std::max(maxCost, collapse.cost);
+      removed += sharedCount;
+    }
+    if (removed == 0) break;
+
+    size_t write {0};
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+      const GLuint a = remap[result[i]];
+      const GLuint b = remap[result[i + 1]];
+      const GLuint c = remap[result[i + 2]];
+      if (a == b || b == c || c == a) continue;
+
+      result[write++] = a;
+      result[write++] = b;
+      result[write++] = c;
+    }
+    result.resize(write);
+  }
+
+  if (error != NULL)
+  {
+    *error = (float)sqrt(maxCost);
+  }
+  return result;
+}
+
+GLuint kdr::Mesh::compactVertices(
+  const void* vertices,
+  const size_t vertexCount,
+  const size_t vertexStride,
+  std::vector<GLuint>& indices,
+  std::vector<unsigned char>& compacted
+)
+{
+  const unsigned char* data = (const unsigned char*)vertices;
+  std::vector<GLuint> remap(vertexCount, 0xFFFFFFFF);
+
+  GLuint count {0};
+  compacted.clear();
+  for (GLuint& index : indices)
+  {
+    if (remap[index] == 0xFFFFFFFF)
+    {
+      remap[index] = count++;
+      compacted.insert(compacted.end(), data + index * vertexStride, data + (index + 1) * vertexStride);
+    }
+    index = remap[index];
+  }
+  return count;
+}
+
+std::vector<kdr::Mesh::MeshLevel> kdr::Mesh::buildLevels(
+  const void* vertices,
+  const size_t vertexCount,
+  const size_t vertexStride,
+  const GLuint* indices,
+  const size_t indexCount,
+  const unsigned int levelCount,
+  const float reduction
+)
+{
+  std::vector<kdr::Mesh::MeshLevel> levels;
+  size_t previousCount = indexCount;
+  float previousError {0.f};
+  while (levels.size() < levelCount)
+  {
+    const size_t targetCount = (size_t)(previousCount * reduction) / 3 * 3;
+    if (targetCount < 3) break;
+
+    // Simplifying the full mesh every time keeps the error measured against the original surface
+    kdr::Mesh::MeshLevel level;
+    level.indices = kdr::Mesh::simplify(vertices, vertexCount, vertexStride, indices, indexCount, targetCount, &level.error);
+
+    // Locked borders and seams can stall the reduction; such levels would not be worth their memory
+    if (level.indices.empty() || level.indices.size() > previousCount * 0.9f) break;
+
+    // Each level gets only the vertices it uses, which also keeps them close together in memory
+    level.vertexCount = kdr::Mesh::compactVertices(vertices, vertexCount, vertexStride, level.indices, level.vertices);
+    level.error = std::max(level.error, previousError);
+
+    previousCount = level.indices.size();
+    previousError = level.error;
+    levels.push_back(std::move(level));
+  }
+  return levels;
+}
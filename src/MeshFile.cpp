@@ -0,0 +1,227 @@
+#include "Kedarium/MeshFile.hpp"
+
+#include <iostream>
+#include <string.h>
+
+#include "Kedarium/Mesh.hpp"
+
+// Checks that a section lies inside the file and starts on the section alignment
+static bool isSectionValid(const uint64_t offset, const uint64_t size, const size_t fileSize)
+{
+  return offset % kdr::Mesh::cookedAlignment == 0 && offset <= fileSize && size <= fileSize - offset;
+}
+
+// Checks that every index of a level refers to one of the level's own vertices
+static bool areIndicesValid(const GLuint* indices, const uint32_t indexCount, const uint32_t vertexCount)
+{
+  for (uint32_t i = 0; i < indexCount; i++)
+  {
+    if (indices[i] >= vertexCount) return false;
+  }
+  return true;
+}
+
+// Rounds an offset up to the next section boundary
+static uint64_t alignSection(const uint64_t offset)
+{
+  return (offset + kdr::Mesh::cookedAlignment - 1) / kdr::Mesh::cookedAlignment * kdr::Mesh::cookedAlignment;
+}
+
+const kdr::Space::AABB kdr::Mesh::CookedMesh::getBounds() const
+{
+  kdr::Space::AABB bounds;
+  bounds.min = kdr::Space::Vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]);
+  bounds.max = kdr::Space::Vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]);
+  return bounds;
+}
+
+const std::vector<kdr::Graphics::VertexAttribute> kdr::Mesh::CookedMesh::getAttributes() const
+{
+  std::vector<kdr::Graphics::VertexAttribute> result;
+  for (uint32_t i = 0; i < header->attributeCount; i++)
+  {
+    result.push_back(kdr::Graphics::VertexAttribute(attributes[i].layout, attributes[i].size, attributes[i].type, attributes[i].offset));
+  }
+  return result;
+}
+
+bool kdr::Mesh::CookedMesh::open(const char* path)
+{
+  close();
+  if (!file.open(path)) return false;
+
+  const unsigned char* data = file.getData();
+  const size_t size = file.getSize();
+  const kdr::Mesh::CookedHeader* fileHeader = (const kdr::Mesh::CookedHeader*)data;
+  if (size < sizeof(kdr::Mesh::CookedHeader) || memcmp(fileHeader->magic, kdr::Mesh::cookedMagic, sizeof(kdr::Mesh::cookedMagic)) != 0)
+  {
+    std::cerr << "Failed to open cooked mesh: " << path << " is not a cooked mesh!\n";
+    file.close();
+    return false;
+  }
+  if (fileHeader->version != kdr::Mesh::cookedVersion)
+  {
+    std::cerr << "Failed to open cooked mesh: " << path << " has version " << fileHeader->version << ", expected " << kdr::Mesh::cookedVersion << "!\n";
+    file.close();
+    return false;
+  }
+
+  // Every offset, count and index is checked up front, so the getters and draws can use the mapping unchecked
+  const uint64_t stride = fileHeader->vertexStride;
+  const bool isValid =
+    stride >= 3 * sizeof(float) &&
+    fileHeader->levelCount > 0 &&
+    isSectionValid(fileHeader->attributesOffset, (uint64_t)fileHeader->attributeCount * sizeof(kdr::Mesh::CookedAttribute), size) &&
+    isSectionValid(fileHeader->levelsOffset, (uint64_t)fileHeader->levelCount * sizeof(kdr::Mesh::CookedLevel), size) &&
+    isSectionValid(fileHeader->verticesOffset, fileHeader->verticesSize, size) &&
+    isSectionValid(fileHeader->indicesOffset, fileHeader->indicesSize, size) &&
+    fileHeader->verticesSize % stride == 0 &&
+    fileHeader->indicesSize % sizeof(GLuint) == 0;
+  if (!isValid)
+  {
+    std::cerr << "Failed to open cooked mesh: " << path << " is truncated or corrupt!\n";
+    file.close();
+    return false;
+  }
+
+  const kdr::Mesh::CookedLevel* fileLevels = (const kdr::Mesh::CookedLevel*)(data + fileHeader->levelsOffset);
+  const uint64_t totalVertexCount = fileHeader->verticesSize / stride;
+  const uint64_t totalIndexCount = fileHeader->indicesSize / sizeof(GLuint);
+  for (uint32_t i = 0; i < fileHeader->levelCount; i++)
+  {
+    const kdr::Mesh::CookedLevel& level = fileLevels[i];
+    if ((uint64_t)level.firstVertex + level.vertexCount > totalVertexCount || (uint64_t)level.firstIndex + level.indexCount > totalIndexCount)
+    {
+      std::cerr << "Failed to open cooked mesh: level " << i << " of " << path << " is out of bounds!\n";
+      file.close();
+      return false;
+    }
+
+    const GLuint* levelIndices = (const GLuint*)(data + fileHeader->indicesOffset) + level.firstIndex;
+    if (!areIndicesValid(levelIndices, level.indexCount, level.vertexCount))
+    {
+      std::cerr << "Failed to open cooked mesh: level " << i << " of " << path << " indexes past its vertices!\n";
+      file.close();
+      return false;
+    }
+  }
+
+  header = fileHeader;
+  attributes = (const kdr::Mesh::CookedAttribute*)(data + fileHeader->attributesOffset);
+  levels = fileLevels;
+  vertices = data + fileHeader->verticesOffset;
+  indices = (const GLuint*)(data + fileHeader->indicesOffset);
+  return true;
+}
+
+void kdr::Mesh::CookedMesh::close()
+{
+  file.close();
+  header = NULL;
+  attributes = NULL;
+  levels = NULL;
+  vertices = NULL;
+  indices = NULL;
+}
+
+kdr::Graphics::MeshHandle kdr::Mesh::CookedMesh::Upload(kdr::Graphics::MeshPool& pool, const unsigned int level) const
+{
+  if (!getIsOpen() || level >= header->levelCount) return kdr::Graphics::invalidMesh;
+  if (pool.getVertexStride() != (GLsizeiptr)header->vertexStride)
+  {
+    std::cerr << "Failed to upload cooked mesh: the mesh pool has a different vertex stride!\n";
+    return kdr::Graphics::invalidMesh;
+  }
+  return pool.Add(getVertices(level), levels[level].vertexCount, getIndices(level), levels[level].indexCount);
+}
+
+bool kdr::Mesh::writeCookedMesh(
+  const char* path,
+  const void* vertices,
+  const GLuint vertexCount,
+  const GLsizeiptr vertexStride,
+  const std::vector<kdr::Graphics::VertexAttribute>& attributes,
+  const GLuint* indices,
+  const GLuint indexCount,
+  const unsigned int maxLevels,
+  const float reduction
+)
+{
+  const std::vector<kdr::Mesh::MeshLevel> meshLevels = maxLevels > 1
+    ? kdr::Mesh::buildLevels(vertices, vertexCount, (size_t)vertexStride, indices, indexCount, maxLevels - 1, reduction)
+    : std::vector<kdr::Mesh::MeshLevel>();
+
+  kdr::Mesh::CookedHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kdr::Mesh::cookedMagic, sizeof(header.magic));
+  header.version = kdr::Mesh::cookedVersion;
+  header.vertexStride = (uint32_t)vertexStride;
+  header.attributeCount = (uint32_t)attributes.size();
+  header.levelCount = (uint32_t)meshLevels.size() + 1;
+
+  // Level 0 is the full mesh, followed by the simplified levels in order
+  std::vector<kdr::Mesh::CookedLevel> levels(header.levelCount);
+  levels[0].vertexCount = vertexCount;
+  levels[0].indexCount = indexCount;
+  for (size_t i = 0; i < meshLevels.size(); i++)
+  {
+    kdr::Mesh::CookedLevel& level = levels[i + 1];
+    level.firstVertex = levels[i].firstVertex + levels[i].vertexCount;
+    level.vertexCount = meshLevels[i].vertexCount;
+    level.firstIndex = levels[i].firstIndex + levels[i].indexCount;
+    level.indexCount = (uint32_t)meshLevels[i].indices.size();
+    level.error = meshLevels[i].error;
+  }
+  const kdr::Mesh::CookedLevel& last = levels.back();
+
+  kdr::Space::AABB bounds;
+  for (GLuint i = 0; i < vertexCount; i++)
+  {
+    const float* position = (const float*)((const unsigned char*)vertices + i * vertexStride);
+    bounds.expand(kdr::Space::Vec3(position[0], position[1], position[2]));
+  }
+  header.boundsMin[0] = bounds.min.x;
+  header.boundsMin[1] = bounds.min.y;
+  header.boundsMin[2] = bounds.min.z;
+  header.boundsMax[0] = bounds.max.x;
+  header.boundsMax[1] = bounds.max.y;
+  header.boundsMax[2] = bounds.max.z;
+
+  header.attributesOffset = alignSection(sizeof(header));
+  header.levelsOffset = alignSection(header.attributesOffset + header.attributeCount * sizeof(kdr::Mesh::CookedAttribute));
+  header.verticesOffset = alignSection(header.levelsOffset + header.levelCount * sizeof(kdr::Mesh::CookedLevel));
+  header.verticesSize = ((uint64_t)last.firstVertex + last.vertexCount) * (uint64_t)vertexStride;
+  header.indicesOffset = alignSection(header.verticesOffset + header.verticesSize);
+  header.indicesSize = ((uint64_t)last.firstIndex + last.indexCount) * sizeof(GLuint);
+
+  std::vector<unsigned char> contents(header.indicesOffset + header.indicesSize, 0);
+  memcpy(contents.data(), &header, sizeof(header));
+  for (size_t i = 0; i < attributes.size(); i++)
+  {
+    kdr::Mesh::CookedAttribute attribute;
+    attribute.layout = attributes[i].layout;
+    attribute.size = attributes[i].size;
+    attribute.type = attributes[i].type;
+    attribute.offset = (uint32_t)attributes[i].offset;
+    memcpy(contents.data() + header.attributesOffset + i * sizeof(attribute), &attribute, sizeof(attribute));
+  }
+  memcpy(contents.data() + header.levelsOffset, levels.data(), levels.size() * sizeof(kdr::Mesh::CookedLevel));
+
+  unsigned char* vertexData = contents.data() + header.verticesOffset;
+  unsigned char* indexData = contents.data() + header.indicesOffset;
+  memcpy(vertexData, vertices, (size_t)vertexCount * vertexStride);
+  memcpy(indexData, indices, (size_t)indexCount * sizeof(GLuint));
+  for (size_t i = 0; i < meshLevels.size(); i++)
+  {
+    const kdr::Mesh::CookedLevel& level = levels[i + 1];
+    memcpy(vertexData + (size_t)level.firstVertex * vertexStride, meshLevels[i].vertices.data(), meshLevels[i].vertices.size());
+    memcpy(indexData + (size_t)level.firstIndex * sizeof(GLuint), meshLevels[i].indices.data(), meshLevels[i].indices.size() * sizeof(GLuint));
+  }
+
+  if (!kdr::File::writeContents(path, contents.data(), contents.size()))
+  {
+    std::cerr << "Failed to write cooked mesh: " << path << "!\n";
+    return false;
+  }
+  return true;
+}
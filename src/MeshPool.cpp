@@ -0,0 +1,345 @@
+#include "Kedarium/MeshPool.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+// Doubles a capacity, or grows it just enough for a large request, without wrapping around
+static bool getGrownCapacity(const GLuint capacity, const GLuint size, GLuint& grownCapacity)
+{
+  const uint64_t needed = (uint64_t)capacity + size;
+  if (needed > UINT32_MAX) return false;
+
+  const uint64_t doubled = (uint64_t)capacity * 2;
+  grownCapacity = (GLuint)std::min(std::max(doubled, needed), (uint64_t)UINT32_MAX);
+  return true;
+}
+
+bool kdr::Graphics::RangeAllocator::allocate(const GLuint size, GLuint& offset)
+{
+  if (size == 0) return false;
+
+  // Best fit: the smallest free range that is large enough
+  std::multimap<GLuint, GLuint>::iterator it = freeBySize.lower_bound(size);
+  if (it == freeBySize.end()) return false;
+
+  const GLuint rangeSize   = it->first;
+  const GLuint rangeOffset = it->second;
+  _erase(rangeOffset, rangeSize);
+
+  if (rangeSize > size)
+  {
+    _insert(rangeOffset + size, rangeSize - size);
+  }
+
+  freeSize -= size;
+  offset = rangeOffset;
+  return true;
+}
+
+void kdr::Graphics::RangeAllocator::free(const GLuint offset, const GLuint size)
+{
+  if (size == 0) return;
+
+  GLuint mergedOffset = offset;
+  GLuint mergedSize   = size;
+
+  std::map<GLuint, GLuint>::iterator next = freeByOffset.lower_bound(offset);
+  if (next != freeByOffset.begin())
+  {
+    std::map<GLuint, GLuint>::iterator previous = std::prev(next);
+    if (previous->first + previous->second == offset)
+    {
+      mergedOffset = previous->first;
+      mergedSize  += previous->second;
+      _erase(previous->first, previous->second);
+    }
+  }
+  next = freeByOffset.lower_bound(offset);
+  if (next != freeByOffset.end() && offset + size == next->first)
+  {
+    mergedSize += next->second;
+    _erase(next->first, next->second);
+  }
+
+  _insert(mergedOffset, mergedSize);
+  freeSize += size;
+}
+
+void kdr::Graphics::RangeAllocator::grow(const GLuint capacity)
+{
+  if (capacity <= this->capacity) return;
+
+  const GLuint oldCapacity = this->capacity;
+  this->capacity = capacity;
+  free(oldCapacity, capacity - oldCapacity);
+}
+
+void kdr::Graphics::RangeAllocator::reset(const GLuint capacity, const GLuint allocated)
+{
+  freeByOffset.clear();
+  freeBySize.clear();
+
+  this->capacity = capacity;
+  freeSize = 0;
+  if (allocated < capacity)
+  {
+    _insert(allocated, capacity - allocated);
+    freeSize = capacity - allocated;
+  }
+}
+
+void kdr::Graphics::RangeAllocator::_insert(const GLuint offset, const GLuint size)
+{
+  freeByOffset[offset] = size;
+  freeBySize.insert({size, offset});
+}
+
+void kdr::Graphics::RangeAllocator::_erase(const GLuint offset, const GLuint size)
+{
+  freeByOffset.erase(offset);
+
+  std::pair<std::multimap<GLuint, GLuint>::iterator, std::multimap<GLuint, GLuint>::iterator> range = freeBySize.equal_range(size);
+  for (std::multimap<GLuint, GLuint>::iterator it = range.first; it != range.second; it++)
+  {
+    if (it->second == offset)
+    {
+      freeBySize.erase(it);
+      return;
+    }
+  }
+}
+
+kdr::Graphics::MeshPool::MeshPool(
+  const GLsizeiptr vertexStride,
+  const std::vector<kdr::Graphics::VertexAttribute>& attributes,
+  const GLuint vertexCapacity,
+  const GLuint indexCapacity
+) : vertexStride(vertexStride), attributes(attributes), vertexAllocator(vertexCapacity), indexAllocator(indexCapacity)
+{
+  glGenVertexArrays(1, &vaoID);
+  vertexBufferID = _createBuffer(vertexCapacity * vertexStride);
+  indexBufferID  = _createBuffer(indexCapacity * sizeof(GLuint));
+  _link();
+}
+
+kdr::Graphics::MeshHandle kdr::Graphics::MeshPool::Add(const void* vertices, const GLuint vertexCount, const GLuint* indices, const GLuint indexCount)
+{
+  const kdr::Graphics::MeshHandle handle = Reserve(vertexCount, indexCount);
+  if (handle == kdr::Graphics::invalidMesh) return handle;
+  const kdr::Graphics::MeshRange& range = meshes[handle].range;
+
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  stateCache.bindBuffer(GL_COPY_WRITE_BUFFER, vertexBufferID);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, range.baseVertex * vertexStride, vertexCount * vertexStride, vertices);
+  stateCache.bindBuffer(GL_COPY_WRITE_BUFFER, indexBufferID);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(GLuint), indexCount * sizeof(GLuint), indices);
+  return handle;
+}
+
+kdr::Graphics::MeshHandle kdr::Graphics::MeshPool::Reserve(const GLuint vertexCount, const GLuint indexCount)
+{
+  // The allocators can't place an empty range, so growing would never make room for one
+  if (vertexCount == 0 || indexCount == 0)
+  {
+    std::cerr << "Failed to add a mesh to the pool: it has no vertices or no indices!\n";
+    return kdr::Graphics::invalidMesh;
+  }
+
+  GLuint vertexOffset {0};
+  if (!vertexAllocator.allocate(vertexCount, vertexOffset))
+  {
+    const GLuint oldCapacity = vertexAllocator.getCapacity();
+    GLuint newCapacity {0};
+    if (!getGrownCapacity(oldCapacity, vertexCount, newCapacity))
+    {
+      std::cerr << "Failed to add a mesh to the pool: " << vertexCount << " more vertices exceed the largest pool!\n";
+      return kdr::Graphics::invalidMesh;
+    }
+    _growBuffer(vertexBufferID, (GLsizeiptr)oldCapacity * vertexStride, (GLsizeiptr)newCapacity * vertexStride);
+    vertexAllocator.grow(newCapacity);
+    if (!vertexAllocator.allocate(vertexCount, vertexOffset))
+    {
+      std::cerr << "Failed to add a mesh to the pool: no room for " << vertexCount << " vertices!\n";
+      return kdr::Graphics::invalidMesh;
+    }
+  }
+
+  GLuint indexOffset {0};
+  if (!indexAllocator.allocate(indexCount, indexOffset))
+  {
+    const GLuint oldCapacity = indexAllocator.getCapacity();
+    GLuint newCapacity {0};
+    if (!getGrownCapacity(oldCapacity, indexCount, newCapacity))
+    {
+      std::cerr << "Failed to add a mesh to the pool: " << indexCount << " more indices exceed the largest pool!\n";
+      vertexAllocator.free(vertexOffset, vertexCount);
+      return kdr::Graphics::invalidMesh;
+    }
+    _growBuffer(indexBufferID, (GLsizeiptr)oldCapacity * sizeof(GLuint), (GLsizeiptr)newCapacity * sizeof(GLuint));
+    indexAllocator.grow(newCapacity);
+    if (!indexAllocator.allocate(indexCount, indexOffset))
+    {
+      std::cerr << "Failed to add a mesh to the pool: no room for " << indexCount << " indices!\n";
+      vertexAllocator.free(vertexOffset, vertexCount);
+      return kdr::Graphics::invalidMesh;
+    }
+  }
+
+  kdr::Graphics::MeshHandle handle = (kdr::Graphics::MeshHandle)meshes.size();
+  if (!freeHandles.empty())
+  {
+    handle = freeHandles.back();
+    freeHandles.pop_back();
+  }
+  else
+  {
+    meshes.push_back(Slot());
+  }
+
+  Slot& slot = meshes[handle];
+  slot.range.baseVertex  = (GLint)vertexOffset;
+  slot.range.firstIndex  = indexOffset;
+  slot.range.vertexCount = vertexCount;
+  slot.range.indexCount  = indexCount;
+  slot.live = true;
+  return handle;
+}
+
+void kdr::Graphics::MeshPool::Remove(const kdr::Graphics::MeshHandle handle)
+{
+  if (!getIsValid(handle)) return;
+
+  Slot& slot = meshes[handle];
+  vertexAllocator.free((GLuint)slot.range.baseVertex, slot.range.vertexCount);
+  indexAllocator.free(slot.range.firstIndex, slot.range.indexCount);
+  slot.live = false;
+  freeHandles.push_back(handle);
+}
+
+void kdr::Graphics::MeshPool::Defragment()
+{
+  if (vertexAllocator.getIsCompact() && indexAllocator.getIsCompact()) return;
+
+  const GLuint vertexCapacity = vertexAllocator.getCapacity();
+  const GLuint indexCapacity  = indexAllocator.getCapacity();
+
+  GLuint newVertexBufferID = _createBuffer(vertexCapacity * vertexStride);
+  GLuint newIndexBufferID  = _createBuffer(indexCapacity * sizeof(GLuint));
+
+  // Packing meshes in their current order keeps neighbours adjacent
+  std::vector<kdr::Graphics::MeshHandle> order;
+  for (kdr::Graphics::MeshHandle handle = 0; handle < meshes.size(); handle++)
+  {
+    if (meshes[handle].live) order.push_back(handle);
+  }
+  std::sort(order.begin(), order.end(), [this](const kdr::Graphics::MeshHandle a, const kdr::Graphics::MeshHandle b)
+  {
+    return meshes[a].range.baseVertex < meshes[b].range.baseVertex;
+  });
+
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  GLuint vertexCursor {0};
+  GLuint indexCursor  {0};
+  for (const kdr::Graphics::MeshHandle handle : order)
+  {
+    kdr::Graphics::MeshRange& range = meshes[handle].range;
+
+    stateCache.bindBuffer(GL_COPY_READ_BUFFER, vertexBufferID);
+    stateCache.bindBuffer(GL_COPY_WRITE_BUFFER, newVertexBufferID);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.baseVertex * vertexStride, vertexCursor * vertexStride, range.vertexCount * vertexStride);
+
+    stateCache.bindBuffer(GL_COPY_READ_BUFFER, indexBufferID);
+    stateCache.bindBuffer(GL_COPY_WRITE_BUFFER, newIndexBufferID);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(GLuint), indexCursor * sizeof(GLuint), range.indexCount * sizeof(GLuint));
+
+    range.baseVertex = (GLint)vertexCursor;
+    range.firstIndex = indexCursor;
+    vertexCursor += range.vertexCount;
+    indexCursor  += range.indexCount;
+  }
+
+  stateCache.onBufferDeleted(vertexBufferID);
+  stateCache.onBufferDeleted(indexBufferID);
+  glDeleteBuffers(1, &vertexBufferID);
+  glDeleteBuffers(1, &indexBufferID);
+  vertexBufferID = newVertexBufferID;
+  indexBufferID  = newIndexBufferID;
+
+  vertexAllocator.reset(vertexCapacity, vertexCursor);
+  indexAllocator.reset(indexCapacity, indexCursor);
+  _link();
+}
+
+void kdr::Graphics::MeshPool::Draw(const kdr::Graphics::MeshHandle handle, const GLenum mode)
+{
+  if (!getIsValid(handle)) return;
+
+  const kdr::Graphics::MeshRange& range = meshes[handle].range;
+  Bind();
+  glDrawElementsBaseVertex(
+    mode,
+    range.indexCount,
+    GL_UNSIGNED_INT,
+    (void*)(range.firstIndex * sizeof(GLuint)),
+    range.baseVertex
+  );
+}
+
+void kdr::Graphics::MeshPool::Delete()
+{
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  stateCache.onVertexArrayDeleted(vaoID);
+  stateCache.onBufferDeleted(vertexBufferID);
+  stateCache.onBufferDeleted(indexBufferID);
+  glDeleteVertexArrays(1, &vaoID);
+  glDeleteBuffers(1, &vertexBufferID);
+  glDeleteBuffers(1, &indexBufferID);
+}
+
+GLuint kdr::Graphics::MeshPool::_createBuffer(const GLsizeiptr size)
+{
+  GLuint bufferID {0};
+  glGenBuffers(1, &bufferID);
+  kdr::Graphics::getStateCache().bindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+  glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+  return bufferID;
+}
+
+void kdr::Graphics::MeshPool::_growBuffer(GLuint& bufferID, const GLsizeiptr oldSize, const GLsizeiptr newSize)
+{
+  GLuint newBufferID = _createBuffer(newSize);
+
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  stateCache.bindBuffer(GL_COPY_READ_BUFFER, bufferID);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+  stateCache.onBufferDeleted(bufferID);
+  glDeleteBuffers(1, &bufferID);
+  bufferID = newBufferID;
+
+  _link();
+}
+
+void kdr::Graphics::MeshPool::_link()
+{
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  const GLuint previousVAO = stateCache.getVertexArray();
+
+  stateCache.bindVertexArray(vaoID);
+  stateCache.bindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+  stateCache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+  for (const kdr::Graphics::VertexAttribute& attribute : attributes)
+  {
+    glVertexAttribPointer(
+      attribute.layout,
+      attribute.size,
+      attribute.type,
+      GL_FALSE,
+      vertexStride,
+      (void*)attribute.offset
+    );
+    glEnableVertexAttribArray(attribute.layout);
+  }
+
+  stateCache.bindVertexArray(previousVAO);
+}
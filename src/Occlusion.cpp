@@ -0,0 +1,210 @@
+#include "Kedarium/Occlusion.hpp"
+
+#include "Kedarium/ProgramCache.hpp"
+
+// Bounding boxes are drawn as a unit cube stretched between their corners
+static const char* proxyVertexSource =
+  "#version 330 core\n"
+  "layout (location = 0) in vec3 aPos;\n"
+  "layout (std140) uniform Camera\n"
+  "{\n"
+  "  mat4 cameraMatrix;\n"
+  "  mat4 viewMatrix;\n"
+  "  mat4 projectionMatrix;\n"
+  "  vec4 cameraPosition;\n"
+  "};\n"
+  "uniform vec3 boxMin;\n"
+  "uniform vec3 boxMax;\n"
+  "void main()\n"
+  "{\n"
+  "  gl_Position = cameraMatrix * vec4(mix(boxMin, boxMax, aPos), 1.f);\n"
+  "}\n";
+
+static const char* proxyFragmentSource =
+  "#version 330 core\n"
+  "void main()\n"
+  "{\n"
+  "}\n";
+
+kdr::Graphics::OcclusionCuller::OcclusionCuller()
+{
+  kdr::Graphics::ShaderSource source;
+  source.vertexPath = "OcclusionCuller";
+  source.fragmentPath = "OcclusionCuller";
+  source.vertexSource = proxyVertexSource;
+  source.fragmentSource = proxyFragmentSource;
+
+  kdr::Graphics::ProgramCache& programCache = kdr::Graphics::getProgramCache();
+  if (programCache.getIsEnabled())
+  {
+    source.cacheKey = programCache.makeKey(source.vertexSource, source.fragmentSource);
+  }
+
+  shader = new kdr::Graphics::Shader(source);
+  boxMinLocation = shader->getUniformLocation("boxMin");
+  boxMaxLocation = shader->getUniformLocation("boxMax");
+
+  GLfloat vertices[] =
+  {
+    0.f, 0.f, 0.f,
+    1.f, 0.f, 0.f,
+    1.f, 1.f, 0.f,
+    0.f, 1.f, 0.f,
+    0.f, 0.f, 1.f,
+    1.f, 0.f, 1.f,
+    1.f, 1.f, 1.f,
+    0.f, 1.f, 1.f,
+  };
+  GLuint indices[] =
+  {
+    0, 2, 1, 0, 3, 2,
+    4, 5, 6, 4, 6, 7,
+    0, 1, 5, 0, 5, 4,
+    3, 6, 2, 3, 7, 6,
+    0, 4, 7, 0, 7, 3,
+    1, 2, 6, 1, 6, 5,
+  };
+
+  VAO = new kdr::Graphics::VAO();
+  VAO->Bind();
+  VBO = new kdr::Graphics::VBO(vertices, sizeof(vertices));
+  EBO = new kdr::Graphics::EBO(indices, sizeof(indices));
+  EBO->Bind();
+  VAO->LinkAtrib(*VBO, 0, 3, GL_FLOAT, 3 * sizeof(GLfloat), (void*)0);
+  VAO->Unbind();
+}
+
+void kdr::Graphics::OcclusionCuller::cull(
+  const kdr::Space::Vec3& cameraPosition,
+  const std::vector<kdr::Space::AABB>& bounds,
+  const std::vector<uint32_t>& candidates,
+  std::vector<uint32_t>& visible,
+  std::vector<uint32_t>& conditional
+)
+{
+  visible.clear();
+  conditional.clear();
+  queuedIDs.clear();
+  queuedBounds.clear();
+  occludedCount = 0;
+
+  if (objects.size() < bounds.size())
+  {
+    objects.resize(bounds.size());
+  }
+
+  for (const uint32_t objectID : candidates)
+  {
+    ObjectState& state = objects[objectID];
+    const kdr::Space::AABB& box = bounds[objectID];
+
+    // The near plane clips boxes around the camera, which would read as occluded
+    const kdr::Space::Vec3 margin {cameraMargin, cameraMargin, cameraMargin};
+    const kdr::Space::AABB nearBox(box.min - margin, box.max + margin);
+    if (
+      cameraPosition.x >= nearBox.min.x && cameraPosition.x <= nearBox.max.x &&
+      cameraPosition.y >= nearBox.min.y && cameraPosition.y <= nearBox.max.y &&
+      cameraPosition.z >= nearBox.min.z && cameraPosition.z <= nearBox.max.z
+    )
+    {
+      state.isVisible = true;
+      visible.push_back(objectID);
+      continue;
+    }
+
+    _poll(state);
+    const bool isQueued = !state.isPending;
+    if (isQueued)
+    {
+      queuedIDs.push_back(objectID);
+      queuedBounds.push_back(box);
+    }
+
+    if (state.isVisible)
+    {
+      visible.push_back(objectID);
+    }
+    else
+    {
+      // A query still in flight decides the draw as well, so a hidden object never skips a frame
+      conditional.push_back(objectID);
+      occludedCount++;
+    }
+  }
+}
+
+void kdr::Graphics::OcclusionCuller::Query()
+{
+  KDR_PROFILE_GPU_SCOPE("OcclusionCuller::Query");
+  queryCount = queuedIDs.size();
+  if (queuedIDs.empty()) return;
+
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  stateCache.useProgram(shader->getID());
+  stateCache.bindVertexArray(VAO->getID());
+  stateCache.setDepthTest(true);
+  stateCache.setDepthMask(false);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+  for (size_t i = 0; i < queuedIDs.size(); i++)
+  {
+    ObjectState& state = objects[queuedIDs[i]];
+    if (state.query == 0)
+    {
+      glGenQueries(1, &state.query);
+    }
+
+    const kdr::Space::AABB& box = queuedBounds[i];
+    glUniform3f(boxMinLocation, box.min.x, box.min.y, box.min.z);
+    glUniform3f(boxMaxLocation, box.max.x, box.max.y, box.max.z);
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, state.query);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, (void*)0);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    state.isPending = true;
+  }
+
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  stateCache.setDepthMask(true);
+}
+
+void kdr::Graphics::OcclusionCuller::Delete()
+{
+  for (ObjectState& state : objects)
+  {
+    if (state.query != 0)
+    {
+      glDeleteQueries(1, &state.query);
+    }
+  }
+  objects.clear();
+
+  if (shader == NULL) return;
+
+  shader->Delete();
+  VAO->Delete();
+  VBO->Delete();
+  EBO->Delete();
+  delete shader;
+  delete VAO;
+  delete VBO;
+  delete EBO;
+  shader = NULL;
+  VAO = NULL;
+  VBO = NULL;
+  EBO = NULL;
+}
+
+void kdr::Graphics::OcclusionCuller::_poll(ObjectState& state)
+{
+  if (!state.isPending) return;
+
+  GLuint isAvailable {GL_FALSE};
+  glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+  if (isAvailable == GL_FALSE) return;
+
+  GLuint anySamplesPassed {GL_FALSE};
+  glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &anySamplesPassed);
+  state.isVisible = anySamplesPassed != GL_FALSE;
+  state.isPending = false;
+}
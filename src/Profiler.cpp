@@ -0,0 +1,237 @@
+#include "Kedarium/Profiler.hpp"
+
+#include <atomic>
+#include <sstream>
+
+#include "Kedarium/File.hpp"
+
+static std::atomic<uint32_t> nextThreadIndex {0};
+static thread_local uint32_t threadIndex {nextThreadIndex++};
+static thread_local uint32_t threadDepth {0};
+
+kdr::Profile::Profiler& kdr::Profile::getProfiler()
+{
+  static kdr::Profile::Profiler profiler;
+  return profiler;
+}
+
+kdr::Profile::Scope::Scope(const char* name)
+: name(name)
+{
+  kdr::Profile::Profiler& profiler = kdr::Profile::getProfiler();
+  if (!profiler.getIsEnabled()) return;
+
+  start = profiler.getTime();
+  threadDepth++;
+}
+
+kdr::Profile::Scope::~Scope()
+{
+  if (start < 0.) return;
+
+  threadDepth--;
+  kdr::Profile::Profiler& profiler = kdr::Profile::getProfiler();
+  profiler.recordCpu(name, start, profiler.getTime(), threadDepth);
+}
+
+kdr::Profile::Profiler::Profiler()
+: epoch(std::chrono::steady_clock::now())
+{
+  frames.resize(120);
+}
+
+void kdr::Profile::Profiler::setFrameCapacity(const size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  frames.clear();
+  frames.resize(capacity > minFrameCapacity ? capacity : minFrameCapacity);
+  frameCount = 0;
+
+  // Frame indices start over, so results still in flight must not land in the new frames
+  for (PendingQuery& pending : pendingQueries)
+  {
+    pending.frameIndex = UINT64_MAX;
+  }
+}
+
+std::vector<const kdr::Profile::FrameRecord*> kdr::Profile::Profiler::getFrames() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // The frame being recorded is left out until it ends
+  const uint64_t finished = isFrameActive ? frameCount - 1 : frameCount;
+  const uint64_t count = finished < frames.size() ? finished : frames.size();
+
+  std::vector<const kdr::Profile::FrameRecord*> records;
+  records.reserve(count);
+  for (uint64_t i = finished - count; i < finished; i++)
+  {
+    records.push_back(&frames[i % frames.size()]);
+  }
+  return records;
+}
+
+void kdr::Profile::Profiler::beginFrame()
+{
+  if (!isEnabled) return;
+
+  _resolve();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  kdr::Profile::FrameRecord& frame = frames[frameCount % frames.size()];
+  frame.index = frameCount;
+  frame.start = getTime();
+  frame.duration = 0.;
+  frame.cpuEvents.clear();
+  frame.gpuEvents.clear();
+
+  frameCount++;
+  isFrameActive = true;
+}
+
+void kdr::Profile::Profiler::endFrame()
+{
+  if (!isFrameActive) return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint64_t index = frameCount - 1;
+    kdr::Profile::FrameRecord& frame = frames[index % frames.size()];
+    frame.duration = getTime() - frame.start;
+    isFrameActive = false;
+  }
+
+  _resolve();
+}
+
+void kdr::Profile::Profiler::recordCpu(const char* name, const double start, const double end, const uint32_t depth)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!isFrameActive) return;
+
+  kdr::Profile::CpuEvent event;
+  event.name     = name;
+  event.start    = start;
+  event.duration = end - start;
+  event.thread   = threadIndex;
+  event.depth    = depth;
+  frames[(frameCount - 1) % frames.size()].cpuEvents.push_back(event);
+}
+
+bool kdr::Profile::Profiler::beginGpu(const char* name)
+{
+  if (!isFrameActive || isGpuActive) return false;
+
+  PendingQuery pending;
+  pending.name       = name;
+  pending.start      = getTime();
+  pending.query      = 0;
+  pending.frameIndex = frameCount - 1;
+  if (freeQueries.empty())
+  {
+    glGenQueries(1, &pending.query);
+  }
+  else
+  {
+    pending.query = freeQueries.back();
+    freeQueries.pop_back();
+  }
+  pendingQueries.push_back(pending);
+
+  glBeginQuery(GL_TIME_ELAPSED, pending.query);
+  isGpuActive = true;
+  return true;
+}
+
+void kdr::Profile::Profiler::endGpu()
+{
+  glEndQuery(GL_TIME_ELAPSED);
+  isGpuActive = false;
+}
+
+bool kdr::Profile::Profiler::exportChromeTrace(const std::string& path) const
+{
+  const std::vector<const kdr::Profile::FrameRecord*> records = getFrames();
+
+  std::ostringstream json;
+  json.precision(3);
+  json << std::fixed;
+  json << "{\"traceEvents\":[\n";
+  json << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+  // Chrome traces use microseconds; CPU threads are offset by one to leave tid 0 to the GPU
+  for (const kdr::Profile::FrameRecord* frame : records)
+  {
+    json << ",\n{\"name\":\"Frame " << frame->index << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+         << ",\"ts\":" << frame->start * 1e6 << ",\"dur\":" << frame->duration * 1e6 << "}";
+
+    for (const kdr::Profile::CpuEvent& event : frame->cpuEvents)
+    {
+      json << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread + 1
+           << ",\"ts\":" << event.start * 1e6 << ",\"dur\":" << event.duration * 1e6 << "}";
+    }
+    for (const kdr::Profile::GpuEvent& event : frame->gpuEvents)
+    {
+      json << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+           << ",\"ts\":" << event.start * 1e6 << ",\"dur\":" << event.duration * 1e6 << "}";
+    }
+  }
+  json << "\n]}\n";
+
+  const std::string contents = json.str();
+  return kdr::File::writeContents(path.c_str(), contents.data(), contents.size());
+}
+
+void kdr::Profile::Profiler::Delete()
+{
+  for (const PendingQuery& pending : pendingQueries)
+  {
+    freeQueries.push_back(pending.query);
+  }
+  pendingQueries.clear();
+
+  if (!freeQueries.empty())
+  {
+    glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+  }
+  freeQueries.clear();
+}
+
+void kdr::Profile::Profiler::_resolve()
+{
+  // Queries finish in the order they were issued, so the first one not ready ends the read-back.
+  // Asking for a result that isn't available would stall until the GPU catches up
+  std::vector<std::pair<uint64_t, kdr::Profile::GpuEvent>> events;
+  while (!pendingQueries.empty())
+  {
+    const PendingQuery& pending = pendingQueries.front();
+
+    GLuint isAvailable {GL_FALSE};
+    glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    if (isAvailable == GL_FALSE) break;
+
+    GLuint64 elapsed {0};
+    glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+
+    kdr::Profile::GpuEvent event;
+    event.name     = pending.name;
+    event.start    = pending.start;
+    event.duration = elapsed * 1e-9;
+    events.push_back(std::make_pair(pending.frameIndex, event));
+
+    freeQueries.push_back(pending.query);
+    pendingQueries.pop_front();
+  }
+  if (events.empty()) return;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const std::pair<uint64_t, kdr::Profile::GpuEvent>& event : events)
+  {
+    // Results for frames that already left the ring are dropped
+    kdr::Profile::FrameRecord& frame = frames[event.first % frames.size()];
+    if (frame.index == event.first)
+    {
+      frame.gpuEvents.push_back(event.second);
+    }
+  }
+}
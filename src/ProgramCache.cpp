@@ -0,0 +1,173 @@
+#include "Kedarium/ProgramCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string.h>
+#include <vector>
+
+constexpr uint32_t PROGRAM_CACHE_MAGIC   {0x5044524B}; // "KRDP"
+constexpr uint32_t PROGRAM_CACHE_VERSION {1};
+
+struct ProgramCacheHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t binaryFormat;
+  uint32_t binaryLength;
+  double   compileSeconds;
+};
+
+static uint64_t hashBytes(const void* data, const size_t size, uint64_t hash)
+{
+  // FNV-1a
+  const unsigned char* bytes = (const unsigned char*)data;
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+kdr::Graphics::ProgramCache& kdr::Graphics::getProgramCache()
+{
+  static kdr::Graphics::ProgramCache programCache;
+  return programCache;
+}
+
+bool kdr::Graphics::ProgramCache::setDirectory(const std::string& directory)
+{
+  this->directory.clear();
+  if (directory.empty()) return true;
+
+  GLint formatCount {0};
+  if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+  {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  }
+  if (formatCount <= 0)
+  {
+    std::cerr << "The driver cannot retrieve program binaries, the program cache stays disabled!\n";
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+  {
+    std::cerr << "Failed to create the program cache directory: " << directory << "!\n";
+    std::cerr << "Error: " << error.message() << '\n';
+    return false;
+  }
+
+  driverSignature.clear();
+  const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION};
+  for (const GLenum name : names)
+  {
+    const GLubyte* value = glGetString(name);
+    if (value != NULL) driverSignature += (const char*)value;
+    driverSignature += '\n';
+  }
+
+  this->directory = directory;
+  return true;
+}
+
+uint64_t kdr::Graphics::ProgramCache::makeKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  hash = hashBytes(driverSignature.data(), driverSignature.size(), hash);
+  hash = hashBytes(vertexSource.data(), vertexSource.size(), hash);
+  hash = hashBytes("\0", 1, hash);
+  hash = hashBytes(fragmentSource.data(), fragmentSource.size(), hash);
+  return hash;
+}
+
+bool kdr::Graphics::ProgramCache::load(const GLuint programID, const uint64_t key)
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  std::vector<char> contents;
+  if (!kdr::File::getBinaryContents(_getPath(key).c_str(), contents))
+  {
+    stats.misses++;
+    return false;
+  }
+
+  ProgramCacheHeader header;
+  if (contents.size() < sizeof(header))
+  {
+    stats.misses++;
+    stats.rejections++;
+    return false;
+  }
+  memcpy(&header, contents.data(), sizeof(header));
+
+  if (
+    header.magic != PROGRAM_CACHE_MAGIC ||
+    header.version != PROGRAM_CACHE_VERSION ||
+    header.key != key ||
+    contents.size() != sizeof(header) + header.binaryLength
+  )
+  {
+    stats.misses++;
+    stats.rejections++;
+    return false;
+  }
+
+  // The driver may still refuse a binary it produced, e.g. after an update that kept its strings
+  glProgramBinary(programID, header.binaryFormat, contents.data() + sizeof(header), header.binaryLength);
+  GLint success {0};
+  glGetProgramiv(programID, GL_LINK_STATUS, &success);
+  if (!success)
+  {
+    stats.misses++;
+    stats.rejections++;
+    return false;
+  }
+
+  const double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  stats.hits++;
+  stats.loadSeconds += loadSeconds;
+  if (header.compileSeconds > loadSeconds)
+  {
+    stats.savedSeconds += header.compileSeconds - loadSeconds;
+  }
+  return true;
+}
+
+void kdr::Graphics::ProgramCache::store(const GLuint programID, const uint64_t key, const double compileSeconds)
+{
+  stats.compileSeconds += compileSeconds;
+
+  GLint binaryLength {0};
+  glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+  if (binaryLength <= 0) return;
+
+  std::vector<char> contents(sizeof(ProgramCacheHeader) + binaryLength);
+
+  GLenum binaryFormat {0};
+  GLsizei length {0};
+  glGetProgramBinary(programID, binaryLength, &length, &binaryFormat, contents.data() + sizeof(ProgramCacheHeader));
+
+  ProgramCacheHeader header;
+  header.magic          = PROGRAM_CACHE_MAGIC;
+  header.version        = PROGRAM_CACHE_VERSION;
+  header.key            = key;
+  header.binaryFormat   = binaryFormat;
+  header.binaryLength   = (uint32_t)length;
+  header.compileSeconds = compileSeconds;
+  memcpy(contents.data(), &header, sizeof(header));
+  contents.resize(sizeof(header) + length);
+
+  kdr::File::writeContents(_getPath(key).c_str(), contents.data(), contents.size());
+}
+
+std::string kdr::Graphics::ProgramCache::_getPath(const uint64_t key) const
+{
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return directory + "/" + name;
+}
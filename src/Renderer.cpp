@@ -0,0 +1,363 @@
+#include "Kedarium/Renderer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+uint64_t kdr::Graphics::Renderer::makeSortKey(const GLuint shaderID, const GLuint vaoID, const uint16_t material, const float depth)
+{
+  // The bit pattern of a non-negative float grows with its value, so its top bits sort like the float
+  float clampedDepth = depth > 0.f ? depth : 0.f;
+  uint32_t depthBits {0};
+  memcpy(&depthBits, &clampedDepth, sizeof(depthBits));
+
+  return
+    ((uint64_t)(shaderID & 0xFFFF) << 48) |
+    ((uint64_t)(vaoID    & 0xFFFF) << 32) |
+    ((uint64_t)material            << 16) |
+    ((uint64_t)(depthBits >> 16));
+}
+
+void kdr::Graphics::Renderer::submit(
+  kdr::Graphics::Shader& shader,
+  kdr::Graphics::VAO& VAO,
+  const GLenum mode,
+  const GLsizei count,
+  const uint16_t material,
+  const float depth,
+  const GLsizeiptr offset,
+  const bool isOccluder
+)
+{
+  // A deferred program has to be reflected before its camera block can be bound
+  shader.Finalize();
+
+  kdr::Graphics::DrawCommand command;
+  command.key            = makeSortKey(shader.getID(), VAO.getID(), material, depth);
+  command.shaderID       = shader.getID();
+  command.vaoID          = VAO.getID();
+  command.material       = material;
+  command.mode           = mode;
+  command.count          = count;
+  command.offset         = offset;
+  command.baseVertex     = 0;
+  command.instanceCount  = 1;
+  command.baseInstance   = 0;
+  command.isOccluder     = isOccluder;
+  command.conditionQuery = 0;
+  commands.push_back(command);
+}
+
+void kdr::Graphics::Renderer::submit(
+  kdr::Graphics::Shader& shader,
+  kdr::Graphics::MeshPool& pool,
+  const kdr::Graphics::MeshHandle handle,
+  const uint16_t material,
+  const float depth,
+  const GLenum mode,
+  const bool isOccluder
+)
+{
+  if (!pool.getIsValid(handle)) return;
+  shader.Finalize();
+
+  const kdr::Graphics::MeshRange& range = pool.getRange(handle);
+
+  kdr::Graphics::DrawCommand command;
+  command.key            = makeSortKey(shader.getID(), pool.getVAOID(), material, depth);
+  command.shaderID       = shader.getID();
+  command.vaoID          = pool.getVAOID();
+  command.material       = material;
+  command.mode           = mode;
+  command.count          = range.indexCount;
+  command.offset         = range.firstIndex * sizeof(GLuint);
+  command.baseVertex     = range.baseVertex;
+  command.instanceCount  = 1;
+  command.baseInstance   = 0;
+  command.isOccluder     = isOccluder;
+  command.conditionQuery = 0;
+  commands.push_back(command);
+}
+
+void kdr::Graphics::Renderer::submit(const kdr::Graphics::DrawCommand& command)
+{
+  commands.push_back(command);
+}
+
+void kdr::Graphics::Renderer::flush()
+{
+  KDR_PROFILE_SCOPE("Renderer::flush");
+
+  submittedCount   = commands.size();
+  drawCallCount    = 0;
+  programBindCount = 0;
+  vaoBindCount     = 0;
+  occluderCount    = 0;
+
+  if (commands.empty()) return;
+
+  std::sort(
+    commands.begin(),
+    commands.end(),
+    [](const kdr::Graphics::DrawCommand& a, const kdr::Graphics::DrawCommand& b)
+    {
+      if (a.key != b.key) return a.key < b.key;
+      if (a.shaderID != b.shaderID) return a.shaderID < b.shaderID;
+      if (a.vaoID != b.vaoID) return a.vaoID < b.vaoID;
+      return a.offset < b.offset;
+    }
+  );
+  _merge();
+
+  boundShaderID = 0;
+  boundVAOID    = 0;
+  hasMaterial   = false;
+
+  _flushDepthPrePass();
+
+  if (getIsIndirectActive())
+  {
+    _flushIndirect();
+  }
+  else
+  {
+    for (const kdr::Graphics::DrawCommand& command : commands)
+    {
+      _bind(command);
+      _draw(command);
+    }
+  }
+  kdr::Graphics::getStateCache().setDepthFunc(GL_LESS);
+
+  commands.clear();
+}
+
+const bool kdr::Graphics::Renderer::getIsIndirectActive() const
+{
+  return isIndirectEnabled && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+}
+
+void kdr::Graphics::Renderer::Delete()
+{
+  if (indirectBuffer == NULL) return;
+
+  indirectBuffer->Delete();
+  delete indirectBuffer;
+  indirectBuffer = NULL;
+}
+
+void kdr::Graphics::Renderer::_merge()
+{
+  size_t last = 0;
+  for (size_t i = 1; i < commands.size(); i++)
+  {
+    kdr::Graphics::DrawCommand& pending = commands[last];
+    const kdr::Graphics::DrawCommand& command = commands[i];
+
+    // Merging draws that continue the previous index range with identical state
+    if (
+      command.shaderID == pending.shaderID &&
+      command.vaoID == pending.vaoID &&
+      command.material == pending.material &&
+      command.mode == pending.mode &&
+      command.baseVertex == pending.baseVertex &&
+      command.instanceCount == 1 &&
+      pending.instanceCount == 1 &&
+      command.baseInstance == pending.baseInstance &&
+      command.isOccluder == pending.isOccluder &&
+      command.conditionQuery == 0 &&
+      pending.conditionQuery == 0 &&
+      command.offset == pending.offset + (GLsizeiptr)(pending.count * sizeof(GLuint))
+    )
+    {
+      pending.count += command.count;
+      continue;
+    }
+
+    commands[++last] = command;
+  }
+  commands.resize(last + 1);
+}
+
+void kdr::Graphics::Renderer::_flushDepthPrePass()
+{
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  const bool wasDepthTestOn = stateCache.getDepthTest();
+
+  bool hasOccluders {false};
+  for (const kdr::Graphics::DrawCommand& command : commands)
+  {
+    hasOccluders = hasOccluders || command.isOccluder;
+  }
+
+  if (hasOccluders)
+  {
+    KDR_PROFILE_GPU_SCOPE("DepthPrePass");
+    stateCache.setDepthTest(true);
+    stateCache.setDepthMask(true);
+    stateCache.setDepthFunc(GL_LESS);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    for (const kdr::Graphics::DrawCommand& command : commands)
+    {
+      if (!command.isOccluder) continue;
+
+      _bind(command);
+      _draw(command);
+      occluderCount++;
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  }
+
+  if (prePassCallback)
+  {
+    prePassCallback();
+
+    // The callback may have bound its own program and VAO behind the renderer's back
+    boundShaderID = 0;
+    boundVAOID    = 0;
+    hasMaterial   = false;
+    stateCache.setDepthMask(true);
+  }
+
+  // The pre-pass and the callback enable depth testing, which the main pass may have turned off
+  stateCache.setDepthTest(wasDepthTestOn);
+
+  // Occluder fragments already in the depth buffer must pass again in the main pass
+  if (hasOccluders)
+  {
+    stateCache.setDepthFunc(GL_LEQUAL);
+  }
+}
+
+void kdr::Graphics::Renderer::_bind(const kdr::Graphics::DrawCommand& command)
+{
+  if (command.shaderID != boundShaderID)
+  {
+    kdr::Graphics::getStateCache().useProgram(command.shaderID);
+    boundShaderID = command.shaderID;
+    hasMaterial = false;
+    programBindCount++;
+    if (programCallback) programCallback(boundShaderID);
+  }
+  if (command.vaoID != boundVAOID)
+  {
+    kdr::Graphics::getStateCache().bindVertexArray(command.vaoID);
+    boundVAOID = command.vaoID;
+    vaoBindCount++;
+  }
+  if (!hasMaterial || command.material != boundMaterial)
+  {
+    boundMaterial = command.material;
+    hasMaterial = true;
+    if (materialCallback) materialCallback(boundMaterial, boundShaderID);
+  }
+}
+
+void kdr::Graphics::Renderer::_flushIndirect()
+{
+  indirectCommands.resize(commands.size());
+  for (size_t i = 0; i < commands.size(); i++)
+  {
+    const kdr::Graphics::DrawCommand& command = commands[i];
+    kdr::Graphics::DrawElementsIndirectCommand& indirect = indirectCommands[i];
+    indirect.count         = command.count;
+    indirect.instanceCount = command.instanceCount;
+    indirect.firstIndex    = (GLuint)(command.offset / sizeof(GLuint));
+    indirect.baseVertex    = command.baseVertex;
+    indirect.baseInstance  = command.baseInstance;
+  }
+
+  const GLsizeiptr size = indirectCommands.size() * sizeof(kdr::Graphics::DrawElementsIndirectCommand);
+  if (indirectBuffer == NULL || indirectBuffer->getFrameSize() < size)
+  {
+    GLsizeiptr frameSize = indirectBuffer != NULL ? indirectBuffer->getFrameSize() : 4096;
+    while (frameSize < size) frameSize *= 2;
+
+    Delete();
+    indirectBuffer = new kdr::Graphics::StreamBuffer(GL_DRAW_INDIRECT_BUFFER, frameSize);
+  }
+
+  indirectBuffer->BeginFrame();
+  const GLintptr baseOffset = indirectBuffer->Write(indirectCommands.data(), size, sizeof(GLuint));
+  indirectBuffer->Bind();
+
+  // One multi-draw per run of commands sharing program, VAO, material and primitive type
+  size_t first = 0;
+  while (first < commands.size())
+  {
+    const kdr::Graphics::DrawCommand& head = commands[first];
+    size_t last = first + 1;
+    while (
+      last < commands.size() &&
+      commands[last].shaderID == head.shaderID &&
+      commands[last].vaoID == head.vaoID &&
+      commands[last].material == head.material &&
+      commands[last].mode == head.mode &&
+      commands[last].conditionQuery == head.conditionQuery
+    )
+    {
+      last++;
+    }
+
+    _bind(head);
+    if (head.conditionQuery != 0)
+    {
+      glBeginConditionalRender(head.conditionQuery, GL_QUERY_NO_WAIT);
+    }
+    glMultiDrawElementsIndirect(
+      head.mode,
+      GL_UNSIGNED_INT,
+      (const void*)(baseOffset + first * sizeof(kdr::Graphics::DrawElementsIndirectCommand)),
+      (GLsizei)(last - first),
+      0
+    );
+    if (head.conditionQuery != 0)
+    {
+      glEndConditionalRender();
+    }
+    drawCallCount++;
+
+    first = last;
+  }
+
+  indirectBuffer->EndFrame();
+}
+
+void kdr::Graphics::Renderer::_draw(const kdr::Graphics::DrawCommand& command)
+{
+  const void* indices = (const void*)command.offset;
+
+  // Without waiting, the GPU draws anyway if the query hasn't finished by the time it gets here
+  if (command.conditionQuery != 0)
+  {
+    glBeginConditionalRender(command.conditionQuery, GL_QUERY_NO_WAIT);
+  }
+
+  if (command.baseInstance != 0 && !GLEW_ARB_base_instance && !isBaseInstanceWarned)
+  {
+    std::cerr << "Failed to draw from a base instance: ARB_base_instance is not supported, instance 0 is used instead!\n";
+    isBaseInstanceWarned = true;
+  }
+
+  if (command.baseInstance != 0 && GLEW_ARB_base_instance)
+  {
+    glDrawElementsInstancedBaseVertexBaseInstance(command.mode, command.count, GL_UNSIGNED_INT, indices, command.instanceCount, command.baseVertex, command.baseInstance);
+  }
+  else if (command.instanceCount > 1)
+  {
+    glDrawElementsInstancedBaseVertex(command.mode, command.count, GL_UNSIGNED_INT, indices, command.instanceCount, command.baseVertex);
+  }
+  else if (command.baseVertex != 0)
+  {
+    glDrawElementsBaseVertex(command.mode, command.count, GL_UNSIGNED_INT, indices, command.baseVertex);
+  }
+  else
+  {
+    glDrawElements(command.mode, command.count, GL_UNSIGNED_INT, indices);
+  }
+  if (command.conditionQuery != 0)
+  {
+    glEndConditionalRender();
+  }
+  drawCallCount++;
+}
@@ -0,0 +1,329 @@
+#include "Kedarium/Residency.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Kedarium/File.hpp"
+#include "Kedarium/Profiler.hpp"
+
+// Levels of this size and smaller are loaded together when a texture first streams in
+static const GLsizei tailSize {128};
+
+// Picks the finest level a texture needs: the one with at least one texel per pixel on screen
+static GLsizei getWantedLevel(const kdr::Graphics::Texture& texture, const float screenSize)
+{
+  const GLsizei coarsest = texture.getLevelCount() - 1;
+  if (!(screenSize > 0.f)) return coarsest;
+
+  const float size = (float)std::max(texture.getWidth(), texture.getHeight());
+  if (screenSize >= size) return 0;
+
+  const GLsizei level = (GLsizei)floorf(log2f(size / screenSize));
+  return level < coarsest ? level : coarsest;
+}
+
+// Rates how much a texture needs a level. Above 1 the level is magnified on screen, below 1 its detail is lost
+static float getPriority(const kdr::Stream::TextureAsset& asset, const GLsizei level)
+{
+  const kdr::Graphics::Texture& texture = *asset.getTexture();
+  const GLsizei size = std::max(texture.getLevelWidth(level), texture.getLevelHeight(level));
+  return asset.getScreenSize() / (float)size;
+}
+
+// Finds the finest level that still counts as part of the small tail of a mip chain
+static GLsizei getTailLevel(const kdr::Graphics::Texture& texture)
+{
+  GLsizei level {0};
+  while (level + 1 < texture.getLevelCount() && std::max(texture.getLevelWidth(level), texture.getLevelHeight(level)) > tailSize)
+  {
+    level++;
+  }
+  return level;
+}
+
+std::shared_ptr<kdr::Stream::TextureAsset> kdr::Stream::TextureResidency::load(const std::string& path)
+{
+  std::shared_ptr<kdr::Stream::TextureAsset> asset = std::make_shared<kdr::Stream::TextureAsset>();
+  streamer.start();
+
+  streamer.read([this, asset, path]()
+  {
+    // Only the headers are read here; the pages of each level are read once it is requested
+    std::shared_ptr<kdr::Graphics::TextureFile> file = std::make_shared<kdr::Graphics::TextureFile>();
+    if (!file->open(path.c_str()))
+    {
+      std::cerr << "Failed to stream the texture: " << path << "!\n";
+      streamer.finish(*asset, false);
+      return;
+    }
+
+    asset->file = file;
+    std::lock_guard<std::mutex> lock(openedMutex);
+    openedAssets.push_back(asset);
+  });
+  return asset;
+}
+
+void kdr::Stream::TextureResidency::Update()
+{
+  KDR_PROFILE_SCOPE("TextureResidency::Update");
+  _adoptOpened();
+
+  // Textures nobody holds anymore are unloaded, unless an upload still writes into them
+  for (size_t i = 0; i < assets.size();)
+  {
+    kdr::Stream::TextureAsset& asset = *assets[i];
+    if (assets[i].use_count() > 1 || asset.isLoading)
+    {
+      i++;
+      continue;
+    }
+
+    memorySize -= asset.texture->getMemorySize();
+    asset.texture->Delete();
+    delete asset.texture;
+    asset.texture = NULL;
+    assets[i] = std::move(assets.back());
+    assets.pop_back();
+  }
+
+  for (const std::shared_ptr<kdr::Stream::TextureAsset>& asset : assets)
+  {
+    asset->wantedLevel = getWantedLevel(*asset->texture, asset->screenSize);
+  }
+
+  // Over the budget, the finest levels that are needed least go first. The coarsest level of
+  // every texture stays, so nothing that was drawable stops being drawable
+  while (memorySize > budget)
+  {
+    kdr::Stream::TextureAsset* victim {NULL};
+    float victimPriority {0.f};
+    for (const std::shared_ptr<kdr::Stream::TextureAsset>& asset : assets)
+    {
+      if (asset->isLoading || asset->definedLevel >= asset->texture->getLevelCount() - 1) continue;
+
+      const float priority = getPriority(*asset, asset->definedLevel);
+      if (victim == NULL || priority < victimPriority)
+      {
+        victim = asset.get();
+        victimPriority = priority;
+      }
+    }
+    if (victim == NULL) break;
+
+    _evict(*victim);
+  }
+
+  std::vector<std::pair<float, size_t>> requests;
+  for (size_t i = 0; i < assets.size(); i++)
+  {
+    const kdr::Stream::TextureAsset& asset = *assets[i];
+    if (asset.isLoading || asset.isFailed || asset.definedLevel <= asset.wantedLevel) continue;
+
+    requests.push_back(std::make_pair(getPriority(asset, asset.definedLevel - 1), i));
+  }
+  std::sort(requests.begin(), requests.end(), [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b)
+  {
+    return a.first > b.first;
+  });
+
+  for (const std::pair<float, size_t>& request : requests)
+  {
+    if (loadCount >= maxLoadCount) break;
+
+    const std::shared_ptr<kdr::Stream::TextureAsset>& asset = assets[request.second];
+    const kdr::Graphics::Texture& texture = *asset->texture;
+    const bool isFirstLoad = asset->definedLevel == texture.getLevelCount();
+
+    // A new texture gets its whole tail in one go, so it is drawable after a single round trip
+    const GLsizei level = isFirstLoad ? std::max(asset->wantedLevel, getTailLevel(texture)) : asset->definedLevel - 1;
+    GLsizeiptr size {0};
+    for (GLsizei i = level; i < asset->definedLevel; i++)
+    {
+      size += texture.getLevelSize(i);
+    }
+
+    // First loads go ahead regardless of the budget, which the next frame then restores
+    if (!isFirstLoad && !_makeRoom(size, request.first, asset.get())) continue;
+
+    _load(asset, level);
+  }
+}
+
+void kdr::Stream::TextureResidency::Delete()
+{
+  {
+    std::lock_guard<std::mutex> lock(openedMutex);
+    for (const std::shared_ptr<kdr::Stream::TextureAsset>& asset : openedAssets)
+    {
+      streamer.finish(*asset, false);
+    }
+    openedAssets.clear();
+  }
+
+  for (const std::shared_ptr<kdr::Stream::TextureAsset>& asset : assets)
+  {
+    if (!asset->getIsDone())
+    {
+      streamer.finish(*asset, false);
+    }
+    asset->texture->Delete();
+    delete asset->texture;
+    asset->texture = NULL;
+  }
+  assets.clear();
+  memorySize = 0;
+  loadCount = 0;
+}
+
+void kdr::Stream::TextureResidency::_adoptOpened()
+{
+  std::vector<std::shared_ptr<kdr::Stream::TextureAsset>> opened;
+  {
+    std::lock_guard<std::mutex> lock(openedMutex);
+    opened.swap(openedAssets);
+  }
+
+  for (const std::shared_ptr<kdr::Stream::TextureAsset>& asset : opened)
+  {
+    const kdr::Graphics::TextureFile& file = *asset->file;
+    if (!kdr::Graphics::isTextureFormatSupported(file.getFormat()))
+    {
+      std::cerr << "Failed to stream the texture: its format is not supported by the OpenGL context!\n";
+      asset->file.reset();
+      streamer.finish(*asset, false);
+      continue;
+    }
+
+    if (file.getIsArray())
+    {
+      asset->texture = new kdr::Graphics::TextureArray(file.getFormat(), file.getWidth(), file.getHeight(), file.getLayerCount(), file.getLevelCount());
+    }
+    else
+    {
+      asset->texture = new kdr::Graphics::Texture2D(file.getFormat(), file.getWidth(), file.getHeight(), file.getLevelCount());
+    }
+    asset->definedLevel = asset->texture->getLevelCount();
+    assets.push_back(asset);
+  }
+}
+
+void kdr::Stream::TextureResidency::_evict(kdr::Stream::TextureAsset& asset)
+{
+  memorySize -= asset.texture->getLevelSize(asset.definedLevel);
+  asset.texture->Release(asset.definedLevel);
+  asset.definedLevel++;
+}
+
+bool kdr::Stream::TextureResidency::_makeRoom(const GLsizeiptr size, const float priority, const kdr::Stream::TextureAsset* except)
+{
+  while (memorySize + size > budget)
+  {
+    // Only detail a texture doesn't want anyway is given up for another one
+    kdr::Stream::TextureAsset* victim {NULL};
+    float victimPriority {priority};
+    for (const std::shared_ptr<kdr::Stream::TextureAsset>& asset : assets)
+    {
+      if (asset.get() == except || asset->isLoading || asset->definedLevel >= asset->wantedLevel) continue;
+
+      const float assetPriority = getPriority(*asset, asset->definedLevel);
+      if (assetPriority < victimPriority)
+      {
+        victim = asset.get();
+        victimPriority = assetPriority;
+      }
+    }
+    if (victim == NULL) return false;
+
+    _evict(*victim);
+  }
+  return true;
+}
+
+void kdr::Stream::TextureResidency::_load(const std::shared_ptr<kdr::Stream::TextureAsset>& asset, const GLsizei level)
+{
+  kdr::Graphics::Texture* texture = asset->texture;
+  const GLsizei coarsest = asset->definedLevel - 1;
+  for (GLsizei i = coarsest; i >= level; i--)
+  {
+    texture->Define(i);
+    memorySize += texture->getLevelSize(i);
+  }
+  asset->definedLevel = level;
+  asset->isLoading = true;
+  loadCount++;
+
+  std::shared_ptr<kdr::Graphics::TextureFile> file = asset->file;
+  streamer.read([this, asset, file, texture, coarsest, level]()
+  {
+    const GLsizei layerCount = texture->getLayerCount();
+    for (GLsizei i = coarsest; i >= level; i--)
+    {
+      for (GLsizei layer = 0; layer < layerCount; layer++)
+      {
+        kdr::File::touchPages(file->getData(i, layer), (size_t)file->getImageSize(i));
+      }
+    }
+
+    // One upload per layer of every level, coarsest level first, each cut into whole block rows
+    for (GLsizei i = coarsest; i >= level; i--)
+    {
+      for (GLsizei layer = 0; layer < layerCount; layer++)
+      {
+        kdr::Stream::Upload upload;
+        upload.data = file->getData(i, layer);
+        upload.size = file->getImageSize(i);
+        upload.granularity = file->getFormat().getRowSize(file->getLevelWidth(i));
+        upload.owner = file;
+        upload.write = [texture, i, layer](GLuint stagingID, GLintptr stagingOffset, GLsizeiptr offset, GLsizeiptr size)
+        {
+          const kdr::Graphics::TextureFormat& format = texture->getFormat();
+          const GLsizeiptr rowSize = format.getRowSize(texture->getLevelWidth(i));
+          const GLsizei levelHeight = texture->getLevelHeight(i);
+          const GLsizei y = (GLsizei)(offset / rowSize) * (GLsizei)format.blockSize;
+          const GLsizei height = std::min((GLsizei)(size / rowSize) * (GLsizei)format.blockSize, levelHeight - y);
+
+          kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+          stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingID);
+          texture->Upload(i, layer, y, height, (const void*)stagingOffset, size);
+          stateCache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        };
+
+        if (layer + 1 < layerCount)
+        {
+          upload.end = [asset](bool isSuccessful)
+          {
+            if (!isSuccessful) asset->isFailed = true;
+          };
+          streamer.queue(upload);
+          continue;
+        }
+
+        // The last layer completes the level, which can then be sampled
+        upload.end = [this, asset, i, level](bool isSuccessful)
+        {
+          if (!isSuccessful) asset->isFailed = true;
+          if (!asset->isFailed)
+          {
+            asset->texture->setBaseLevel(i);
+            if (!asset->getIsDone()) streamer.finish(*asset, true);
+          }
+          if (i > level) return;
+
+          asset->isLoading = false;
+          loadCount--;
+          if (asset->isFailed)
+          {
+            // Levels that never got their data must not be sampled
+            while (asset->definedLevel < asset->texture->getBaseLevel())
+            {
+              _evict(*asset);
+            }
+            if (!asset->getIsDone()) streamer.finish(*asset, false);
+          }
+        };
+        streamer.queue(upload);
+      }
+    }
+  });
+}
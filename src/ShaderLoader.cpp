@@ -0,0 +1,74 @@
+#include "Kedarium/ShaderLoader.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "Kedarium/Jobs.hpp"
+
+size_t kdr::Graphics::ShaderLoader::add(const std::string& vertexPath, const std::string& fragmentPath)
+{
+  queued.push_back({vertexPath, fragmentPath});
+  return queued.size() - 1;
+}
+
+std::vector<kdr::Graphics::Shader> kdr::Graphics::ShaderLoader::load()
+{
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  stats = kdr::Graphics::ShaderLoaderStats();
+  stats.programCount = queued.size();
+
+  std::vector<kdr::Graphics::Shader> shaders;
+  if (queued.empty()) return shaders;
+  shaders.reserve(queued.size());
+
+  if (getIsParallelCompileSupported())
+  {
+    // Letting the driver pick as many compiler threads as it wants
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+
+  std::vector<kdr::Graphics::ShaderSource> sources(queued.size());
+  std::vector<char>                        isRead(queued.size(), 0);
+  std::mutex                               mutex;
+  std::condition_variable                  condition;
+  double                                   readSeconds {0.};
+
+  kdr::Jobs::Scheduler& scheduler = kdr::Jobs::getScheduler();
+  kdr::Jobs::Counter    counter;
+  for (size_t i = 0; i < queued.size(); i++)
+  {
+    scheduler.run([&, i]()
+    {
+      kdr::Graphics::ShaderSource source = kdr::Graphics::readShaderSource(queued[i].first, queued[i].second);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      sources[i] = std::move(source);
+      isRead[i] = 1;
+      readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      condition.notify_one();
+    }, &counter);
+  }
+
+  // Submitting in order as sources arrive, so the driver starts compiling while files are still read
+  for (size_t i = 0; i < queued.size(); i++)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [&]() { return isRead[i] != 0; });
+    }
+
+    const std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+    shaders.emplace_back(sources[i], true);
+    stats.submitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submitStart).count();
+
+    sources[i] = kdr::Graphics::ShaderSource();
+  }
+
+  scheduler.wait(counter);
+
+  stats.readSeconds = readSeconds;
+  queued.clear();
+  return shaders;
+}
@@ -1,5 +1,109 @@
 #include "Kedarium/Space.hpp"
 
+#if defined(__AVX2__) && defined(__FMA__)
+  #define KDR_SPACE_AVX2
+  #include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define KDR_SPACE_SSE
+  #include <emmintrin.h>
+#endif
+
+#if defined(KDR_SPACE_SSE)
+static inline __m128 loadVec3(const kdr::Space::Vec3& vector)
+{
+  return _mm_setr_ps(vector.x, vector.y, vector.z, 0.f);
+}
+
+static inline void storeVec3(kdr::Space::Vec3& vector, const __m128 value)
+{
+  _mm_storel_pi((__m64*)&vector.x, value);
+  _mm_store_ss(&vector.z, _mm_movehl_ps(value, value));
+}
+
+static inline __m128 dot3(const __m128 a, const __m128 b)
+{
+  __m128 product = _mm_mul_ps(a, b);
+  __m128 yx = _mm_shuffle_ps(product, product, _MM_SHUFFLE(3, 0, 0, 1));
+  __m128 zx = _mm_shuffle_ps(product, product, _MM_SHUFFLE(3, 0, 0, 2));
+  __m128 sum = _mm_add_ss(_mm_add_ss(product, yx), zx);
+  return _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+static inline __m128 cross3(const __m128 a, const __m128 b)
+{
+  __m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 result = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+  return _mm_shuffle_ps(result, result, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+static inline __m128 normalize3(const __m128 vector)
+{
+  __m128 length = _mm_sqrt_ps(dot3(vector, vector));
+  __m128 mask = _mm_cmpgt_ps(length, _mm_setzero_ps());
+  return _mm_and_ps(_mm_div_ps(vector, length), mask);
+}
+#endif
+
+static inline void multiplyMat4(const float* a, const float* b, float* out)
+{
+#if defined(KDR_SPACE_AVX2)
+  __m256 a0 = _mm256_broadcast_ps((const __m128*)(a + 0));
+  __m256 a1 = _mm256_broadcast_ps((const __m128*)(a + 4));
+  __m256 a2 = _mm256_broadcast_ps((const __m128*)(a + 8));
+  __m256 a3 = _mm256_broadcast_ps((const __m128*)(a + 12));
+  for (int i = 0; i < 4; i += 2)
+  {
+    const float* left  = b + i * 4;
+    const float* right = b + i * 4 + 4;
+    __m256 column = _mm256_mul_ps(a0, _mm256_set_m128(_mm_set1_ps(right[0]), _mm_set1_ps(left[0])));
+    column = _mm256_fmadd_ps(a1, _mm256_set_m128(_mm_set1_ps(right[1]), _mm_set1_ps(left[1])), column);
+    column = _mm256_fmadd_ps(a2, _mm256_set_m128(_mm_set1_ps(right[2]), _mm_set1_ps(left[2])), column);
+    column = _mm256_fmadd_ps(a3, _mm256_set_m128(_mm_set1_ps(right[3]), _mm_set1_ps(left[3])), column);
+    _mm256_storeu_ps(out + i * 4, column);
+  }
+#elif defined(KDR_SPACE_SSE)
+  __m128 a0 = _mm_load_ps(a + 0);
+  __m128 a1 = _mm_load_ps(a + 4);
+  __m128 a2 = _mm_load_ps(a + 8);
+  __m128 a3 = _mm_load_ps(a + 12);
+  for (int i = 0; i < 4; i++)
+  {
+    const float* column = b + i * 4;
+    __m128 result = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+    result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+    result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+    result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+    _mm_store_ps(out + i * 4, result);
+  }
+#else
+  float result[16];
+  for (int i = 0; i < 4; i++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      result[i * 4 + j] =
+        b[i * 4 + 0] * a[0 * 4 + j] +
+        b[i * 4 + 1] * a[1 * 4 + j] +
+        b[i * 4 + 2] * a[2 * 4 + j] +
+        b[i * 4 + 3] * a[3 * 4 + j];
+    }
+  }
+  for (int i = 0; i < 16; i++)
+  {
+    out[i] = result[i];
+  }
+#endif
+}
+
+kdr::Space::Mat4 kdr::Space::Mat4::operator*(const kdr::Space::Mat4& other) const
+{
+  kdr::Space::Mat4 result;
+  multiplyMat4(&elements[0][0], &other.elements[0][0], &result.elements[0][0]);
+  return result;
+}
+
 kdr::Space::Vec3 kdr::Space::normalize(const kdr::Space::Vec3& vector)
 {
   float length = std::sqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z);
@@ -25,28 +129,67 @@ float kdr::Space::dot(const kdr::Space::Vec3& a, const kdr::Space::Vec3& b)
 kdr::Space::Mat4 kdr::Space::translate(const kdr::Space::Mat4& mat, const kdr::Space::Vec3& vec)
 {
   kdr::Space::Mat4 result {mat};
+#if defined(KDR_SPACE_SSE)
+  _mm_store_ps(result[3], _mm_add_ps(_mm_load_ps(mat[3]), loadVec3(vec)));
+#else
   result[3][0] += vec.x;
   result[3][1] += vec.y;
   result[3][2] += vec.z;
+#endif
   return result;
 }
 
 kdr::Space::Mat4 kdr::Space::perspective(const float fov, const float aspect, const float near, const float far)
 {
-  kdr::Space::Mat4 result {0.f};
+  kdr::Space::Mat4 result;
   float tanHalfFov = tanf(fov / 2.f);
 
+#if defined(KDR_SPACE_SSE)
+  _mm_store_ps(result[0], _mm_setr_ps(1.f / (tanHalfFov * aspect), 0.f, 0.f, 0.f));
+  _mm_store_ps(result[1], _mm_setr_ps(0.f, 1.f / tanHalfFov, 0.f, 0.f));
+  _mm_store_ps(result[2], _mm_setr_ps(0.f, 0.f, (far + near) / (near - far), -1.f));
+  _mm_store_ps(result[3], _mm_setr_ps(0.f, 0.f, -(2.f * far * near) / (far - near), 0.f));
+#else
   result[0][0] = 1.f / (tanHalfFov * aspect);
   result[1][1] = 1.f / tanHalfFov;
   result[2][2] = (far + near) / (near - far);
   result[2][3] = -1.f;
   result[3][2] = -(2.f * far * near ) / (far - near);
+#endif
 
   return result;
 }
 
 kdr::Space::Mat4 kdr::Space::lookAt(const kdr::Space::Vec3& eye, const kdr::Space::Vec3& target, const kdr::Space::Vec3& up)
 {
+#if defined(KDR_SPACE_SSE)
+  __m128 eyeV   = loadVec3(eye);
+  __m128 front  = normalize3(_mm_sub_ps(eyeV, loadVec3(target)));
+  __m128 right  = normalize3(cross3(loadVec3(up), front));
+  __m128 newUp  = cross3(front, right);
+
+  // Transposing the basis vectors into the upper 3x3 block
+  __m128 translation = _mm_setzero_ps();
+  __m128 column0 = right;
+  __m128 column1 = newUp;
+  __m128 column2 = front;
+  __m128 column3 = translation;
+  _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+
+  translation = _mm_setr_ps(
+    -_mm_cvtss_f32(dot3(right, eyeV)),
+    -_mm_cvtss_f32(dot3(newUp, eyeV)),
+    -_mm_cvtss_f32(dot3(front, eyeV)),
+    1.f
+  );
+
+  kdr::Space::Mat4 viewMatrix;
+  _mm_store_ps(viewMatrix[0], column0);
+  _mm_store_ps(viewMatrix[1], column1);
+  _mm_store_ps(viewMatrix[2], column2);
+  _mm_store_ps(viewMatrix[3], translation);
+  return viewMatrix;
+#else
   kdr::Space::Vec3 front = kdr::Space::normalize(eye - target);
   kdr::Space::Vec3 right = kdr::Space::normalize(kdr::Space::cross(up, front));
   kdr::Space::Vec3 newUp = kdr::Space::cross(front, right);
@@ -66,4 +209,92 @@ kdr::Space::Mat4 kdr::Space::lookAt(const kdr::Space::Vec3& eye, const kdr::Spac
   viewMatrix[3][2] = -kdr::Space::dot(front, eye);
   viewMatrix[3][3] = 1.f;
   return viewMatrix;
+#endif
+}
+
+kdr::Space::Mat4 kdr::Space::compose(const kdr::Space::Vec3& position, const kdr::Space::Vec3& rotation, const kdr::Space::Vec3& scale)
+{
+  const float cp = cosf(kdr::Space::radians(rotation.x));
+  const float sp = sinf(kdr::Space::radians(rotation.x));
+  const float cy = cosf(kdr::Space::radians(rotation.y));
+  const float sy = sinf(kdr::Space::radians(rotation.y));
+  const float cr = cosf(kdr::Space::radians(rotation.z));
+  const float sr = sinf(kdr::Space::radians(rotation.z));
+
+  kdr::Space::Mat4 result;
+  result[0][0] = (cy * cr + sy * sp * sr) * scale.x;
+  result[0][1] = (cp * sr) * scale.x;
+  result[0][2] = (cy * sp * sr - sy * cr) * scale.x;
+  result[1][0] = (sy * sp * cr - cy * sr) * scale.y;
+  result[1][1] = (cp * cr) * scale.y;
+  result[1][2] = (sy * sr + cy * sp * cr) * scale.y;
+  result[2][0] = (sy * cp) * scale.z;
+  result[2][1] = (-sp) * scale.z;
+  result[2][2] = (cy * cp) * scale.z;
+  result[3][0] = position.x;
+  result[3][1] = position.y;
+  result[3][2] = position.z;
+  result[3][3] = 1.f;
+  return result;
+}
+
+void kdr::Space::multiplyMany(const kdr::Space::Mat4* a, const kdr::Space::Mat4* b, kdr::Space::Mat4* out, const size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    multiplyMat4(&a[i].elements[0][0], &b[i].elements[0][0], &out[i].elements[0][0]);
+  }
+}
+
+void kdr::Space::transformPoints(const kdr::Space::Mat4& mat, const kdr::Space::Vec3* in, kdr::Space::Vec3* out, const size_t n)
+{
+  size_t i = 0;
+#if defined(KDR_SPACE_AVX2)
+  __m256 c0 = _mm256_broadcast_ps((const __m128*)mat[0]);
+  __m256 c1 = _mm256_broadcast_ps((const __m128*)mat[1]);
+  __m256 c2 = _mm256_broadcast_ps((const __m128*)mat[2]);
+  __m256 c3 = _mm256_broadcast_ps((const __m128*)mat[3]);
+  for (; i + 2 <= n; i += 2)
+  {
+    const kdr::Space::Vec3& p0 = in[i];
+    const kdr::Space::Vec3& p1 = in[i + 1];
+    __m256 result = _mm256_fmadd_ps(c0, _mm256_set_m128(_mm_set1_ps(p1.x), _mm_set1_ps(p0.x)), c3);
+    result = _mm256_fmadd_ps(c1, _mm256_set_m128(_mm_set1_ps(p1.y), _mm_set1_ps(p0.y)), result);
+    result = _mm256_fmadd_ps(c2, _mm256_set_m128(_mm_set1_ps(p1.z), _mm_set1_ps(p0.z)), result);
+    storeVec3(out[i], _mm256_castps256_ps128(result));
+    storeVec3(out[i + 1], _mm256_extractf128_ps(result, 1));
+  }
+#endif
+#if defined(KDR_SPACE_SSE)
+  __m128 m0 = _mm_load_ps(mat[0]);
+  __m128 m1 = _mm_load_ps(mat[1]);
+  __m128 m2 = _mm_load_ps(mat[2]);
+  __m128 m3 = _mm_load_ps(mat[3]);
+  for (; i < n; i++)
+  {
+    __m128 result = _mm_add_ps(m3, _mm_mul_ps(m0, _mm_set1_ps(in[i].x)));
+    result = _mm_add_ps(result, _mm_mul_ps(m1, _mm_set1_ps(in[i].y)));
+    result = _mm_add_ps(result, _mm_mul_ps(m2, _mm_set1_ps(in[i].z)));
+    storeVec3(out[i], result);
+  }
+#else
+  for (; i < n; i++)
+  {
+    const kdr::Space::Vec3 point = in[i];
+    out[i].x = mat[0][0] * point.x + mat[1][0] * point.y + mat[2][0] * point.z + mat[3][0];
+    out[i].y = mat[0][1] * point.x + mat[1][1] * point.y + mat[2][1] * point.z + mat[3][1];
+    out[i].z = mat[0][2] * point.x + mat[1][2] * point.y + mat[2][2] * point.z + mat[3][2];
+  }
+#endif
+}
+
+const char* kdr::Space::getSimdPath()
+{
+#if defined(KDR_SPACE_AVX2)
+  return "avx2";
+#elif defined(KDR_SPACE_SSE)
+  return "sse";
+#else
+  return "scalar";
+#endif
 }
@@ -0,0 +1,210 @@
+#include "Kedarium/StateCache.hpp"
+
+kdr::Graphics::GLStateCache& kdr::Graphics::getStateCache()
+{
+  static kdr::Graphics::GLStateCache stateCache;
+  return stateCache;
+}
+
+void kdr::Graphics::GLStateCache::useProgram(const GLuint program)
+{
+  if (!_count(program != this->program)) return;
+  glUseProgram(program);
+  this->program = program;
+}
+
+void kdr::Graphics::GLStateCache::bindBuffer(const GLenum target, const GLuint buffer)
+{
+  const int slot = _getBufferSlot(target);
+  if (slot == BufferSlotCount)
+  {
+    _count(true);
+    glBindBuffer(target, buffer);
+    return;
+  }
+
+  if (!_count(buffer != buffers[slot])) return;
+  glBindBuffer(target, buffer);
+  buffers[slot] = buffer;
+}
+
+void kdr::Graphics::GLStateCache::bindBufferBase(const GLenum target, const GLuint index, const GLuint buffer)
+{
+  _count(true);
+  glBindBufferBase(target, index, buffer);
+
+  const int slot = _getBufferSlot(target);
+  if (slot != BufferSlotCount)
+  {
+    buffers[slot] = buffer;
+  }
+}
+
+void kdr::Graphics::GLStateCache::bindVertexArray(const GLuint vertexArray)
+{
+  if (!_count(vertexArray != this->vertexArray)) return;
+  glBindVertexArray(vertexArray);
+  this->vertexArray = vertexArray;
+
+  // The element array binding belongs to the VAO, so it's unknown after a switch
+  buffers[ElementArrayBufferSlot] = Unknown;
+}
+
+void kdr::Graphics::GLStateCache::bindTexture(const GLuint unit, const GLenum target, const GLuint texture)
+{
+  // The unit is made active even when the binding is elided, as texture edits go to the active unit
+  if (unit != textureUnit)
+  {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    textureUnit = unit;
+  }
+
+  const int slot = _getTextureSlot(target);
+  if (slot != TextureSlotCount && unit < TextureUnitCount)
+  {
+    if (!_count(texture != textures[unit][slot])) return;
+    textures[unit][slot] = texture;
+  }
+  else
+  {
+    _count(true);
+  }
+  glBindTexture(target, texture);
+}
+
+void kdr::Graphics::GLStateCache::setPolygonMode(const GLenum mode)
+{
+  if (!_count(mode != polygonMode)) return;
+  glPolygonMode(GL_FRONT_AND_BACK, mode);
+  polygonMode = mode;
+}
+
+void kdr::Graphics::GLStateCache::setDepthTest(const bool enabled)
+{
+  if (!_count((int)enabled != depthTest)) return;
+  enabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+  depthTest = enabled;
+}
+
+void kdr::Graphics::GLStateCache::setDepthMask(const bool enabled)
+{
+  if (!_count((int)enabled != depthMask)) return;
+  glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+  depthMask = enabled;
+}
+
+void kdr::Graphics::GLStateCache::setDepthFunc(const GLenum function)
+{
+  if (!_count(function != depthFunc)) return;
+  glDepthFunc(function);
+  depthFunc = function;
+}
+
+void kdr::Graphics::GLStateCache::setBlend(const bool enabled)
+{
+  if (!_count((int)enabled != blend)) return;
+  enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+  blend = enabled;
+}
+
+void kdr::Graphics::GLStateCache::setBlendFunc(const GLenum source, const GLenum destination)
+{
+  if (!_count(source != blendSource || destination != blendDestination)) return;
+  glBlendFunc(source, destination);
+  blendSource = source;
+  blendDestination = destination;
+}
+
+void kdr::Graphics::GLStateCache::onProgramDeleted(const GLuint program)
+{
+  if (this->program == program)
+  {
+    this->program = Unknown;
+  }
+}
+
+void kdr::Graphics::GLStateCache::onBufferDeleted(const GLuint buffer)
+{
+  for (int i = 0; i < BufferSlotCount; i++)
+  {
+    if (buffers[i] == buffer)
+    {
+      buffers[i] = 0;
+    }
+  }
+}
+
+void kdr::Graphics::GLStateCache::onVertexArrayDeleted(const GLuint vertexArray)
+{
+  if (this->vertexArray == vertexArray)
+  {
+    this->vertexArray = 0;
+    buffers[ElementArrayBufferSlot] = Unknown;
+  }
+}
+
+void kdr::Graphics::GLStateCache::onTextureDeleted(const GLuint texture)
+{
+  for (GLuint unit = 0; unit < TextureUnitCount; unit++)
+  {
+    for (int i = 0; i < TextureSlotCount; i++)
+    {
+      if (textures[unit][i] == texture)
+      {
+        textures[unit][i] = 0;
+      }
+    }
+  }
+}
+
+void kdr::Graphics::GLStateCache::invalidate()
+{
+  program     = Unknown;
+  vertexArray = Unknown;
+  for (int i = 0; i < BufferSlotCount; i++)
+  {
+    buffers[i] = Unknown;
+  }
+  textureUnit = Unknown;
+  for (GLuint unit = 0; unit < TextureUnitCount; unit++)
+  {
+    for (int i = 0; i < TextureSlotCount; i++)
+    {
+      textures[unit][i] = Unknown;
+    }
+  }
+
+  polygonMode      = Unknown;
+  depthFunc        = Unknown;
+  blendSource      = Unknown;
+  blendDestination = Unknown;
+  depthTest        = -1;
+  depthMask        = -1;
+  blend            = -1;
+}
+
+int kdr::Graphics::GLStateCache::_getBufferSlot(const GLenum target)
+{
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER:         return ArrayBufferSlot;
+    case GL_ELEMENT_ARRAY_BUFFER: return ElementArrayBufferSlot;
+    case GL_COPY_READ_BUFFER:     return CopyReadBufferSlot;
+    case GL_COPY_WRITE_BUFFER:    return CopyWriteBufferSlot;
+    case GL_UNIFORM_BUFFER:       return UniformBufferSlot;
+    case GL_PIXEL_PACK_BUFFER:    return PixelPackBufferSlot;
+    case GL_PIXEL_UNPACK_BUFFER:  return PixelUnpackBufferSlot;
+    case GL_DRAW_INDIRECT_BUFFER: return DrawIndirectBufferSlot;
+    default:                      return BufferSlotCount;
+  }
+}
+
+int kdr::Graphics::GLStateCache::_getTextureSlot(const GLenum target)
+{
+  switch (target)
+  {
+    case GL_TEXTURE_2D:       return Texture2DSlot;
+    case GL_TEXTURE_2D_ARRAY: return Texture2DArraySlot;
+    default:                  return TextureSlotCount;
+  }
+}
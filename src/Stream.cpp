@@ -0,0 +1,364 @@
+#include "Kedarium/Stream.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+#include "Kedarium/File.hpp"
+#include "Kedarium/Import.hpp"
+#include "Kedarium/MeshFile.hpp"
+#include "Kedarium/Profiler.hpp"
+
+static void copyBuffer(const GLuint sourceID, const GLintptr sourceOffset, const GLuint targetID, const GLintptr targetOffset, const GLsizeiptr size)
+{
+  kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+  stateCache.bindBuffer(GL_COPY_READ_BUFFER, sourceID);
+  stateCache.bindBuffer(GL_COPY_WRITE_BUFFER, targetID);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, targetOffset, size);
+}
+
+kdr::Stream::Streamer::Streamer(const GLsizeiptr stagingSize)
+: staging(GL_COPY_READ_BUFFER, stagingSize)
+{
+  ioThread = std::thread(&kdr::Stream::Streamer::_runIOThread, this);
+}
+
+kdr::Stream::Streamer::~Streamer()
+{
+  _stopIOThread();
+}
+
+void kdr::Stream::Streamer::setBudget(const double milliseconds, const GLsizeiptr bytes)
+{
+  budgetMilliseconds = milliseconds > 0. ? milliseconds : 0.;
+  budgetBytes = bytes > 0 ? bytes : 0;
+}
+
+std::shared_ptr<kdr::Stream::MeshAsset> kdr::Stream::Streamer::loadMesh(
+  const std::string& path,
+  kdr::Graphics::MeshPool& pool,
+  const unsigned int level
+)
+{
+  std::shared_ptr<kdr::Stream::MeshAsset> asset = std::make_shared<kdr::Stream::MeshAsset>();
+  kdr::Graphics::MeshPool* meshPool = &pool;
+  start();
+
+  const bool isCooked = path.size() >= 6 && path.compare(path.size() - 6, 6, ".kmesh") == 0;
+  if (isCooked)
+  {
+    read([this, asset, path, meshPool, level]()
+    {
+      // Cooked meshes need no decoding, their mapping is uploaded as is
+      std::shared_ptr<kdr::Mesh::CookedMesh> mesh = std::make_shared<kdr::Mesh::CookedMesh>();
+      if (!mesh->open(path.c_str()) || level >= mesh->getLevelCount() || mesh->getVertexStride() != meshPool->getVertexStride())
+      {
+        std::cerr << "Failed to stream the mesh: " << path << "!\n";
+        finish(*asset, false);
+        return;
+      }
+
+      const kdr::Mesh::CookedLevel& cookedLevel = mesh->getLevel(level);
+      kdr::File::touchPages(mesh->getVertices(level), (size_t)cookedLevel.vertexCount * mesh->getVertexStride());
+      kdr::File::touchPages(mesh->getIndices(level), (size_t)cookedLevel.indexCount * sizeof(GLuint));
+      asset->bounds = mesh->getBounds();
+      _queueMesh(asset, *meshPool, mesh, mesh->getVertices(level), cookedLevel.vertexCount, mesh->getIndices(level), cookedLevel.indexCount);
+    });
+    return asset;
+  }
+
+  read([this, asset, path, meshPool]()
+  {
+    {
+      // Pulling the file into the page cache here leaves the importer with CPU work only
+      kdr::File::MappedFile file(path.c_str());
+      kdr::File::touchPages(file.getData(), file.getSize());
+    }
+
+    decode([this, asset, path, meshPool]()
+    {
+      std::shared_ptr<kdr::Import::Model> model = std::make_shared<kdr::Import::Model>();
+      if (meshPool->getVertexStride() != sizeof(kdr::Import::Vertex) || !kdr::Import::loadModel(path.c_str(), *model))
+      {
+        std::cerr << "Failed to stream the mesh: " << path << "!\n";
+        finish(*asset, false);
+        return;
+      }
+
+      asset->bounds = model->bounds;
+      _queueMesh(asset, *meshPool, model, model->vertices.data(), (GLuint)model->vertices.size(), model->indices.data(), (GLuint)model->indices.size());
+    });
+  });
+  return asset;
+}
+
+std::shared_ptr<kdr::Stream::Asset> kdr::Stream::Streamer::writeBuffer(
+  const GLuint bufferID,
+  const GLintptr offset,
+  std::vector<unsigned char> data
+)
+{
+  std::shared_ptr<kdr::Stream::Asset> asset = std::make_shared<kdr::Stream::Asset>();
+  std::shared_ptr<std::vector<unsigned char>> bytes = std::make_shared<std::vector<unsigned char>>(std::move(data));
+  start();
+
+  kdr::Stream::Upload upload;
+  upload.data = bytes->data();
+  upload.size = (GLsizeiptr)bytes->size();
+  upload.owner = bytes;
+  upload.begin = [asset]()
+  {
+    asset->setState(kdr::Stream::Asset::Uploading);
+    return true;
+  };
+  upload.write = [bufferID, offset](GLuint stagingID, GLintptr stagingOffset, GLsizeiptr pieceOffset, GLsizeiptr pieceSize)
+  {
+    copyBuffer(stagingID, stagingOffset, bufferID, offset + pieceOffset, pieceSize);
+  };
+  upload.end = [this, asset](bool isSuccessful)
+  {
+    finish(*asset, isSuccessful);
+  };
+  queue(upload);
+  return asset;
+}
+
+void kdr::Stream::Streamer::read(const std::function<void()>& job)
+{
+  {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    ioJobs.push_back(job);
+  }
+  ioCondition.notify_one();
+}
+
+void kdr::Stream::Streamer::decode(const std::function<void()>& job)
+{
+  kdr::Jobs::getScheduler().run(job, &decodeCounter);
+}
+
+void kdr::Stream::Streamer::queue(const kdr::Stream::Upload& upload)
+{
+  std::lock_guard<std::mutex> lock(uploadMutex);
+  queuedUploads.push_back(upload);
+}
+
+void kdr::Stream::Streamer::finish(kdr::Stream::Asset& asset, const bool isResident)
+{
+  asset.setState(isResident ? kdr::Stream::Asset::Resident : kdr::Stream::Asset::Failed);
+  pendingCount.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void kdr::Stream::Streamer::Update()
+{
+  KDR_PROFILE_SCOPE("Streamer::Update");
+
+  {
+    std::lock_guard<std::mutex> lock(uploadMutex);
+    while (!queuedUploads.empty())
+    {
+      activeUploads.push_back(std::move(queuedUploads.front()));
+      queuedUploads.pop_front();
+    }
+  }
+  uploadedBytes = 0;
+  if (activeUploads.empty()) return;
+
+  staging.BeginFrame();
+  const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  const GLsizeiptr byteLimit = std::min(budgetBytes, staging.getFrameSize());
+  while (!activeUploads.empty())
+  {
+    kdr::Stream::Upload& upload = activeUploads.front();
+    if (!isActiveStarted)
+    {
+      isActiveStarted = true;
+      activeUploaded = 0;
+      if (upload.begin && !upload.begin())
+      {
+        _endActive(false);
+        continue;
+      }
+    }
+
+    // Pieces cover whole units of the upload, and at least one unit goes out every frame
+    const GLsizeiptr remaining = upload.size - activeUploaded;
+    GLsizeiptr size = std::min(remaining, byteLimit - uploadedBytes);
+    if (size < remaining) size -= size % upload.granularity;
+    if (size <= 0 && uploadedBytes == 0) size = std::min(remaining, upload.granularity);
+
+    if (size > 0)
+    {
+      GLintptr stagingOffset {0};
+      void* target = staging.Map(size, stagingOffset);
+      if (target == NULL)
+      {
+        if (uploadedBytes > 0) break;
+
+        std::cerr << "Failed to stream an upload: its pieces do not fit into the staging buffer!\n";
+        _endActive(false);
+        continue;
+      }
+      memcpy(target, upload.data + activeUploaded, size);
+      staging.Unmap();
+      upload.write(staging.getID(), stagingOffset, activeUploaded, size);
+
+      activeUploaded += size;
+      uploadedBytes += size;
+    }
+    else if (remaining > 0)
+    {
+      break;
+    }
+
+    if (activeUploaded == upload.size) _endActive(true);
+
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    if (elapsed >= budgetMilliseconds) break;
+  }
+  staging.EndFrame();
+}
+
+void kdr::Stream::Streamer::Delete(const bool isEnding)
+{
+  // Requests already made still run to completion, so every asset ends up resident or failed
+  _stopIOThread();
+  kdr::Jobs::getScheduler().wait(decodeCounter);
+
+  {
+    std::lock_guard<std::mutex> lock(uploadMutex);
+    while (!queuedUploads.empty())
+    {
+      activeUploads.push_back(std::move(queuedUploads.front()));
+      queuedUploads.pop_front();
+    }
+  }
+  if (!isEnding)
+  {
+    activeUploads.clear();
+    isActiveStarted = false;
+    activeUploaded = 0;
+  }
+  while (!activeUploads.empty())
+  {
+    _endActive(false);
+  }
+  staging.Delete();
+}
+
+void kdr::Stream::Streamer::_runIOThread()
+{
+  while (true)
+  {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(ioMutex);
+      ioCondition.wait(lock, [this]() { return isStopping || !ioJobs.empty(); });
+      if (ioJobs.empty()) return;
+
+      job = std::move(ioJobs.front());
+      ioJobs.pop_front();
+    }
+
+    KDR_PROFILE_SCOPE("Streamer::read");
+    job();
+  }
+}
+
+void kdr::Stream::Streamer::_stopIOThread()
+{
+  if (!ioThread.joinable()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    isStopping = true;
+  }
+  ioCondition.notify_all();
+  ioThread.join();
+}
+
+void kdr::Stream::Streamer::_endActive(const bool isSuccessful)
+{
+  kdr::Stream::Upload upload = std::move(activeUploads.front());
+  activeUploads.pop_front();
+  isActiveStarted = false;
+  activeUploaded = 0;
+
+  if (upload.end) upload.end(isSuccessful);
+}
+
+void kdr::Stream::Streamer::_queueMesh(
+  const std::shared_ptr<kdr::Stream::MeshAsset>& asset,
+  kdr::Graphics::MeshPool& pool,
+  const std::shared_ptr<void>& owner,
+  const void* vertices,
+  const GLuint vertexCount,
+  const GLuint* indices,
+  const GLuint indexCount
+)
+{
+  if (vertexCount == 0 || indexCount == 0)
+  {
+    finish(*asset, false);
+    return;
+  }
+
+  // The destination is looked up for every piece, as the pool may grow or defragment in between
+  kdr::Graphics::MeshPool* meshPool = &pool;
+  const GLsizeiptr vertexStride = pool.getVertexStride();
+
+  kdr::Stream::Upload vertexUpload;
+  vertexUpload.data = (const unsigned char*)vertices;
+  vertexUpload.size = vertexCount * vertexStride;
+  vertexUpload.owner = owner;
+  vertexUpload.begin = [asset, meshPool, vertexCount, indexCount]()
+  {
+    asset->handle = meshPool->Reserve(vertexCount, indexCount);
+    if (asset->handle == kdr::Graphics::invalidMesh) return false;
+
+    asset->setState(kdr::Stream::Asset::Uploading);
+    return true;
+  };
+  vertexUpload.write = [asset, meshPool, vertexStride](GLuint stagingID, GLintptr stagingOffset, GLsizeiptr offset, GLsizeiptr size)
+  {
+    const kdr::Graphics::MeshRange& range = meshPool->getRange(asset->handle);
+    copyBuffer(stagingID, stagingOffset, meshPool->getVertexBufferID(), range.baseVertex * vertexStride + offset, size);
+  };
+
+  kdr::Stream::Upload indexUpload;
+  indexUpload.data = (const unsigned char*)indices;
+  indexUpload.size = indexCount * sizeof(GLuint);
+  indexUpload.owner = owner;
+  indexUpload.begin = [asset]()
+  {
+    return asset->handle != kdr::Graphics::invalidMesh;
+  };
+  indexUpload.write = [asset, meshPool](GLuint stagingID, GLintptr stagingOffset, GLsizeiptr offset, GLsizeiptr size)
+  {
+    const kdr::Graphics::MeshRange& range = meshPool->getRange(asset->handle);
+    copyBuffer(stagingID, stagingOffset, meshPool->getIndexBufferID(), range.firstIndex * sizeof(GLuint) + offset, size);
+  };
+
+  // A failed vertex upload hands the cleanup to the index upload, which then fails at once
+  indexUpload.end = [this, asset, meshPool](bool isSuccessful)
+  {
+    if (!isSuccessful && asset->handle != kdr::Graphics::invalidMesh)
+    {
+      meshPool->Remove(asset->handle);
+      asset->handle = kdr::Graphics::invalidMesh;
+    }
+    finish(*asset, isSuccessful);
+  };
+  vertexUpload.end = [asset, meshPool](bool isSuccessful)
+  {
+    if (!isSuccessful && asset->handle != kdr::Graphics::invalidMesh)
+    {
+      meshPool->Remove(asset->handle);
+      asset->handle = kdr::Graphics::invalidMesh;
+    }
+  };
+
+  queue(vertexUpload);
+  queue(indexUpload);
+}
@@ -0,0 +1,204 @@
+#include "Kedarium/Texture.hpp"
+
+#include <iostream>
+
+#include "Kedarium/Profiler.hpp"
+
+bool kdr::Graphics::isTextureFormatSupported(const kdr::Graphics::TextureFormat& format)
+{
+  switch (format.internalFormat)
+  {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+      return GLEW_EXT_texture_compression_s3tc;
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+      return GLEW_EXT_texture_compression_s3tc && GLEW_EXT_texture_sRGB;
+    case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+      return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+    default:
+      // RGTC and the uncompressed formats are core in OpenGL 3.3
+      return true;
+  }
+}
+
+kdr::Graphics::Texture::Texture(
+  const GLenum target,
+  const kdr::Graphics::TextureFormat& format,
+  const GLsizei width,
+  const GLsizei height,
+  const GLsizei layerCount,
+  const GLsizei levelCount
+) : target(target), format(format), width(width), height(height),
+  layerCount(layerCount > 0 ? layerCount : 1),
+  levelCount(levelCount < 1 ? 1 : (levelCount > 16 ? 16 : levelCount)),
+  baseLevel(this->levelCount)
+{
+  glGenTextures(1, &ID);
+  _bind();
+
+  // With the range fixed up front, the texture is complete as soon as the levels from the base
+  // level down are defined, whichever finer levels are missing
+  glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, this->levelCount - 1);
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, this->levelCount - 1);
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, this->levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+void kdr::Graphics::Texture::Define(const GLsizei level)
+{
+  if (level < 0 || level >= levelCount || getIsDefined(level)) return;
+
+  _specify(level, getLevelWidth(level), getLevelHeight(level), layerCount);
+  definedLevels |= 1u << level;
+  memorySize += getLevelSize(level);
+}
+
+void kdr::Graphics::Texture::Release(const GLsizei level)
+{
+  if (level < 0 || level >= levelCount || !getIsDefined(level)) return;
+
+  if (level >= baseLevel)
+  {
+    setBaseLevel(level + 1);
+  }
+  _specify(level, 0, 0, 0);
+  definedLevels &= ~(1u << level);
+  memorySize -= getLevelSize(level);
+}
+
+void kdr::Graphics::Texture::Upload(
+  const GLsizei level,
+  const GLsizei layer,
+  const GLsizei y,
+  const GLsizei height,
+  const void* data,
+  const GLsizeiptr size
+)
+{
+  KDR_PROFILE_SCOPE("Texture::Upload");
+  _bind();
+
+  const GLsizei levelWidth = getLevelWidth(level);
+  if (target == GL_TEXTURE_2D_ARRAY)
+  {
+    if (format.getIsCompressed())
+    {
+      glCompressedTexSubImage3D(target, level, 0, y, layer, levelWidth, height, 1, format.internalFormat, (GLsizei)size, data);
+    }
+    else
+    {
+      glTexSubImage3D(target, level, 0, y, layer, levelWidth, height, 1, format.format, format.type, data);
+    }
+  }
+  else
+  {
+    if (format.getIsCompressed())
+    {
+      glCompressedTexSubImage2D(target, level, 0, y, levelWidth, height, format.internalFormat, (GLsizei)size, data);
+    }
+    else
+    {
+      glTexSubImage2D(target, level, 0, y, levelWidth, height, format.format, format.type, data);
+    }
+  }
+}
+
+void kdr::Graphics::Texture::setBaseLevel(const GLsizei level)
+{
+  baseLevel = level < 0 ? 0 : (level > levelCount ? levelCount : level);
+
+  _bind();
+  glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, baseLevel < levelCount ? baseLevel : levelCount - 1);
+}
+
+bool kdr::Graphics::Texture::Load(const kdr::Graphics::TextureFile& file)
+{
+  KDR_PROFILE_SCOPE("Texture::Load");
+
+  const bool isMatching =
+    file.getIsOpen() &&
+    file.getFormat().internalFormat == format.internalFormat &&
+    file.getFormat().format == format.format &&
+    file.getWidth() == width &&
+    file.getHeight() == height &&
+    file.getLayerCount() >= layerCount &&
+    file.getLevelCount() >= levelCount;
+  if (!isMatching)
+  {
+    std::cerr << "Failed to load texture: the file does not match the texture!\n";
+    return false;
+  }
+
+  kdr::Graphics::getStateCache().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  for (GLsizei level = levelCount - 1; level >= 0; level--)
+  {
+    Define(level);
+    for (GLsizei layer = 0; layer < layerCount; layer++)
+    {
+      Upload(level, layer, 0, getLevelHeight(level), file.getData(level, layer), file.getImageSize(level));
+    }
+  }
+  setBaseLevel(0);
+  return true;
+}
+
+void kdr::Graphics::Texture::Delete()
+{
+  kdr::Graphics::getStateCache().onTextureDeleted(ID);
+  glDeleteTextures(1, &ID);
+  memorySize = 0;
+  definedLevels = 0;
+}
+
+void kdr::Graphics::Texture::_specify(const GLsizei level, const GLsizei width, const GLsizei height, const GLsizei layerCount)
+{
+  // With a buffer bound, the NULL data pointer would read from its start
+  kdr::Graphics::getStateCache().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  _bind();
+
+  const GLsizei size = (GLsizei)(format.getImageSize(width, height) * layerCount);
+  if (target == GL_TEXTURE_2D_ARRAY)
+  {
+    if (format.getIsCompressed())
+    {
+      glCompressedTexImage3D(target, level, format.internalFormat, width, height, layerCount, 0, size, NULL);
+    }
+    else
+    {
+      glTexImage3D(target, level, format.internalFormat, width, height, layerCount, 0, format.format, format.type, NULL);
+    }
+  }
+  else
+  {
+    if (format.getIsCompressed())
+    {
+      glCompressedTexImage2D(target, level, format.internalFormat, width, height, 0, size, NULL);
+    }
+    else
+    {
+      glTexImage2D(target, level, format.internalFormat, width, height, 0, format.format, format.type, NULL);
+    }
+  }
+}
+
+kdr::Graphics::Texture2D::Texture2D(const kdr::Graphics::TextureFile& file)
+: Texture(GL_TEXTURE_2D, file.getFormat(), file.getWidth(), file.getHeight(), 1, file.getLevelCount())
+{
+  Load(file);
+}
+
+kdr::Graphics::TextureArray::TextureArray(const kdr::Graphics::TextureFile& file)
+: Texture(GL_TEXTURE_2D_ARRAY, file.getFormat(), file.getWidth(), file.getHeight(), file.getLayerCount(), file.getLevelCount())
+{
+  Load(file);
+}
@@ -0,0 +1,359 @@
+#include "Kedarium/TextureFile.hpp"
+
+#include <iostream>
+#include <string.h>
+
+// Leads a KTX2 file
+struct KTX2Header
+{
+  unsigned char identifier[12];
+  uint32_t      vkFormat;
+  uint32_t      typeSize;
+  uint32_t      pixelWidth;
+  uint32_t      pixelHeight;
+  uint32_t      pixelDepth;
+  uint32_t      layerCount;
+  uint32_t      faceCount;
+  uint32_t      levelCount;
+  uint32_t      supercompressionScheme;
+  uint32_t      dfdByteOffset;
+  uint32_t      dfdByteLength;
+  uint32_t      kvdByteOffset;
+  uint32_t      kvdByteLength;
+  uint64_t      sgdByteOffset;
+  uint64_t      sgdByteLength;
+};
+
+// Locates one mip level of a KTX2 file, all of its layers back to back
+struct KTX2Level
+{
+  uint64_t byteOffset;
+  uint64_t byteLength;
+  uint64_t uncompressedByteLength;
+};
+
+// Leads a DDS file, right after the "DDS " magic
+struct DDSHeader
+{
+  uint32_t size;
+  uint32_t flags;
+  uint32_t height;
+  uint32_t width;
+  uint32_t pitchOrLinearSize;
+  uint32_t depth;
+  uint32_t mipMapCount;
+  uint32_t reserved1[11];
+  uint32_t pixelFormatSize;
+  uint32_t pixelFormatFlags;
+  uint32_t fourCC;
+  uint32_t rgbBitCount;
+  uint32_t redMask;
+  uint32_t greenMask;
+  uint32_t blueMask;
+  uint32_t alphaMask;
+  uint32_t caps;
+  uint32_t caps2;
+  uint32_t caps3;
+  uint32_t caps4;
+  uint32_t reserved2;
+};
+
+// Follows the DDS header when its four character code is DX10
+struct DDSHeaderDX10
+{
+  uint32_t dxgiFormat;
+  uint32_t resourceDimension;
+  uint32_t miscFlag;
+  uint32_t arraySize;
+  uint32_t miscFlags2;
+};
+
+// Pairs the Vulkan and DXGI codes of a format with its OpenGL description. 0 marks a code without match
+struct FormatEntry
+{
+  uint32_t                     vkFormat;
+  uint32_t                     dxgiFormat;
+  kdr::Graphics::TextureFormat format;
+};
+
+static const unsigned char ktx2Identifier[12] {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+static const FormatEntry formatEntries[] {
+  {37,  28, {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 1, 4}},
+  {43,  29, {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 1, 4}},
+  {44,  87, {GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, 1, 4}},
+  {50,  91, {GL_SRGB8_ALPHA8, GL_BGRA, GL_UNSIGNED_BYTE, 1, 4}},
+  {131, 0,  {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0, 4, 8}},
+  {132, 0,  {GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, 0, 4, 8}},
+  {133, 71, {GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0, 4, 8}},
+  {134, 72, {GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, 0, 4, 8}},
+  {135, 74, {GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 0, 0, 4, 16}},
+  {136, 75, {GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, 0, 0, 4, 16}},
+  {137, 77, {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 4, 16}},
+  {138, 78, {GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, 0, 4, 16}},
+  {139, 80, {GL_COMPRESSED_RED_RGTC1, 0, 0, 4, 8}},
+  {140, 81, {GL_COMPRESSED_SIGNED_RED_RGTC1, 0, 0, 4, 8}},
+  {141, 83, {GL_COMPRESSED_RG_RGTC2, 0, 0, 4, 16}},
+  {142, 84, {GL_COMPRESSED_SIGNED_RG_RGTC2, 0, 0, 4, 16}},
+  {143, 95, {GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 0, 0, 4, 16}},
+  {144, 96, {GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, 0, 0, 4, 16}},
+  {145, 98, {GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0, 4, 16}},
+  {146, 99, {GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, 0, 4, 16}}
+};
+
+// Packs a four character code the way DDS files store it
+static constexpr uint32_t makeFourCC(const char a, const char b, const char c, const char d)
+{
+  return (uint32_t)(unsigned char)a | (uint32_t)(unsigned char)b << 8 | (uint32_t)(unsigned char)c << 16 | (uint32_t)(unsigned char)d << 24;
+}
+
+static const kdr::Graphics::TextureFormat* findVkFormat(const uint32_t vkFormat)
+{
+  for (const FormatEntry& entry : formatEntries)
+  {
+    if (entry.vkFormat == vkFormat) return &entry.format;
+  }
+  return NULL;
+}
+
+static const kdr::Graphics::TextureFormat* findDxgiFormat(const uint32_t dxgiFormat)
+{
+  if (dxgiFormat == 0) return NULL;
+  for (const FormatEntry& entry : formatEntries)
+  {
+    if (entry.dxgiFormat == dxgiFormat) return &entry.format;
+  }
+  return NULL;
+}
+
+bool kdr::Graphics::TextureFile::open(const char* path)
+{
+  close();
+  if (!file.open(path)) return false;
+
+  const unsigned char* data = file.getData();
+  const size_t size = file.getSize();
+  bool isValid {false};
+  if (size >= sizeof(ktx2Identifier) && memcmp(data, ktx2Identifier, sizeof(ktx2Identifier)) == 0)
+  {
+    isValid = _openKTX2(path);
+  }
+  else if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+  {
+    isValid = _openDDS(path);
+  }
+  else
+  {
+    std::cerr << "Failed to open texture: " << path << " is neither a KTX2 nor a DDS file!\n";
+  }
+
+  if (!isValid) close();
+  return isValid;
+}
+
+void kdr::Graphics::TextureFile::close()
+{
+  file.close();
+  format = kdr::Graphics::TextureFormat();
+  width = 0;
+  height = 0;
+  layerCount = 0;
+  levelCount = 0;
+  isArray = false;
+  images.clear();
+}
+
+bool kdr::Graphics::TextureFile::_openKTX2(const char* path)
+{
+  const unsigned char* data = file.getData();
+  const size_t size = file.getSize();
+
+  KTX2Header header;
+  if (size < sizeof(header))
+  {
+    std::cerr << "Failed to open texture: " << path << " is truncated!\n";
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if (header.pixelDepth > 1 || header.faceCount != 1)
+  {
+    std::cerr << "Failed to open texture: " << path << " is a cube map or volume texture, which is not supported!\n";
+    return false;
+  }
+  if (header.supercompressionScheme != 0)
+  {
+    std::cerr << "Failed to open texture: " << path << " is supercompressed, which is not supported!\n";
+    return false;
+  }
+  const kdr::Graphics::TextureFormat* fileFormat = findVkFormat(header.vkFormat);
+  if (fileFormat == NULL)
+  {
+    std::cerr << "Failed to open texture: " << path << " has the unsupported Vulkan format " << header.vkFormat << "!\n";
+    return false;
+  }
+
+  // A level count of 0 asks for generated mips, which would need the CPU, so only level 0 is used
+  format = *fileFormat;
+  width = (GLsizei)header.pixelWidth;
+  height = (GLsizei)header.pixelHeight;
+  layerCount = header.layerCount > 0 ? (GLsizei)header.layerCount : 1;
+  levelCount = header.levelCount > 0 ? (GLsizei)header.levelCount : 1;
+  isArray = header.layerCount > 0;
+  if (!_validateSize(path)) return false;
+
+  const size_t indexOffset = sizeof(header);
+  if (size < indexOffset + (size_t)levelCount * sizeof(KTX2Level))
+  {
+    std::cerr << "Failed to open texture: " << path << " is truncated!\n";
+    return false;
+  }
+
+  images.resize((size_t)levelCount * layerCount);
+  for (GLsizei level = 0; level < levelCount; level++)
+  {
+    KTX2Level entry;
+    memcpy(&entry, data + indexOffset + level * sizeof(KTX2Level), sizeof(entry));
+
+    const uint64_t imageSize = (uint64_t)getImageSize(level);
+    if (entry.byteLength != imageSize * layerCount || entry.byteOffset > size || entry.byteLength > size - entry.byteOffset)
+    {
+      std::cerr << "Failed to open texture: level " << level << " of " << path << " is out of bounds!\n";
+      return false;
+    }
+    for (GLsizei layer = 0; layer < layerCount; layer++)
+    {
+      images[(size_t)level * layerCount + layer] = data + entry.byteOffset + layer * imageSize;
+    }
+  }
+  return true;
+}
+
+bool kdr::Graphics::TextureFile::_openDDS(const char* path)
+{
+  const unsigned char* data = file.getData();
+  const size_t size = file.getSize();
+
+  DDSHeader header;
+  if (size < 4 + sizeof(header))
+  {
+    std::cerr << "Failed to open texture: " << path << " is truncated!\n";
+    return false;
+  }
+  memcpy(&header, data + 4, sizeof(header));
+  size_t offset = 4 + sizeof(header);
+
+  const uint32_t fourCCFlag {0x4};
+  const uint32_t rgbFlag {0x40};
+  const uint32_t cubeMapCaps {0x200};
+  const uint32_t volumeCaps {0x200000};
+  if (header.size != sizeof(header))
+  {
+    std::cerr << "Failed to open texture: " << path << " is corrupt!\n";
+    return false;
+  }
+  if ((header.caps2 & (cubeMapCaps | volumeCaps)) != 0)
+  {
+    std::cerr << "Failed to open texture: " << path << " is a cube map or volume texture, which is not supported!\n";
+    return false;
+  }
+
+  const kdr::Graphics::TextureFormat* fileFormat {NULL};
+  GLsizei fileLayerCount {1};
+  if ((header.pixelFormatFlags & fourCCFlag) != 0 && header.fourCC == makeFourCC('D', 'X', '1', '0'))
+  {
+    DDSHeaderDX10 extension;
+    if (size < offset + sizeof(extension))
+    {
+      std::cerr << "Failed to open texture: " << path << " is truncated!\n";
+      return false;
+    }
+    memcpy(&extension, data + offset, sizeof(extension));
+    offset += sizeof(extension);
+
+    const uint32_t texture2DDimension {3};
+    const uint32_t cubeMapFlag {0x4};
+    if (extension.resourceDimension != texture2DDimension || (extension.miscFlag & cubeMapFlag) != 0)
+    {
+      std::cerr << "Failed to open texture: " << path << " is not a 2D texture, which is required!\n";
+      return false;
+    }
+    fileFormat = findDxgiFormat(extension.dxgiFormat);
+    fileLayerCount = extension.arraySize > 0 ? (GLsizei)extension.arraySize : 1;
+  }
+  else if ((header.pixelFormatFlags & fourCCFlag) != 0)
+  {
+    switch (header.fourCC)
+    {
+      case makeFourCC('D', 'X', 'T', '1'): fileFormat = findDxgiFormat(71); break;
+      case makeFourCC('D', 'X', 'T', '3'): fileFormat = findDxgiFormat(74); break;
+      case makeFourCC('D', 'X', 'T', '5'): fileFormat = findDxgiFormat(77); break;
+      case makeFourCC('A', 'T', 'I', '1'):
+      case makeFourCC('B', 'C', '4', 'U'): fileFormat = findDxgiFormat(80); break;
+      case makeFourCC('B', 'C', '4', 'S'): fileFormat = findDxgiFormat(81); break;
+      case makeFourCC('A', 'T', 'I', '2'):
+      case makeFourCC('B', 'C', '5', 'U'): fileFormat = findDxgiFormat(83); break;
+      case makeFourCC('B', 'C', '5', 'S'): fileFormat = findDxgiFormat(84); break;
+      default: break;
+    }
+  }
+  else if ((header.pixelFormatFlags & rgbFlag) != 0 && header.rgbBitCount == 32 && header.greenMask == 0xFF00)
+  {
+    if (header.redMask == 0xFF && header.blueMask == 0xFF0000) fileFormat = findDxgiFormat(28);
+    if (header.redMask == 0xFF0000 && header.blueMask == 0xFF) fileFormat = findDxgiFormat(87);
+  }
+  if (fileFormat == NULL)
+  {
+    std::cerr << "Failed to open texture: " << path << " has an unsupported pixel format!\n";
+    return false;
+  }
+
+  format = *fileFormat;
+  width = (GLsizei)header.width;
+  height = (GLsizei)header.height;
+  layerCount = fileLayerCount;
+  levelCount = header.mipMapCount > 0 ? (GLsizei)header.mipMapCount : 1;
+  isArray = fileLayerCount > 1;
+  if (!_validateSize(path)) return false;
+
+  // Unlike KTX2, every layer stores its whole mip chain before the next layer begins
+  images.resize((size_t)levelCount * layerCount);
+  for (GLsizei layer = 0; layer < layerCount; layer++)
+  {
+    for (GLsizei level = 0; level < levelCount; level++)
+    {
+      const size_t imageSize = (size_t)getImageSize(level);
+      if (imageSize > size - offset)
+      {
+        std::cerr << "Failed to open texture: level " << level << " of " << path << " is out of bounds!\n";
+        return false;
+      }
+      images[(size_t)level * layerCount + layer] = data + offset;
+      offset += imageSize;
+    }
+  }
+  return true;
+}
+
+bool kdr::Graphics::TextureFile::_validateSize(const char* path) const
+{
+  const GLsizei maxSize {16384};
+  const GLsizei maxLayerCount {2048};
+  if (width <= 0 || height <= 0 || width > maxSize || height > maxSize || layerCount > maxLayerCount)
+  {
+    std::cerr << "Failed to open texture: " << path << " is " << width << "x" << height << " with " << layerCount << " layers, which is not supported!\n";
+    return false;
+  }
+
+  GLsizei chainLength {1};
+  for (GLsizei size = width > height ? width : height; size > 1; size >>= 1)
+  {
+    chainLength++;
+  }
+  if (levelCount > chainLength)
+  {
+    std::cerr << "Failed to open texture: " << path << " has more mip levels than its size allows!\n";
+    return false;
+  }
+  return true;
+}
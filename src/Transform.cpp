@@ -0,0 +1,103 @@
+#include "Kedarium/Transform.hpp"
+
+#include "Kedarium/Jobs.hpp"
+
+// Below this many transforms, a job costs more than it saves
+constexpr size_t MIN_TRANSFORMS_PER_JOB {4096};
+
+void kdr::Space::TransformStore::reserve(const size_t capacity)
+{
+  positions.reserve(capacity);
+  rotations.reserve(capacity);
+  scales.reserve(capacity);
+  parents.reserve(capacity);
+  localMatrices.reserve(capacity);
+  worldMatrices.reserve(capacity);
+  flags.reserve(capacity);
+}
+
+uint32_t kdr::Space::TransformStore::create(
+  const kdr::Space::Vec3& position,
+  const kdr::Space::Vec3& rotation,
+  const kdr::Space::Vec3& scale,
+  const uint32_t parent
+)
+{
+  if (parent != None && parent >= parents.size())
+  {
+    std::cerr << "Failed to create a transform with an invalid parent (" << parent << ")!\n";
+    return None;
+  }
+
+  positions.push_back(position);
+  rotations.push_back(rotation);
+  scales.push_back(scale);
+  parents.push_back(parent);
+  localMatrices.push_back(kdr::Space::Mat4 {1.f});
+  worldMatrices.push_back(kdr::Space::Mat4 {1.f});
+  flags.push_back(LocalDirty);
+
+  return (uint32_t)(parents.size() - 1);
+}
+
+void kdr::Space::TransformStore::clear()
+{
+  positions.clear();
+  rotations.clear();
+  scales.clear();
+  parents.clear();
+  localMatrices.clear();
+  worldMatrices.clear();
+  flags.clear();
+}
+
+void kdr::Space::TransformStore::update()
+{
+  const size_t size = parents.size();
+
+  size_t grainSize = MIN_TRANSFORMS_PER_JOB;
+  if (threadCount > 0 && (size + threadCount - 1) / threadCount > grainSize)
+  {
+    grainSize = (size + threadCount - 1) / threadCount;
+  }
+
+  kdr::Jobs::parallelFor(0, size, grainSize, [this](size_t begin, size_t end)
+  {
+    _updateLocalMatrices(begin, end);
+  });
+
+  _updateWorldMatrices();
+}
+
+void kdr::Space::TransformStore::_updateLocalMatrices(const size_t begin, const size_t end)
+{
+  for (size_t i = begin; i < end; i++)
+  {
+    if (flags[i] & LocalDirty)
+    {
+      localMatrices[i] = kdr::Space::compose(positions[i], rotations[i], scales[i]);
+    }
+  }
+}
+
+void kdr::Space::TransformStore::_updateWorldMatrices()
+{
+  const size_t size = parents.size();
+  for (size_t i = 0; i < size; i++)
+  {
+    const uint32_t parent = parents[i];
+    const bool parentChanged = parent != None && (flags[parent] & WorldChanged);
+
+    if ((flags[i] & LocalDirty) || parentChanged)
+    {
+      worldMatrices[i] = parent == None
+        ? localMatrices[i]
+        : worldMatrices[parent] * localMatrices[i];
+      flags[i] = WorldChanged;
+    }
+    else
+    {
+      flags[i] = 0;
+    }
+  }
+}
@@ -1,5 +1,9 @@
 #include "Kedarium/Window.hpp"
 
+#include <math.h>
+#include <stdlib.h>
+#include <thread>
+
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
   kdr::Window* appWindow = (kdr::Window*)glfwGetWindowUserPointer(window);
@@ -9,15 +13,88 @@ void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 
 kdr::Window::~Window()
 {
+  if (cameraBuffer != NULL)
+  {
+    cameraBuffer->Delete();
+    delete cameraBuffer;
+  }
+  if (framebuffer != NULL)
+  {
+    framebuffer->Delete();
+    delete framebuffer;
+  }
+  // The derived window is gone by now, and with it the mesh pools and buffers its uploads
+  // would end in, so the streamer discards them without running their callbacks
+  if (streamer != NULL)
+  {
+    streamer->Delete(false);
+  }
+  if (textureResidency != NULL)
+  {
+    textureResidency->Delete();
+    delete textureResidency;
+  }
+  if (streamer != NULL)
+  {
+    delete streamer;
+  }
+  renderer.Delete();
+  kdr::Profile::getProfiler().Delete();
   glfwDestroyWindow(glfwWindow);
 }
 
+kdr::Stream::Streamer* kdr::Window::getStreamer()
+{
+  // Created on first use, so windows that never stream don't run an I/O thread or own a staging buffer
+  if (streamer == NULL && glfwWindow != NULL)
+  {
+    streamer = new kdr::Stream::Streamer();
+  }
+  return streamer;
+}
+
+kdr::Stream::TextureResidency* kdr::Window::getTextureResidency()
+{
+  if (textureResidency == NULL && getStreamer() != NULL)
+  {
+    textureResidency = new kdr::Stream::TextureResidency(*streamer);
+  }
+  return textureResidency;
+}
+
 void kdr::Window::loop()
 {
-  while (!glfwWindowShouldClose(glfwWindow))
+  // Time spent before the loop, e.g. loading, must not be simulated as one long frame
+  lastTime = glfwGetTime();
+  accumulator = 0.;
+  if (isSimulationThreaded)
   {
+    // The first step must not run on the frame time left over from a previous loop
+    _updateDeltaTime();
+    _startSimulationThread();
+  }
+
+  const unsigned int lastFrame = frameIndex + frameLimit;
+  while (!glfwWindowShouldClose(glfwWindow) && (frameLimit == 0 || frameIndex < lastFrame))
+  {
+    kdr::Profile::getProfiler().beginFrame();
     _update();
+    if (textureResidency != NULL)
+    {
+      textureResidency->Update();
+    }
+    if (streamer != NULL)
+    {
+      streamer->Update();
+    }
     _render();
+    _limitFrameRate();
+    kdr::Profile::getProfiler().endFrame();
+  }
+
+  if (simulationThread.joinable())
+  {
+    _stopSimulationThread();
   }
 }
 
@@ -26,6 +103,66 @@ void kdr::Window::close()
   glfwSetWindowShouldClose(glfwWindow, GLFW_TRUE);
 }
 
+void kdr::Window::setIsVsyncOn(const bool isVsyncOn)
+{
+  this->isVsyncOn = isVsyncOn;
+  if (!isHeadless)
+  {
+    glfwSwapInterval(isVsyncOn ? 1 : 0);
+  }
+}
+
+void kdr::Window::readFrame(std::vector<unsigned char>& pixels)
+{
+  if (framebuffer != NULL)
+  {
+    framebuffer->ReadPixels(pixels);
+    return;
+  }
+
+  int frameWidth {0};
+  int frameHeight {0};
+  glfwGetFramebufferSize(glfwWindow, &frameWidth, &frameHeight);
+  pixels.resize((size_t)frameWidth * frameHeight * 4);
+
+  // The back buffer is undefined after a swap, so the presented frame is read instead
+  kdr::Graphics::getStateCache().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glReadBuffer(GL_FRONT);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, frameWidth, frameHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+bool kdr::Window::saveFrame(const std::string& path)
+{
+  std::vector<unsigned char> pixels;
+  readFrame(pixels);
+
+  int frameWidth {(int)width};
+  int frameHeight {(int)height};
+  if (framebuffer == NULL)
+  {
+    glfwGetFramebufferSize(glfwWindow, &frameWidth, &frameHeight);
+  }
+
+  const std::string header = "P6\n" + std::to_string(frameWidth) + " " + std::to_string(frameHeight) + "\n255\n";
+  std::vector<unsigned char> image(header.begin(), header.end());
+  image.reserve(header.size() + (size_t)frameWidth * frameHeight * 3);
+
+  // PPM rows go top to bottom and carry no alpha
+  for (int y = frameHeight - 1; y >= 0; y--)
+  {
+    const unsigned char* row = pixels.data() + (size_t)y * frameWidth * 4;
+    for (int x = 0; x < frameWidth; x++)
+    {
+      image.push_back(row[x * 4 + 0]);
+      image.push_back(row[x * 4 + 1]);
+      image.push_back(row[x * 4 + 2]);
+    }
+  }
+  return kdr::File::writeContents(path.c_str(), image.data(), image.size());
+}
+
 void kdr::Window::maximize()
 {
   GLFWmonitor* monitor = glfwGetPrimaryMonitor();
@@ -60,10 +197,22 @@ void kdr::Window::unmaximize()
 
 const bool kdr::Window::_initializeGlfw()
 {
+#ifdef GLFW_PLATFORM_NULL
+  // Without a display server only GLFW's null platform can host an (OSMesa) context
+  if (isHeadless && getenv("DISPLAY") == NULL && getenv("WAYLAND_DISPLAY") == NULL)
+  {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+  }
+#endif
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_DEPTH_BITS, 24);
+  if (isHeadless)
+  {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  }
   return true;
 }
 
@@ -80,23 +229,59 @@ const bool kdr::Window::_initializeGlew()
   return true;
 }
 
+const bool kdr::Window::_createGlfwWindow()
+{
+  const int contextAPIs[] = {GLFW_NATIVE_CONTEXT_API, GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API};
+  const int contextAPICount = isHeadless ? 3 : 1;
+
+  for (int i = 0; i < contextAPICount && glfwWindow == NULL; i++)
+  {
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextAPIs[i]);
+    glfwWindow = glfwCreateWindow(
+      width,
+      height,
+      title.c_str(),
+      NULL,
+      NULL
+    );
+  }
+  return glfwWindow != NULL;
+}
+
 void kdr::Window::_initializeOpenGLSettings()
 {
   glPointSize(5.f);
-  glfwSetFramebufferSizeCallback(glfwWindow, framebufferSizeCallback);
+  if (isHeadless)
+  {
+    framebuffer = new kdr::Graphics::Framebuffer(width, height);
+    framebuffer->Bind();
+  }
+  else
+  {
+    glfwSetFramebufferSizeCallback(glfwWindow, framebufferSizeCallback);
+    setIsVsyncOn(isVsyncOn);
+  }
+
+  cameraBuffer = new kdr::Graphics::UniformBuffer(
+    sizeof(kdr::CameraBlock),
+    kdr::Graphics::cameraBlockBinding
+  );
+  // Programs still declaring a plain cameraMatrix uniform get it whenever the renderer binds them
+  renderer.setProgramCallback([this](GLuint shaderID)
+  {
+    if (boundCamera == NULL) return;
+    const GLint location = kdr::Graphics::getCameraMatrixLocation(shaderID);
+    if (location < 0) return;
+
+    const kdr::Space::Mat4 matrix = boundCamera->getMatrix();
+    glUniformMatrix4fv(location, 1, GL_FALSE, &matrix[0][0]);
+  });
 }
 
 void kdr::Window::_initialize()
 {
   _initializeGlfw();
-  glfwWindow = glfwCreateWindow(
-    width,
-    height,
-    title.c_str(),
-    NULL,
-    NULL
-  );
-  if (glfwWindow == NULL)
+  if (!_createGlfwWindow())
   {
     std::cerr << "Failed to create a GLFW window!\n";
     glfwTerminate();
@@ -111,31 +296,196 @@ void kdr::Window::_initialize()
 
 void kdr::Window::_updateDeltaTime()
 {
-  float currentTime = (float)glfwGetTime();
-  deltaTime = currentTime - lastTime;
+  const double currentTime = glfwGetTime();
+  frameTime = (float)(currentTime - lastTime);
   lastTime = currentTime;
+  deltaTime = fixedTimeStep > 0. ? (float)fixedTimeStep : frameTime;
+}
+
+void kdr::Window::_updateSimulation()
+{
+  if (fixedTimeStep <= 0.)
+  {
+    KDR_PROFILE_SCOPE("update");
+    simulationAlpha = 1.f;
+    update();
+    return;
+  }
+
+  accumulator += frameTime;
+
+  unsigned int steps {0};
+  while (accumulator >= fixedTimeStep && steps < maxStepsPerFrame)
+  {
+    KDR_PROFILE_SCOPE("update");
+    update();
+    accumulator -= fixedTimeStep;
+    steps++;
+  }
+
+  // Dropping the backlog instead of spiralling when the simulation can't keep up
+  if (accumulator >= fixedTimeStep)
+  {
+    accumulator = fmod(accumulator, fixedTimeStep);
+  }
+  simulationAlpha = (float)(accumulator / fixedTimeStep);
+}
+
+void kdr::Window::_startSimulationThread()
+{
+  snapshotWriteIndex = 0;
+  snapshotReadIndex = 1;
+  isSimulationStopping = false;
+  isSimulationRequested = true;
+  simulationThread = std::thread(&kdr::Window::_runSimulationThread, this);
+}
+
+void kdr::Window::_stopSimulationThread()
+{
+  {
+    std::unique_lock<std::mutex> lock(simulationMutex);
+    simulationCondition.wait(lock, [this]() { return !isSimulationRequested; });
+    isSimulationStopping = true;
+  }
+  simulationCondition.notify_all();
+  simulationThread.join();
+
+  snapshotWriteIndex = 0;
+  snapshotReadIndex = 0;
+}
+
+void kdr::Window::_runSimulationThread()
+{
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(simulationMutex);
+      simulationCondition.wait(lock, [this]() { return isSimulationRequested || isSimulationStopping; });
+      if (!isSimulationRequested) return;
+    }
+
+    _updateSimulation();
+
+    {
+      std::lock_guard<std::mutex> lock(simulationMutex);
+      isSimulationRequested = false;
+    }
+    simulationCondition.notify_all();
+  }
+}
+
+void kdr::Window::_requestSimulation()
+{
+  {
+    std::lock_guard<std::mutex> lock(simulationMutex);
+    isSimulationRequested = true;
+  }
+  simulationCondition.notify_all();
+}
+
+void kdr::Window::_waitForSimulation()
+{
+  KDR_PROFILE_SCOPE("Window::_waitForSimulation");
+  std::unique_lock<std::mutex> lock(simulationMutex);
+  simulationCondition.wait(lock, [this]() { return !isSimulationRequested; });
+}
+
+void kdr::Window::_limitFrameRate()
+{
+  if (frameRateLimit <= 0.) return;
+
+  KDR_PROFILE_SCOPE("Window::_limitFrameRate");
+  const double frameEnd = lastTime + 1. / frameRateLimit;
+
+  // Sleeping coarsely, then yielding through the last millisecond the scheduler can't hit reliably
+  const double remaining = frameEnd - glfwGetTime();
+  if (remaining > 0.002)
+  {
+    std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.001));
+  }
+  while (glfwGetTime() < frameEnd)
+  {
+    std::this_thread::yield();
+  }
 }
 
 void kdr::Window::_updateCamera()
 {
-  if (boundShaderID == 0) return;
+  KDR_PROFILE_SCOPE("Window::_updateCamera");
   if (boundCamera == NULL) return;
 
   boundCamera->updateMatrix();
-  boundCamera->applyMatrix(boundShaderID, "cameraMatrix");
+
+  // One upload serves every program that declares the shared camera block
+  const kdr::CameraBlock block = boundCamera->getBlock();
+  cameraBuffer->Update(&block, sizeof(block));
+
+  // Shaders still declaring a plain cameraMatrix uniform get it set directly
+  if (boundShader != NULL && boundShader->getUniformLocation("cameraMatrix") >= 0)
+  {
+    boundShader->Use();
+    boundCamera->applyMatrix(*boundShader, "cameraMatrix");
+  }
 }
 
 void kdr::Window::_update()
 {
+  KDR_PROFILE_SCOPE("Window::_update");
   glfwPollEvents();
-  update();
+
+  if (!simulationThread.joinable())
+  {
+    handleInput();
+    _updateDeltaTime();
+    _updateSimulation();
+    interpolationAlpha = simulationAlpha;
+    _updateCamera();
+    return;
+  }
+
+  // Taking the finished step for rendering and starting the next one behind it
+  _waitForSimulation();
+  handleInput();
   _updateDeltaTime();
+  interpolationAlpha = simulationAlpha;
+  snapshotReadIndex = snapshotWriteIndex;
+  snapshotWriteIndex = 1 - snapshotWriteIndex;
+  _requestSimulation();
+
   _updateCamera();
 }
 
 void kdr::Window::_render()
 {
-  glClear(GL_COLOR_BUFFER_BIT);
-  render();
-  glfwSwapBuffers(glfwWindow);
+  KDR_PROFILE_SCOPE("Window::_render");
+  if (framebuffer != NULL)
+  {
+    framebuffer->Bind();
+  }
+
+  {
+    KDR_PROFILE_GPU_SCOPE("Frame");
+
+    // Depth writes are masked off by some passes, and a masked buffer would not be cleared
+    kdr::Graphics::GLStateCache& stateCache = kdr::Graphics::getStateCache();
+    stateCache.setDepthMask(true);
+    stateCache.setDepthFunc(GL_LESS);
+    stateCache.setDepthTest(isDepthTestOn);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    {
+      KDR_PROFILE_SCOPE("render");
+      render();
+    }
+    renderer.flush();
+  }
+
+  if (isHeadless)
+  {
+    glFlush();
+  }
+  else
+  {
+    glfwSwapBuffers(glfwWindow);
+  }
+  frameIndex++;
 }
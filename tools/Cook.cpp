@@ -0,0 +1,70 @@
+#include <GL/glew.h>
+#include <iostream>
+#include <string>
+#include <string.h>
+
+#include "Kedarium/Import.hpp"
+#include "Kedarium/MeshFile.hpp"
+
+int main(int argc, char** argv)
+{
+  const char*  inputPath  {NULL};
+  const char*  outputPath {NULL};
+  unsigned int levelCount {4};
+  float        reduction  {0.5f};
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc)
+    {
+      levelCount = std::stoul(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--reduction") == 0 && i + 1 < argc)
+    {
+      reduction = std::stof(argv[++i]);
+    }
+    else if (inputPath == NULL)
+    {
+      inputPath = argv[i];
+    }
+    else if (outputPath == NULL)
+    {
+      outputPath = argv[i];
+    }
+    else
+    {
+      inputPath = NULL;
+      break;
+    }
+  }
+  if (inputPath == NULL || outputPath == NULL || levelCount == 0 || reduction <= 0.f || reduction >= 1.f)
+  {
+    std::cerr << "Usage: kedarium_cook input.obj|.gltf|.glb output.kmesh [--levels N] [--reduction 0..1]\n";
+    return 1;
+  }
+
+  kdr::Import::Model model;
+  if (!kdr::Import::loadModel(inputPath, model)) return 1;
+
+  if (!kdr::Mesh::writeCookedMesh(
+    outputPath,
+    model.vertices.data(),
+    (GLuint)model.vertices.size(),
+    sizeof(kdr::Import::Vertex),
+    kdr::Import::getVertexAttributes(),
+    model.indices.data(),
+    (GLuint)model.indices.size(),
+    levelCount,
+    reduction
+  )) return 1;
+
+  kdr::Mesh::CookedMesh cooked(outputPath);
+  if (!cooked.getIsOpen()) return 1;
+
+  for (unsigned int i = 0; i < cooked.getLevelCount(); i++)
+  {
+    const kdr::Mesh::CookedLevel& level = cooked.getLevel(i);
+    std::cerr << "Level " << i << ": " << level.vertexCount << " vertices, " << level.indexCount / 3 << " triangles, error " << level.error << '\n';
+  }
+  return 0;
+}